@@ -0,0 +1,147 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include "BaselineCompare.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+static double to_nanoseconds(double value, std::string_view unit) {
+    if (unit == "us") {
+        return value * 1e3;
+    }
+    if (unit == "ms") {
+        return value * 1e6;
+    }
+    if (unit == "s") {
+        return value * 1e9;
+    }
+    return value;
+}
+
+static double to_nanoseconds(double value, benchmark::TimeUnit unit) {
+    return to_nanoseconds(value, benchmark::GetTimeUnitString(unit));
+}
+
+// One line of a CSV report. Benchmark names are quoted with inner quotes doubled, the other fields are plain.
+static std::vector<std::string> split_csv_line(std::string_view line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); i++) {
+        const char c = line[i];
+        if (quoted) {
+            if (c != '"') {
+                fields.back() += c;
+            } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                i++;
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+static std::size_t column_index(const std::vector<std::string>& header, std::string_view column,
+                                const std::filesystem::path& path) {
+    const auto it = std::ranges::find(header, column);
+    if (it == header.end()) {
+        throw std::runtime_error(std::format("{} has no \"{}\" column", path.string(), column));
+    }
+    return static_cast<std::size_t>(it - header.begin());
+}
+
+BenchTimes load_baseline(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error(std::format("Could not open baseline {}", path.string()));
+    }
+
+    // The machine context Google Benchmark writes into the file comes before the header
+    std::string line;
+    while (std::getline(file, line) && !line.starts_with("name,")) {
+    }
+    if (!file) {
+        throw std::runtime_error(std::format(
+            "{} is not a Google Benchmark CSV report, save it with --benchmark_out_format=csv", path.string()));
+    }
+    const auto header = split_csv_line(line);
+    const auto name_column = column_index(header, "name", path);
+    const auto time_column = column_index(header, "real_time", path);
+    const auto unit_column = column_index(header, "time_unit", path);
+    const auto error_column = column_index(header, "error_occurred", path);
+
+    BenchTimes times;
+    while (std::getline(file, line)) {
+        const auto fields = split_csv_line(line);
+        if (fields.size() <= std::max({name_column, time_column, unit_column, error_column})
+            || fields[error_column] == "true" || fields[name_column].empty()) {
+            continue;
+        }
+        times[fields[name_column]] =
+            to_nanoseconds(std::strtod(fields[time_column].c_str(), nullptr), fields[unit_column]);
+    }
+    return times;
+}
+
+void RecordingReporter::ReportRuns(const std::vector<Run>& reports) {
+    ConsoleReporter::ReportRuns(reports);
+    for (const auto& run : reports) {
+        if (!run.error_occurred && !run.report_big_o && !run.report_rms) {
+            m_times[run.benchmark_name()] = to_nanoseconds(run.GetAdjustedRealTime(), run.time_unit);
+        }
+    }
+}
+
+static std::string format_time(double ns) {
+    if (ns >= 1e9) {
+        return std::format("{:.2f} s", ns / 1e9);
+    }
+    if (ns >= 1e6) {
+        return std::format("{:.2f} ms", ns / 1e6);
+    }
+    if (ns >= 1e3) {
+        return std::format("{:.2f} us", ns / 1e3);
+    }
+    return std::format("{:.1f} ns", ns);
+}
+
+int print_comparison(const BenchTimes& baseline, const BenchTimes& current, double threshold) {
+    std::size_t width = 9;
+    for (const auto& [name, _] : current) {
+        width = std::max(width, name.size());
+    }
+
+    std::printf("\n%-*s %14s %14s %9s\n", static_cast<int>(width), "Benchmark", "Baseline", "Current", "Change");
+    int regressions = 0;
+    for (const auto& [name, time] : current) {
+        const auto it = baseline.find(name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::printf("%-*s %14s %14s %9s\n", static_cast<int>(width), name.c_str(), "-",
+                        format_time(time).c_str(), "new");
+            continue;
+        }
+        const double change = time / it->second - 1.0;
+        const bool slower = change > threshold;
+        regressions += slower;
+        std::printf("%-*s %14s %14s %+8.1f%%%s\n", static_cast<int>(width), name.c_str(),
+                    format_time(it->second).c_str(), format_time(time).c_str(), change * 100.0,
+                    slower ? "  REGRESSION" : "");
+    }
+    std::printf("\n%d of %zu benchmarks slower than the baseline by more than %.1f%%\n", regressions, current.size(),
+                threshold * 100.0);
+    return regressions;
+}
@@ -0,0 +1,34 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_BENCH_BASELINECOMPARE_HPP
+#define SWARM_BENCH_BASELINECOMPARE_HPP
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+#include <string>
+
+// Real time per iteration in nanoseconds, keyed by the full benchmark name (including aggregates like "_mean")
+using BenchTimes = std::map<std::string, double>;
+
+// Reads the runs of a file written with --benchmark_out=<file> --benchmark_out_format=csv
+BenchTimes load_baseline(const std::filesystem::path& path);
+
+// Console output as usual, but remembers every successful run for the comparison
+class RecordingReporter : public benchmark::ConsoleReporter {
+public:
+    RecordingReporter() : ConsoleReporter(OO_Tabular) {}
+    void ReportRuns(const std::vector<Run>& reports) override;
+    const BenchTimes& times() const { return m_times; }
+
+private:
+    BenchTimes m_times;
+};
+
+// Prints baseline vs. current for every benchmark present in both, returns the number slower than threshold
+// (a fraction, 0.05 = 5%)
+int print_comparison(const BenchTimes& baseline, const BenchTimes& current, double threshold);
+
+#endif // SWARM_BENCH_BASELINECOMPARE_HPP
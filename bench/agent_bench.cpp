@@ -0,0 +1,205 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <swarm/Agent.hpp>
+#include <swarm/DenseKernels.hpp>
+#include <swarm/FrozenPolicy.hpp>
+#include <swarm/PolicyServer.hpp>
+#include <swarm/QuantizedPolicy.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+static void set_samples(benchmark::State& state, long batch) {
+    state.counters["samples/s"] =
+        benchmark::Counter(static_cast<double>(state.iterations() * batch), benchmark::Counter::kIsRate);
+}
+
+// Rollout-time sampling, range(0) = batch (num_envs)
+static void BM_AgentGetActionAndValue(benchmark::State& state) {
+    const long batch = state.range(0);
+    SimpleMovingEnvironment env;
+    Agent agent{&env};
+    torch::NoGradGuard nograd;
+    auto obs = torch::rand({batch, static_cast<long>(env.get_observation_size())});
+    for (auto _ : state) {
+        auto res = agent.get_action_and_value(obs);
+        benchmark::DoNotOptimize(res.value.data_ptr<float>());
+    }
+    set_samples(state, batch);
+}
+BENCHMARK(BM_AgentGetActionAndValue)->RangeMultiplier(4)->Range(1, 4096);
+
+static void BM_AgentActGreedy(benchmark::State& state) {
+    const long batch = state.range(0);
+    SimpleMovingEnvironment env;
+    Agent agent{&env};
+    torch::NoGradGuard nograd;
+    auto obs = torch::rand({batch, static_cast<long>(env.get_observation_size())});
+    for (auto _ : state) {
+        auto actions = agent.act_greedy(obs);
+        benchmark::DoNotOptimize(actions.data_ptr<long>());
+    }
+    set_samples(state, batch);
+}
+BENCHMARK(BM_AgentActGreedy)->RangeMultiplier(4)->Range(1, 4096);
+
+// The libtorch-free path train() takes with fused_inference
+static void BM_FusedActorCriticAct(benchmark::State& state) {
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    SimpleMovingEnvironment env;
+    Agent agent{&env};
+    auto kernel = agent.make_fused();
+    std::vector<float> obs(batch * kernel.get_observation_size(), 0.5f);
+    std::vector<std::int64_t> actions(batch);
+    std::vector<float> log_probs(batch);
+    std::vector<float> values(batch);
+    for (auto _ : state) {
+        kernel.act(obs.data(), batch, actions.data(), log_probs.data(), values.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    set_samples(state, state.range(0));
+    state.SetLabel(dense_kernel_isa());
+}
+BENCHMARK(BM_FusedActorCriticAct)->RangeMultiplier(4)->Range(1, 4096);
+
+// A freshly initialized agent, the frozen and quantized benchmarks run copies of the same actor
+static const Agent& deployed_agent() {
+    static SimpleMovingEnvironment env;
+    static const Agent agent{&env};
+    return agent;
+}
+
+// Exports the agent once, the file format does not care whether it was trained
+static std::filesystem::path frozen_policy_path() {
+    static const auto path = [] {
+        auto file = std::filesystem::temp_directory_path() / "swarm_bench.policy";
+        deployed_agent().export_frozen(file);
+        return file;
+    }();
+    return path;
+}
+
+// Deployment startup: mmap, validate and be ready for act_greedy
+static void BM_FrozenPolicyLoad(benchmark::State& state) {
+    const auto path = frozen_policy_path();
+    for (auto _ : state) {
+        FrozenPolicy policy(path);
+        benchmark::DoNotOptimize(policy.get_num_layers());
+    }
+}
+BENCHMARK(BM_FrozenPolicyLoad)->Unit(benchmark::kMicrosecond);
+
+static void BM_FrozenPolicyActGreedy(benchmark::State& state) {
+    FrozenPolicy policy(frozen_policy_path());
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    std::vector<float> obs(batch * policy.get_observation_size(), 0.5f);
+    std::vector<std::int64_t> actions(batch);
+    for (auto _ : state) {
+        policy.act_greedy(obs.data(), batch, actions.data());
+        benchmark::DoNotOptimize(actions.data());
+    }
+    set_samples(state, state.range(0));
+    state.SetLabel(dense_kernel_isa());
+}
+BENCHMARK(BM_FrozenPolicyActGreedy)->RangeMultiplier(4)->Range(1, 4096);
+
+// What a deployment would record: 64 environments driven greedily by the frozen policy for 256 steps
+static const std::vector<float>& recorded_observations() {
+    static const auto recorded = [] {
+        FrozenPolicy policy(frozen_policy_path());
+        VectorizedMovingEnvironment env(64);
+        env.seed(0);
+        std::vector<float> obs(64 * env.get_observation_size());
+        std::vector<float> rewards(64);
+        std::vector<float> dones(64);
+        std::vector<std::int64_t> actions(64);
+        std::vector<float> observations;
+        env.reset_into(obs);
+        for (int step = 0; step < 256; step++) {
+            observations.insert(observations.end(), obs.begin(), obs.end());
+            policy.act_greedy(obs.data(), 64, actions.data());
+            env.step_into({actions, obs, rewards, dones});
+        }
+        return observations;
+    }();
+    return recorded;
+}
+
+// BM_FrozenPolicyActGreedy on the int8 actor, calibrated on the first half of the recording and run on the second.
+// agreement is the share of recorded observations both pick the same action for.
+static void BM_QuantizedPolicyActGreedy(benchmark::State& state) {
+    const auto& recorded = recorded_observations();
+    const auto half = std::span(recorded).first(recorded.size() / 2);
+    const auto held_out = std::span(recorded).last(recorded.size() / 2);
+    auto policy = deployed_agent().quantize_actor(half);
+    FrozenPolicy reference(frozen_policy_path());
+    const auto report = compare_greedy(reference, policy, held_out);
+
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    const auto obs = held_out.first(batch * policy.get_observation_size());
+    std::vector<std::int64_t> actions(batch);
+    for (auto _ : state) {
+        policy.act_greedy(obs.data(), batch, actions.data());
+        benchmark::DoNotOptimize(actions.data());
+    }
+    set_samples(state, state.range(0));
+    state.counters["agreement"] = report.agreement();
+    state.counters["weight_bytes"] = static_cast<double>(policy.get_weight_bytes());
+    state.SetLabel(int8_kernel_name());
+}
+BENCHMARK(BM_QuantizedPolicyActGreedy)->RangeMultiplier(4)->Range(1, 4096);
+
+// Controllers asking for one action each, every benchmark thread is a client of one shared server. Compare the
+// throughput with BM_AgentActGreedy/1 and BM_FrozenPolicyActGreedy/1, what each controller pays on its own.
+static void run_policy_server(benchmark::State& state, const std::function<PolicyServer::BatchPolicy()>& make_policy) {
+    static std::unique_ptr<PolicyServer> server;
+    if (state.thread_index() == 0) {
+        server = std::make_unique<PolicyServer>(
+            make_policy(), 5, PolicyServerOptions{.max_batch_size = 64, .max_delay = std::chrono::microseconds{200}});
+    }
+    const std::vector<float> obs(5, 0.5f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(server->submit(obs).get());
+    }
+    state.counters["requests/s"] =
+        benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    if (state.thread_index() == 0) {
+        const auto stats = server->take_stats();
+        server.reset();
+        state.counters["p50_us"] = stats.p50_latency_us;
+        state.counters["p99_us"] = stats.p99_latency_us;
+        state.counters["mean_batch"] = stats.mean_batch_size();
+    }
+}
+
+static void BM_PolicyServerAgent(benchmark::State& state) {
+    static std::unique_ptr<Agent> agent;
+    run_policy_server(state, [] {
+        SimpleMovingEnvironment env;
+        agent = std::make_unique<Agent>(&env);
+        return [](const float* observations, std::size_t batch, std::int64_t* actions) {
+            torch::NoGradGuard nograd;
+            const auto obs = torch::from_blob(const_cast<float*>(observations), {static_cast<long>(batch), 5});
+            const auto result = agent->act_greedy(obs).contiguous();
+            std::memcpy(actions, result.data_ptr<int64_t>(), batch * sizeof(std::int64_t));
+        };
+    });
+}
+BENCHMARK(BM_PolicyServerAgent)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_PolicyServerFrozen(benchmark::State& state) {
+    run_policy_server(state, [] {
+        // Only the batcher thread runs the policy, one instance is enough
+        auto policy = std::make_shared<FrozenPolicy>(frozen_policy_path());
+        return [policy](const float* observations, std::size_t batch, std::int64_t* actions) {
+            policy->act_greedy(observations, batch, actions);
+        };
+    });
+}
+BENCHMARK(BM_PolicyServerFrozen)->ThreadRange(1, 64)->UseRealTime();
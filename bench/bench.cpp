@@ -2,31 +2,57 @@
 // Created by chris on 17.10.24.
 //
 
+#include "BaselineCompare.hpp"
+
 #include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
 #include <vector>
-#include <numeric>
-
-// A function to sum elements in a vector
-int sumVector(const std::vector<int>& v) {
-    return std::accumulate(v.begin(), v.end(), 0);
-}
 
-// Benchmark for summing a vector
-static void BM_SumVector(benchmark::State& state) {
-    // Create a vector with the size provided by the benchmark state
-    std::vector<int> v(state.range(0), 1); // Vector of 1's of size range(0)
+// The cases live next to the code they measure: env_bench.cpp, agent_bench.cpp, training_bench.cpp,
+// spatial_bench.cpp and trajectory_bench.cpp.
+//
+// Save a baseline:    ./bench --benchmark_out=baseline.csv --benchmark_out_format=csv
+// Compare against it: ./bench --baseline=baseline.csv [--regression_threshold=0.05]
+// Exits with 1 when any benchmark got slower than the threshold, so CI can gate on it.
+int main(int argc, char** argv) {
+    std::string baseline_path;
+    double threshold = 0.05;
 
-    // Loop over each state iteration (measures performance over multiple runs)
-    for (auto _ : state) {
-        benchmark::DoNotOptimize(sumVector(v)); // Perform the sum and prevent optimization
+    // Strip our own flags before Google Benchmark sees them
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        if (std::strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline_path = argv[i] + 11;
+        } else if (std::strncmp(argv[i], "--regression_threshold=", 23) == 0) {
+            threshold = std::strtod(argv[i] + 23, nullptr);
+        } else {
+            args.push_back(argv[i]);
+        }
     }
+    int bench_argc = static_cast<int>(args.size());
 
-    // Set the number of processed elements for more meaningful stats
-    state.SetItemsProcessed(state.iterations() * state.range(0));
-}
+    benchmark::Initialize(&bench_argc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(bench_argc, args.data())) {
+        return 1;
+    }
 
-// Register the function as a benchmark and set a range of input sizes
-BENCHMARK(BM_SumVector)->Range(8, 8<<10); // Benchmark on input sizes from 8 to 8192
+    if (baseline_path.empty()) {
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+        return 0;
+    }
 
-// Main function to run the benchmarks
-BENCHMARK_MAIN();
+    BenchTimes baseline;
+    try {
+        baseline = load_baseline(baseline_path);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    RecordingReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+    return print_comparison(baseline, reporter.times(), threshold) > 0 ? 1 : 0;
+}
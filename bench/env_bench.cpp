@@ -0,0 +1,198 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <swarm/ParallelMultiEnv.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/SwarmEnvironment.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+
+static void set_env_steps(benchmark::State& state, long envs_per_iteration) {
+    state.counters["env_steps/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * envs_per_iteration), benchmark::Counter::kIsRate);
+}
+
+// Fixed random actions, sampling them is not what we measure
+static torch::Tensor random_actions(const Environment& env, long num_envs, long count) {
+    torch::manual_seed(0);
+    return torch::randint(static_cast<long>(env.get_action_space_size()), {count, num_envs}, torch::kLong);
+}
+
+static void BM_SimpleMovingEnvironmentStep(benchmark::State& state) {
+    SimpleMovingEnvironment env;
+    env.seed(0);
+    env.reset();
+    const auto actions = random_actions(env, 1, 1024);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = env.step(actions[i++ % 1024][0]);
+        if (res.done.item<float>() != 0.0f) {
+            env.reset();
+        }
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, 1);
+}
+BENCHMARK(BM_SimpleMovingEnvironmentStep);
+
+static void BM_SimpleMovingEnvironmentReset(benchmark::State& state) {
+    SimpleMovingEnvironment env;
+    env.seed(0);
+    for (auto _ : state) {
+        auto obs = env.reset();
+        benchmark::DoNotOptimize(obs.data_ptr<float>());
+    }
+    state.counters["resets/s"] =
+        benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SimpleMovingEnvironmentReset);
+
+// range(0) = num_envs, MultiEnv steps its envs one after the other through torch scalars
+static void BM_MultiEnvStep(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    MultiEnv envs(std::make_unique<SimpleMovingEnvironment>(), num_envs);
+    envs.seed(0);
+    envs.reset();
+    const auto actions = random_actions(envs, num_envs, 64);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = envs.step(actions[i++ % 64]);
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, num_envs);
+}
+BENCHMARK(BM_MultiEnvStep)->RangeMultiplier(4)->Range(1, 256);
+
+// Buffers that stay alive across steps, like the rows of a rollout that step_into() writes into
+struct StepIntoBuffers {
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<float> dones;
+
+    explicit StepIntoBuffers(const Environment& env)
+        : observations(env.get_num_envs() * env.get_observation_size())
+        , rewards(env.get_num_envs())
+        , dones(env.get_num_envs()) {}
+
+    Environment::StepBuffers with(const torch::Tensor& actions) {
+        return {{actions.data_ptr<int64_t>(), rewards.size()}, observations, rewards, dones};
+    }
+};
+
+// range(0) = num_envs, BM_MultiEnvStep without a tensor per env and step
+static void BM_MultiEnvStepInto(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    MultiEnv envs(std::make_unique<SimpleMovingEnvironment>(), num_envs);
+    envs.seed(0);
+    envs.reset();
+    const auto actions = random_actions(envs, num_envs, 64);
+    StepIntoBuffers buffers(envs);
+    long i = 0;
+    for (auto _ : state) {
+        envs.step_into(buffers.with(actions[i++ % 64]));
+        benchmark::DoNotOptimize(buffers.observations.data());
+    }
+    set_env_steps(state, num_envs);
+}
+BENCHMARK(BM_MultiEnvStepInto)->RangeMultiplier(4)->Range(1, 256);
+
+// range(0) = num_envs, range(1) = worker threads
+static void BM_ParallelMultiEnvStep(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    ParallelMultiEnv envs(std::make_unique<SimpleMovingEnvironment>(), num_envs, state.range(1));
+    envs.seed(0);
+    envs.reset();
+    const auto actions = random_actions(envs, num_envs, 64);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = envs.step(actions[i++ % 64]);
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, num_envs);
+}
+BENCHMARK(BM_ParallelMultiEnvStep)->ArgsProduct({{16, 256}, {2, 4, 8}})->UseRealTime();
+
+static void BM_VectorizedMovingEnvironmentStep(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    VectorizedMovingEnvironment envs(num_envs);
+    envs.seed(0);
+    envs.reset();
+    const auto actions = random_actions(envs, num_envs, 64);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = envs.step(actions[i++ % 64]);
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, num_envs);
+}
+BENCHMARK(BM_VectorizedMovingEnvironmentStep)->RangeMultiplier(4)->Range(16, 4096);
+
+static void BM_VectorizedMovingEnvironmentStepInto(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    VectorizedMovingEnvironment envs(num_envs);
+    envs.seed(0);
+    envs.reset();
+    const auto actions = random_actions(envs, num_envs, 64);
+    StepIntoBuffers buffers(envs);
+    long i = 0;
+    for (auto _ : state) {
+        envs.step_into(buffers.with(actions[i++ % 64]));
+        benchmark::DoNotOptimize(buffers.observations.data());
+    }
+    set_env_steps(state, num_envs);
+}
+BENCHMARK(BM_VectorizedMovingEnvironmentStepInto)->RangeMultiplier(4)->Range(16, 4096);
+
+// range(0) = agents in the world, range(1) = worker threads
+static void BM_SwarmEnvironmentStep(benchmark::State& state) {
+    const long num_agents = state.range(0);
+    SwarmEnvironment env(num_agents, state.range(1));
+    env.seed(0);
+    env.reset();
+    const auto actions = random_actions(env, num_agents, 16);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = env.step(actions[i++ % 16]);
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, num_agents);
+}
+BENCHMARK(BM_SwarmEnvironmentStep)->ArgsProduct({{1024, 16384, 65536}, {1, 4, 8}})->UseRealTime();
+
+// range(0) = agents, range(1) = observed neighbors, on 8 workers
+static void BM_SwarmEnvironmentNeighborStep(benchmark::State& state) {
+    const long num_agents = state.range(0);
+    SwarmEnvironment env(num_agents, 8, state.range(1));
+    env.seed(0);
+    env.reset();
+    const auto actions = random_actions(env, num_agents, 16);
+    long i = 0;
+    for (auto _ : state) {
+        auto res = env.step(actions[i++ % 16]);
+        benchmark::DoNotOptimize(res.observations.data_ptr<float>());
+    }
+    set_env_steps(state, num_agents);
+}
+BENCHMARK(BM_SwarmEnvironmentNeighborStep)->ArgsProduct({{1000, 10000, 100000}, {4, 8}})->UseRealTime();
+
+// range(0) = agents, the per-frame cost of the viewer on top of the step: snapshot the swarm and rebuild its vertices
+static void BM_SwarmSnapshotAndRender(benchmark::State& state) {
+    const long num_agents = state.range(0);
+    SwarmEnvironment env(num_agents, 1);
+    env.seed(0);
+    env.reset();
+    SwarmSnapshot snapshot;
+    SwarmRenderer renderer;
+    for (auto _ : state) {
+        snapshot.clear();
+        env.write_snapshot(snapshot);
+        renderer.update(snapshot);
+        benchmark::DoNotOptimize(renderer.get_vertex_count());
+    }
+    state.counters["agents/s"] =
+        benchmark::Counter(static_cast<double>(state.iterations() * num_agents), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SwarmSnapshotAndRender)->RangeMultiplier(10)->Range(1000, 100000);
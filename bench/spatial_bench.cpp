@@ -0,0 +1,115 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <swarm/SpatialHashGrid.hpp>
+#include <random>
+#include <vector>
+
+// Uniform agents over the SimpleMovingEnvironment world, the density grows with the count
+struct Points {
+    std::vector<float> x;
+    std::vector<float> y;
+};
+
+static Points random_points(long n) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> x_dist(0.0f, 1920.0f);
+    std::uniform_real_distribution<float> y_dist(0.0f, 1080.0f);
+    Points points{std::vector<float>(n), std::vector<float>(n)};
+    for (long i = 0; i < n; i++) {
+        points.x[i] = x_dist(rng);
+        points.y[i] = y_dist(rng);
+    }
+    return points;
+}
+
+static void set_agents(benchmark::State& state, long agents_per_iteration) {
+    state.counters["agents/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * agents_per_iteration), benchmark::Counter::kIsRate);
+}
+
+// range(0) = agents
+static void BM_SpatialHashGridRebuild(benchmark::State& state) {
+    const long n = state.range(0);
+    auto points = random_points(n);
+    SpatialHashGrid grid(1920.0f, 1080.0f, 100.0f);
+    for (auto _ : state) {
+        grid.rebuild(points.x, points.y);
+        benchmark::ClobberMemory();
+    }
+    set_agents(state, n);
+}
+BENCHMARK(BM_SpatialHashGridRebuild)->Arg(1000)->Arg(3000)->Arg(10000)->Arg(30000)->Arg(100000);
+
+// range(0) = agents, range(1) = k. Every agent asks for its k nearest within 100 px, what one observation step costs.
+static void BM_SpatialHashGridKnn(benchmark::State& state) {
+    const long n = state.range(0);
+    const auto k = static_cast<std::size_t>(state.range(1));
+    auto points = random_points(n);
+    SpatialHashGrid grid(1920.0f, 1080.0f, 100.0f);
+    grid.rebuild(points.x, points.y);
+    std::vector<std::uint32_t> index(k);
+    std::vector<float> dist2(k);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (long i = 0; i < n; i++) {
+            found += grid.query_knn(points.x[i], points.y[i], 100.0f, index, dist2, static_cast<std::uint32_t>(i));
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    set_agents(state, n);
+    state.SetLabel(SpatialHashGrid::simd_isa());
+}
+BENCHMARK(BM_SpatialHashGridKnn)->ArgsProduct({{1000, 3000, 10000, 30000, 100000}, {4, 16}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_SpatialHashGridRadius(benchmark::State& state) {
+    const long n = state.range(0);
+    auto points = random_points(n);
+    SpatialHashGrid grid(1920.0f, 1080.0f, 100.0f);
+    grid.rebuild(points.x, points.y);
+    std::vector<std::uint32_t> neighbors;
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (long i = 0; i < n; i++) {
+            neighbors.clear();
+            grid.query_radius(points.x[i], points.y[i], 50.0f, neighbors, static_cast<std::uint32_t>(i));
+            found += neighbors.size();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    set_agents(state, n);
+    state.SetLabel(SpatialHashGrid::simd_isa());
+}
+BENCHMARK(BM_SpatialHashGridRadius)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// The O(N^2) scan the grid replaces, only up to where it is still bearable
+static void BM_BruteForceKnn(benchmark::State& state) {
+    const long n = state.range(0);
+    constexpr std::size_t k = 4;
+    auto points = random_points(n);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (long i = 0; i < n; i++) {
+            float best[k] = {1e30f, 1e30f, 1e30f, 1e30f};
+            for (long j = 0; j < n; j++) {
+                const float dx = points.x[j] - points.x[i];
+                const float dy = points.y[j] - points.y[i];
+                const float d2 = j == i ? 1e30f : dx * dx + dy * dy;
+                if (d2 < best[k - 1] && d2 <= 100.0f * 100.0f) {
+                    std::size_t pos = k - 1;
+                    for (; pos > 0 && best[pos - 1] > d2; pos--) {
+                        best[pos] = best[pos - 1];
+                    }
+                    best[pos] = d2;
+                }
+            }
+            found += best[0] < 1e30f;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    set_agents(state, n);
+}
+BENCHMARK(BM_BruteForceKnn)->Arg(1000)->Arg(3000)->Arg(10000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,163 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <swarm/Agent.hpp>
+#include <swarm/Gae.hpp>
+#include <swarm/PpoLoss.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/StackedAgent.hpp>
+#include <memory>
+#include <vector>
+
+static void set_samples(benchmark::State& state, long samples_per_iteration) {
+    state.counters["samples/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * samples_per_iteration), benchmark::Counter::kIsRate);
+}
+
+// Rollout shaped like train(): range(0) = num_steps, range(1) = num_envs
+struct GaeInputs {
+    torch::Tensor rewards;
+    torch::Tensor values;
+    torch::Tensor dones;
+    torch::Tensor next_value;
+    torch::Tensor next_done;
+
+    GaeInputs(long num_steps, long num_envs)
+        : rewards(torch::randn({num_steps, num_envs}))
+        , values(torch::randn({num_steps, num_envs}))
+        , dones((torch::rand({num_steps, num_envs}) < 0.05).to(torch::kFloat32))
+        , next_value(torch::randn({1, num_envs}))
+        , next_done(torch::zeros({num_envs}))
+    {}
+};
+
+// The per-timestep tensor loop train() used before compute_gae
+static void BM_GaeTensorLoop(benchmark::State& state) {
+    const long num_steps = state.range(0);
+    const long num_envs = state.range(1);
+    GaeInputs in(num_steps, num_envs);
+    const float gamma = 0.99f;
+    const float gae_lambda = 0.95f;
+
+    for (auto _ : state) {
+        auto advantages = torch::zeros_like(in.rewards);
+        torch::Tensor lastgaelam = torch::zeros({num_envs});
+        for (long t = num_steps - 1; t >= 0; t--) {
+            torch::Tensor nextnonterminal;
+            torch::Tensor nextvalues;
+            if (t == num_steps - 1) {
+                nextnonterminal = 1.0 - in.next_done;
+                nextvalues = in.next_value.squeeze(0);
+            } else {
+                nextnonterminal = 1.0 - in.dones[t + 1];
+                nextvalues = in.values[t + 1];
+            }
+            auto delta = in.rewards[t] + gamma * nextvalues * nextnonterminal - in.values[t];
+            advantages[t] = lastgaelam = delta + gamma * gae_lambda * nextnonterminal * lastgaelam;
+        }
+        auto returns = advantages + in.values;
+        benchmark::DoNotOptimize(returns.data_ptr<float>());
+    }
+    set_samples(state, num_steps * num_envs);
+}
+BENCHMARK(BM_GaeTensorLoop)->ArgsProduct({{128, 256}, {16, 64, 256}});
+
+static void BM_GaeFused(benchmark::State& state) {
+    const long num_steps = state.range(0);
+    const long num_envs = state.range(1);
+    GaeInputs in(num_steps, num_envs);
+
+    for (auto _ : state) {
+        auto res = compute_gae(in.rewards, in.values, in.dones, in.next_value, in.next_done, 0.99f, 0.95f);
+        benchmark::DoNotOptimize(res.returns.data_ptr<float>());
+    }
+    set_samples(state, num_steps * num_envs);
+}
+BENCHMARK(BM_GaeFused)->ArgsProduct({{128, 256}, {16, 64, 256}});
+
+// One optimizer step of ppo_update: forward, loss, backward, grad clipping and Adam.
+// range(0) = minibatch size, range(1) = 1 for fused_ppo_loss
+static void BM_PpoMinibatchUpdate(benchmark::State& state) {
+    const long batch = state.range(0);
+    const bool fused = state.range(1) != 0;
+    torch::manual_seed(0);
+    SimpleMovingEnvironment env;
+    Agent agent{&env};
+    torch::optim::Adam optimizer(agent.parameters(), torch::optim::AdamOptions(2.5e-4).eps(1e-5));
+
+    const auto obs = torch::rand({batch, static_cast<long>(env.get_observation_size())});
+    const auto actions = torch::randint(static_cast<long>(env.get_action_space_size()), {batch}, torch::kLong);
+    const auto oldlogprob = torch::randn({batch}) * 0.1 - 1.4;
+    const auto advantages = torch::randn({batch});
+    const auto returns = torch::randn({batch});
+    const auto oldvalues = torch::randn({batch});
+
+    for (auto _ : state) {
+        auto res = agent.get_action_and_value(obs, actions);
+        const PpoLossInputs inputs{
+            res.log_prob, res.entropy, res.value, oldlogprob, advantages, returns, oldvalues,
+        };
+        auto loss = fused ? fused_ppo_loss(inputs, 0.2f, 0.5f, 0.01f).loss : ppo_loss(inputs, 0.2f, 0.5f, 0.01f).loss;
+        optimizer.zero_grad();
+        loss.backward();
+        torch::nn::utils::clip_grad_norm_(agent.parameters(), 0.5);
+        optimizer.step();
+    }
+    set_samples(state, batch);
+}
+BENCHMARK(BM_PpoMinibatchUpdate)->ArgsProduct({{256, 1024, 4096}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// One optimizer step for a population of K agents on minibatches of 256 each: K separate Agents with their own Adam
+// against one StackedAgent. range(0) = K, range(1) = 1 for stacked
+static void BM_PopulationMinibatchUpdate(benchmark::State& state) {
+    const long num_policies = state.range(0);
+    const bool stacked = state.range(1) != 0;
+    constexpr long batch = 256;
+    torch::manual_seed(0);
+    SimpleMovingEnvironment env;
+    std::vector<std::unique_ptr<Agent>> agents;
+    std::vector<Agent*> pointers;
+    std::vector<std::unique_ptr<torch::optim::Adam>> optimizers;
+    for (long k = 0; k < num_policies; k++) {
+        agents.push_back(std::make_unique<Agent>(&env));
+        pointers.push_back(agents.back().get());
+        optimizers.push_back(std::make_unique<torch::optim::Adam>(agents.back()->parameters(),
+                                                                  torch::optim::AdamOptions(2.5e-4).eps(1e-5)));
+    }
+    StackedAgent stacked_agent(pointers);
+    torch::optim::Adam stacked_optimizer(stacked_agent.parameters(), torch::optim::AdamOptions(2.5e-4).eps(1e-5));
+
+    const auto obs = torch::rand({num_policies, batch, static_cast<long>(env.get_observation_size())});
+    const auto actions =
+        torch::randint(static_cast<long>(env.get_action_space_size()), {num_policies, batch}, torch::kLong);
+    const auto oldlogprob = torch::randn({num_policies, batch}) * 0.1 - 1.4;
+    const auto advantages = torch::randn({num_policies, batch});
+    const auto returns = torch::randn({num_policies, batch});
+    const auto oldvalues = torch::randn({num_policies, batch});
+
+    for (auto _ : state) {
+        if (stacked) {
+            auto res = stacked_agent.get_action_and_value(obs, actions);
+            auto loss = ppo_loss({res.log_prob, res.entropy, res.value, oldlogprob, advantages, returns, oldvalues},
+                                 0.2f, 0.5f, 0.01f).loss.sum();
+            stacked_optimizer.zero_grad();
+            loss.backward();
+            stacked_agent.clip_grad_norm(0.5);
+            stacked_optimizer.step();
+            continue;
+        }
+        for (long k = 0; k < num_policies; k++) {
+            auto res = agents[k]->get_action_and_value(obs[k], actions[k]);
+            auto loss = ppo_loss({res.log_prob, res.entropy, res.value, oldlogprob[k], advantages[k], returns[k],
+                                  oldvalues[k]}, 0.2f, 0.5f, 0.01f).loss;
+            optimizers[k]->zero_grad();
+            loss.backward();
+            torch::nn::utils::clip_grad_norm_(agents[k]->parameters(), 0.5);
+            optimizers[k]->step();
+        }
+    }
+    set_samples(state, num_policies * batch);
+}
+BENCHMARK(BM_PopulationMinibatchUpdate)->ArgsProduct({{1, 4, 16, 64}, {0, 1}})->Unit(benchmark::kMicrosecond);
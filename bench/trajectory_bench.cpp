@@ -0,0 +1,74 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <swarm/Trajectory.hpp>
+#include <filesystem>
+#include <vector>
+
+static constexpr long k_obs_size = 16;
+
+static std::filesystem::path bench_path() {
+    return std::filesystem::temp_directory_path() / "swarm_trajectory_bench.traj";
+}
+
+// One step of every env, the values do not matter
+struct StepBuffers {
+    explicit StepBuffers(long num_envs)
+        : observations(num_envs * k_obs_size, 0.5f), actions(num_envs, 1), floats(num_envs, 0.25f),
+          positions(4 * num_envs, 100.0f) {}
+
+    std::vector<float> observations;
+    std::vector<std::int64_t> actions;
+    std::vector<float> floats;
+    std::vector<float> positions;
+
+    TrajectoryRow row() const {
+        return {observations.data(), actions.data(), floats.data(), floats.data(),
+                floats.data(),       floats.data(),  positions.data()};
+    }
+};
+
+// range(0) = num_envs, the cost record() adds to every env step, flushing happens on the recorder's thread
+static void BM_TrajectoryRecord(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    const StepBuffers buffers(num_envs);
+    TrajectoryRecorder recorder(bench_path(), num_envs, k_obs_size, true);
+    const auto row = buffers.row();
+    for (auto _ : state) {
+        recorder.record(row);
+    }
+    recorder.close();
+    state.counters["env_steps/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * num_envs), benchmark::Counter::kIsRate);
+    state.counters["stalls"] = static_cast<double>(recorder.get_num_stalls());
+    state.SetBytesProcessed(state.iterations() * num_envs * (k_obs_size * 4 + 4 * 4 + 1 + 4 * 4));
+}
+BENCHMARK(BM_TrajectoryRecord)->Arg(16)->Arg(1024)->UseRealTime();
+
+// range(0) = num_envs, sums every reward of a recording chunk by chunk through the mapping
+static void BM_TrajectoryScanRewards(benchmark::State& state) {
+    const long num_envs = state.range(0);
+    constexpr long steps = 2048;
+    {
+        const StepBuffers buffers(num_envs);
+        TrajectoryRecorder recorder(bench_path(), num_envs, k_obs_size);
+        for (long t = 0; t < steps; t++) {
+            recorder.record(buffers.row());
+        }
+    }
+    const TrajectoryReader reader(bench_path());
+    for (auto _ : state) {
+        double total = 0.0;
+        for (std::size_t i = 0; i < reader.get_num_chunks(); i++) {
+            for (float reward : reader.chunk(i).rewards) {
+                total += reward;
+            }
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.counters["env_steps/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * steps * num_envs), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_TrajectoryScanRewards)->Arg(16)->Arg(1024);
@@ -6,6 +6,7 @@
 # - apply_error_on_warnings(target)
 # - apply_sanitizer(target sanitizer_type)
 # - apply_lto(target)
+# - apply_native_arch(target)
 
 function(apply_compiler_warnings target)
     if(MSVC)
@@ -47,3 +48,11 @@ function(apply_lto target)
         set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
     endif()
 endfunction()
+
+function(apply_native_arch target)
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU" OR CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        target_compile_options(${target} PRIVATE -march=native)
+    else()
+        message(WARNING "Native architecture flags are not supported for compiler '${CMAKE_CXX_COMPILER_ID}'")
+    endif()
+endfunction()
@@ -9,6 +9,7 @@
 #   ENABLE_SANITIZER_THREAD (default: OFF)
 #   ENABLE_SANITIZER_UNDEFINED (default: OFF)
 #   ENABLE_LTO (default: OFF for dev, ON for release)
+#   ENABLE_NATIVE_ARCH (default: OFF)
 #
 # Usage:
 #   target_add_executable(my_app src/main.cpp src/util.cpp)
@@ -46,6 +47,11 @@ function(target_add_executable target_name)
     if(ENABLE_LTO)
         apply_lto(${target_name})
     endif()
+
+    # Compile for the host CPU if enabled, the SIMD kernels pick their ISA at runtime either way
+    if(ENABLE_NATIVE_ARCH)
+        apply_native_arch(${target_name})
+    endif()
 endfunction()
 
 function(target_add_library target_name)
@@ -90,5 +96,10 @@ function(target_add_library target_name)
         if(ENABLE_LTO)
             apply_lto(${target_name})
         endif()
+
+        # Compile for the host CPU if enabled, the SIMD kernels pick their ISA at runtime either way
+        if(ENABLE_NATIVE_ARCH)
+            apply_native_arch(${target_name})
+        endif()
     endif()
 endfunction()
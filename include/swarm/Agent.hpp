@@ -4,6 +4,9 @@
 
 #ifndef SWARM_AGENT_HPP
 #define SWARM_AGENT_HPP
+#include <swarm/FrozenPolicy.hpp>
+#include <swarm/FusedActorCritic.hpp>
+#include <swarm/QuantizedPolicy.hpp>
 #include <swarm/TensorFactory.hpp>
 
 #include "Environment.hpp"
@@ -61,7 +64,42 @@ public:
 		} else {
 			sampled_action = action.value();
 		}
+		return details(observation, logits, probs, sampled_action);
+	}
+	// Samples by inverse CDF from uniform, one value in [0, 1) per row, so the caller owns the random stream.
+	// Given the same uniforms it picks the same actions as FusedActorCritic::act.
+	ActionDetails sample_action_and_value(const torch::Tensor& observation, const torch::Tensor& uniform)
+	{
+		auto logits = m_actor->forward(observation);
+		auto probs = torch::softmax(logits, -1);
+		auto cdf = probs.cumsum(-1);
+		const long last = cdf.size(-1) - 1;
+		auto threshold = uniform.unsqueeze(-1) * cdf.narrow(-1, last, 1);
+		auto sampled_action = (cdf <= threshold).sum(-1).clamp_max(last);
+		return details(observation, logits, probs, sampled_action);
+	}
+	torch::Tensor act_greedy(const torch::Tensor& observation)
+	{
+		auto logits = m_actor->forward(observation);
+		auto probs  = torch::softmax(logits, -1);
+		auto result = probs.argmax(-1);
+		return result;
+	}
+	// Copies the current parameters into the libtorch-free inference kernel, call again after every update
+	void pack_into(FusedActorCritic& kernel) const;
+	FusedActorCritic make_fused() const;
+	// Writes the actor as a frozen policy file, load it with FrozenPolicy for act_greedy without libtorch
+	void export_frozen(const std::filesystem::path& path) const;
+	// Int8 copy of the actor for act_greedy, activation scales calibrated on observations ([n, observation_size]),
+	// check it against export_frozen's policy with compare_greedy
+	QuantizedPolicy quantize_actor(std::span<const float> calibration) const;
 
+private:
+	// The actor's Linear layers in the layout write_frozen_policy takes, tensors keeps the weights they point to alive
+	std::vector<FrozenLayerSpec> actor_layers(std::vector<torch::Tensor>& tensors) const;
+	ActionDetails details(const torch::Tensor& observation, const torch::Tensor& logits, const torch::Tensor& probs,
+						  const torch::Tensor& sampled_action)
+	{
 		// Get log probability using log_softmax directly on logits (more numerically stable)
 		auto log_probs = torch::log_softmax(logits, -1);
 		auto action_log_prob = log_probs.gather(-1, sampled_action.unsqueeze(-1)).squeeze(-1);
@@ -74,13 +112,6 @@ public:
 
 		return {sampled_action, action_log_prob, entropy, value};
 	}
-	torch::Tensor act_greedy(const torch::Tensor& observation)
-	{
-		auto logits = m_actor->forward(observation);
-		auto probs  = torch::softmax(logits, -1);
-		auto result = probs.argmax(-1);
-		return result;
-	}
 
 };
 
@@ -0,0 +1,68 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_CHECKPOINT_HPP
+#define SWARM_CHECKPOINT_HPP
+
+#include <swarm/common.hpp>
+#include <swarm/Philox.hpp>
+#include <condition_variable>
+#include <stop_token>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Archive helpers for Environment::save_state / load_state
+void write_rng(torch::serialize::OutputArchive& archive, const std::string& key, const Philox& rng);
+void read_rng(torch::serialize::InputArchive& archive, const std::string& key, Philox& rng);
+void write_floats(torch::serialize::OutputArchive& archive, const std::string& key, const std::vector<float>& values);
+void read_floats(torch::serialize::InputArchive& archive, const std::string& key, std::vector<float>& values);
+// Philox counters and keys, stored bit-for-bit as int64
+void write_counters(torch::serialize::OutputArchive& archive, const std::string& key,
+					const std::vector<std::uint64_t>& values);
+void read_counters(torch::serialize::InputArchive& archive, const std::string& key, std::vector<std::uint64_t>& values);
+
+/**
+ * Writes checkpoints on a background thread. The caller snapshots its state (copies, never references to tensors it
+ * keeps training) into a job that fills the archive; the writer runs it, saves to a temporary file, fsyncs and
+ * renames it over the checkpoint, so a crash leaves either the old or the new checkpoint. A job submitted while the
+ * previous one is still waiting replaces it, the training thread never waits on the disk.
+ */
+class CheckpointWriter
+{
+ public:
+	using Job = std::function<void(torch::serialize::OutputArchive&)>;
+
+	explicit CheckpointWriter(std::filesystem::path path);
+	~CheckpointWriter();
+
+	CheckpointWriter(const CheckpointWriter&)			 = delete;
+	CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+	// Rethrows the error of an earlier write
+	void submit(Job job);
+	// Blocks until every submitted job is on disk, rethrows write errors
+	void wait();
+
+	const std::filesystem::path& path() const;
+	long						 get_num_written() const;
+
+ private:
+	void run(std::stop_token stop);
+	void write(const Job& job);
+	void rethrow_error();
+
+	std::filesystem::path	m_path;
+	mutable std::mutex		m_mutex;
+	std::condition_variable_any m_cv;
+	Job						m_pending;
+	bool					m_writing = false;
+	long					m_written = 0;
+	std::exception_ptr		m_error;
+	std::jthread			m_thread; // Last, so it is joined before the members it uses go away
+};
+
+#endif // SWARM_CHECKPOINT_HPP
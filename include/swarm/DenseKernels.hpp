@@ -0,0 +1,42 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_DENSEKERNELS_HPP
+#define SWARM_DENSEKERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Alignment of packed weight buffers, one AVX-512 register or cache line
+inline constexpr std::size_t k_kernel_alignment = 64;
+
+// Rounds a float count up to a whole number of k_kernel_alignment blocks
+constexpr std::size_t round_up_to_lane(std::size_t n)
+{
+	constexpr std::size_t lane = k_kernel_alignment / sizeof(float);
+	return (n + lane - 1) / lane * lane;
+}
+
+// y[j] = bias[j] + sum_k x[k] * w[k * ld + j] for j < cols. Weights are stored input major so each input is one
+// broadcast-and-FMA sweep over contiguous outputs (AVX-512 / AVX2 when the CPU has them).
+void dense_forward(const float* x, std::size_t in, const float* w, std::size_t ld, const float* bias,
+				   std::size_t cols, float* y);
+// The dense_forward this CPU runs, picked at runtime: "avx512", "avx2" or "scalar"
+const char* dense_kernel_isa();
+
+// Inputs per int8 weight group, the four bytes one 32-bit lane of VNNI's vpdpbusd multiplies and sums
+inline constexpr std::size_t k_int8_group = 4;
+
+// acc[j] = sum_k x[k] * w[k][j] for j < cols in exact int32 arithmetic, unsigned 8-bit inputs times signed 8-bit
+// weights. in is a multiple of k_int8_group and w is packed [in / 4][cols][4], the four weights of one output and
+// group adjacent (AVX-512 VNNI / AVX-VNNI / AVX2 when the CPU has them, all bit identical to the scalar loop).
+void dense_forward_u8s8(const std::uint8_t* x, std::size_t in, const std::int8_t* w, std::size_t cols,
+						std::int32_t* acc);
+// The dense_forward_u8s8 this CPU runs, picked at runtime: "avx512-vnni", "avx-vnni", "avx2" or "scalar"
+const char* int8_kernel_name();
+
+// Rational tanh approximation, max abs error ~5e-7
+void tanh_inplace(float* y, std::size_t n);
+
+#endif // SWARM_DENSEKERNELS_HPP
@@ -5,6 +5,15 @@
 #ifndef SWARM_ENVIRONMENT_HPP
 #define SWARM_ENVIRONMENT_HPP
 #include <swarm/common.hpp>
+#include <swarm/EpisodeStats.hpp>
+#include <swarm/Philox.hpp>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+struct SwarmSnapshot;
 
 class Environment
 {
@@ -15,12 +24,105 @@ class Environment
 		torch::Tensor reward;
 		torch::Tensor done;
 	};
+	// Caller-owned float32 memory for step_into(), one row per env of get_num_envs()
+	struct StepBuffers
+	{
+		std::span<const std::int64_t> actions;
+		std::span<float>			  observations; // get_num_envs() * get_observation_size()
+		std::span<float>			  rewards;
+		std::span<float>			  dones;
+	};
 	virtual StepResult step(const torch::Tensor& action) = 0;
+	// step() without tensors: reads the actions and writes the results into the caller's buffers, e.g. straight into
+	// the rows of a rollout. Same contract as step(), including which envs reset. This default adapts step(), envs
+	// override it to skip its allocations and copies.
+	virtual void step_into(const StepBuffers& buffers)
+	{
+		// Single envs take a scalar action like the ones MultiEnv hands them
+		auto*	   data	   = const_cast<std::int64_t*>(buffers.actions.data());
+		const auto n	   = static_cast<long>(buffers.actions.size());
+		const auto actions = get_num_envs() == 1 ? torch::from_blob(data, {}, torch::kLong)
+												 : torch::from_blob(data, {n}, torch::kLong);
+		auto	   res	   = step(actions);
+		copy_into(res.observations, buffers.observations);
+		copy_into(res.reward, buffers.rewards);
+		copy_into(res.done, buffers.dones);
+	}
 	virtual std::size_t get_observation_size() const = 0;
 	virtual std::size_t get_action_space_size() const = 0;
+	// Number of envs stepped by one call to step(), vectorized envs return their batch size
+	virtual std::size_t get_num_envs() const { return 1; }
 	virtual torch::Tensor reset() = 0;
+	// reset() into get_num_envs() * get_observation_size() floats of the caller, adapts reset() unless overridden
+	virtual void reset_into(std::span<float> observations) { copy_into(reset(), observations); }
+	// Reseeds the env's random source so resets become reproducible, no-op for deterministic envs.
+	// Env i of the batch draws from its own Philox stream first_stream + i.
+	virtual void seed(std::uint64_t, std::uint64_t /*first_stream*/ = k_env_streams) {}
+	// Episodes finished since the last call, envs that do not track them report none
+	virtual EpisodeStats take_episode_stats() { return {}; }
+	// Everything step() and reset() depend on, including random state, for exact resumes from a checkpoint.
+	// Returns false when the env cannot do that, training then resets it on resume.
+	virtual bool save_state(torch::serialize::OutputArchive&) const { return false; }
+	virtual void load_state(torch::serialize::InputArchive&) {}
+	// Appends agent and goal positions for the viewer, envs that cannot be drawn add nothing
+	virtual void write_snapshot(SwarmSnapshot&) const {}
+	// Moves the goal of every world the env steps, no-op for envs without a goal
+	virtual void set_goal(sf::Vector2f) {}
 	virtual std::unique_ptr<Environment> clone() const = 0;
 	virtual ~Environment() = default;
+
+	protected:
+	// step() for envs that implement step_into(): allocates [num_envs(, obs_size)] float32 results and steps into them
+	StepResult step_buffered(const torch::Tensor& action)
+	{
+		const auto n	   = static_cast<long>(get_num_envs());
+		const auto obs	   = static_cast<long>(get_observation_size());
+		const auto actions = action.to(torch::kCPU, torch::kLong).contiguous();
+		if (actions.numel() != n)
+		{
+			throw std::invalid_argument(std::format("Expected {} actions, got {}", n, actions.numel()));
+		}
+		auto observations = torch::empty({n, obs}, torch::kFloat32);
+		auto rewards	  = torch::empty({n}, torch::kFloat32);
+		auto dones		  = torch::empty({n}, torch::kFloat32);
+		step_into({{actions.data_ptr<std::int64_t>(), static_cast<std::size_t>(n)},
+				   {observations.data_ptr<float>(), static_cast<std::size_t>(n * obs)},
+				   {rewards.data_ptr<float>(), static_cast<std::size_t>(n)},
+				   {dones.data_ptr<float>(), static_cast<std::size_t>(n)}});
+		return {observations, rewards, dones};
+	}
+	// Throws unless every buffer holds exactly get_num_envs() rows, for the step_into() overrides
+	void check_buffers(const StepBuffers& buffers) const
+	{
+		const std::size_t n = get_num_envs();
+		if (buffers.actions.size() != n || buffers.rewards.size() != n || buffers.dones.size() != n ||
+			buffers.observations.size() != n * get_observation_size())
+		{
+			throw std::invalid_argument(std::format(
+				"step_into buffers of {} actions, {} observations, {} rewards and {} dones for {} envs",
+				buffers.actions.size(), buffers.observations.size(), buffers.rewards.size(), buffers.dones.size(), n));
+		}
+	}
+	// Throws unless the span holds exactly one observation per env, for the reset_into() overrides
+	void check_observations(std::span<const float> observations) const
+	{
+		if (observations.size() != get_num_envs() * get_observation_size())
+		{
+			throw std::invalid_argument(std::format("Expected {} observation floats, got {}",
+													get_num_envs() * get_observation_size(), observations.size()));
+		}
+	}
+	// Copies a result tensor of step() or reset() into a span of exactly its size
+	static void copy_into(const torch::Tensor& values, std::span<float> out)
+	{
+		const auto src = values.to(torch::kCPU, torch::kFloat32).contiguous();
+		if (static_cast<std::size_t>(src.numel()) != out.size())
+		{
+			throw std::invalid_argument(
+				std::format("Buffer of {} floats for a result of {} values", out.size(), src.numel()));
+		}
+		std::memcpy(out.data(), src.data_ptr<float>(), out.size() * sizeof(float));
+	}
 };
 
 #endif // SWARM_ENVIRONMENT_HPP
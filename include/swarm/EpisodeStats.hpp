@@ -0,0 +1,82 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_EPISODESTATS_HPP
+#define SWARM_EPISODESTATS_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Episodes finished since the stats were last taken, kept as sums so shards can be merged cheaply
+struct EpisodeStats
+{
+	long   episodes	  = 0;
+	double return_sum = 0.0;
+	long   length_sum = 0;
+
+	void add(double episode_return, long episode_length)
+	{
+		episodes++;
+		return_sum += episode_return;
+		length_sum += episode_length;
+	}
+	EpisodeStats& operator+=(const EpisodeStats& other)
+	{
+		episodes += other.episodes;
+		return_sum += other.return_sum;
+		length_sum += other.length_sum;
+		return *this;
+	}
+	double mean_return() const
+	{
+		return episodes > 0 ? return_sum / static_cast<double>(episodes) : 0.0;
+	}
+	double mean_length() const
+	{
+		return episodes > 0 ? static_cast<double>(length_sum) / static_cast<double>(episodes) : 0.0;
+	}
+};
+
+// Running return and length of every env in a batch
+struct EpisodeTracker
+{
+	std::vector<double> returns;
+	std::vector<long>	lengths;
+	EpisodeStats		finished;
+
+	explicit EpisodeTracker(std::size_t num_envs = 0)
+		: returns(num_envs)
+		, lengths(num_envs)
+	{
+	}
+
+	// Adds one transition of env, a finished episode goes into `into` so concurrent shards can use their own stats
+	void step(std::size_t env, float reward, bool done, EpisodeStats& into)
+	{
+		returns[env] += reward;
+		lengths[env]++;
+		if (done)
+		{
+			into.add(returns[env], lengths[env]);
+			reset_env(env);
+		}
+	}
+	void step(std::size_t env, float reward, bool done)
+	{
+		step(env, reward, done, finished);
+	}
+	// Abandons the running episode of env without counting it
+	void reset_env(std::size_t env)
+	{
+		returns[env] = 0.0;
+		lengths[env] = 0;
+	}
+	EpisodeStats take()
+	{
+		return std::exchange(finished, {});
+	}
+};
+
+#endif // SWARM_EPISODESTATS_HPP
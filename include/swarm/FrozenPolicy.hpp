@@ -0,0 +1,81 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_FROZENPOLICY_HPP
+#define SWARM_FROZENPOLICY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+enum class Activation : std::uint32_t
+{
+	None = 0,
+	Tanh = 1,
+};
+
+// One dense layer handed to write_frozen_policy, weights in torch::nn::Linear layout ([out, in] row major)
+struct FrozenLayerSpec
+{
+	std::size_t	 in;
+	std::size_t	 out;
+	Activation	 activation;
+	const float* weight;
+	const float* bias;
+};
+
+/**
+ * Writes a versioned flat policy file: a 64 byte header, a table of layer shapes and activations and the weights,
+ * transposed to input major and 64 byte aligned so they can be used straight from the mapped file.
+ * The file is written next to path and renamed into place, readers never see a half written policy.
+ */
+void write_frozen_policy(const std::filesystem::path& path, std::span<const FrozenLayerSpec> layers);
+
+// On-disk layer table entry, defined next to the file format in FrozenPolicy.cpp
+struct FrozenLayerRecord;
+
+/**
+ * Read-only view of a policy file written by write_frozen_policy. The file is mmap'd and validated, inference
+ * runs on the mapped weights without copying them. Needs no libtorch.
+ *
+ * Not thread safe, every thread needs its own instance.
+ */
+class FrozenPolicy
+{
+ public:
+	static constexpr std::uint32_t k_version = 1;
+
+	explicit FrozenPolicy(const std::filesystem::path& path);
+	~FrozenPolicy();
+	FrozenPolicy(FrozenPolicy&& other) noexcept;
+	FrozenPolicy& operator=(FrozenPolicy&& other) noexcept;
+	FrozenPolicy(const FrozenPolicy&)			 = delete;
+	FrozenPolicy& operator=(const FrozenPolicy&) = delete;
+
+	// observations is [batch, observation_size], logits is [batch, action_space_size]
+	void logits(const float* observations, std::size_t batch, float* logits);
+	// Same as Agent::act_greedy, the index of the largest logit
+	void act_greedy(const float* observations, std::size_t batch, std::int64_t* actions);
+
+	std::size_t get_observation_size() const;
+	std::size_t get_action_space_size() const;
+	std::size_t get_num_layers() const;
+
+ private:
+	const float* forward(const float* observation);
+	void		 unmap();
+
+	const std::byte*		 m_mapping = nullptr;
+	std::size_t				 m_size	   = 0;
+	const FrozenLayerRecord* m_layers  = nullptr;
+	std::size_t				 m_num_layers{};
+	std::size_t				 m_input_size{};
+	std::size_t				 m_output_size{};
+	std::size_t				 m_max_width{};
+	std::vector<float>		 m_scratch;
+};
+
+#endif // SWARM_FROZENPOLICY_HPP
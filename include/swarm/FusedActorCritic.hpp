@@ -0,0 +1,66 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_FUSEDACTORCRITIC_HPP
+#define SWARM_FUSEDACTORCRITIC_HPP
+
+#include <swarm/Philox.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * libtorch-free inference for Agent's actor and critic (obs -> hidden -> hidden -> out, tanh activations).
+ * Both networks are packed into one 64 byte aligned buffer with the output neurons contiguous, so every layer is a
+ * broadcast-and-FMA sweep (AVX-512 / AVX2 when compiled for them). The first layer of actor and critic is one
+ * matrix since both read the observation. Actions are sampled by inverse CDF from a counter based random stream.
+ *
+ * Not thread safe, every thread needs its own instance.
+ */
+class FusedActorCritic
+{
+ public:
+	FusedActorCritic(std::size_t obs_size, std::size_t hidden_size, std::size_t action_size);
+
+	// Weights in torch::nn::Linear layout: weight is [out, in] row major, bias is [out]. layer is 0, 1 or 2.
+	void set_actor_layer(std::size_t layer, const float* weight, const float* bias);
+	void set_critic_layer(std::size_t layer, const float* weight, const float* bias);
+
+	// observations is [batch, obs_size], every output has batch entries
+	void act(const float* observations, std::size_t batch, std::int64_t* actions, float* log_probs, float* values);
+	void act_greedy(const float* observations, std::size_t batch, std::int64_t* actions);
+	// logits is [batch, action_size]
+	void actor_logits(const float* observations, std::size_t batch, float* logits);
+
+	// Sampling draws one Philox uniform per row, the same stream Agent::sample_action_and_value consumes
+	void seed(std::uint64_t seed, std::uint64_t stream = k_sampling_stream);
+	// Restoring the state continues sampling where a checkpoint left off
+	Philox::State get_rng_state() const;
+	void		  set_rng_state(const Philox::State& state);
+
+	std::size_t get_observation_size() const;
+	std::size_t get_hidden_size() const;
+	std::size_t get_action_space_size() const;
+
+ private:
+	struct AlignedDelete
+	{
+		void operator()(float* ptr) const;
+	};
+
+	// Runs both networks for one observation, leaves logits and value in m_scratch
+	void forward(const float* observation, bool with_critic);
+
+	std::size_t							  m_obs_size;
+	std::size_t							  m_hidden;
+	std::size_t							  m_actions;
+	// Offsets into m_weights
+	std::size_t							  m_w1, m_b1, m_w2, m_b2, m_w3, m_b3;
+	std::unique_ptr<float[], AlignedDelete> m_weights;
+	std::vector<float>					  m_scratch;
+	Philox								  m_rng{0x853c49e6748fea9bULL, k_sampling_stream};
+};
+
+#endif // SWARM_FUSEDACTORCRITIC_HPP
@@ -0,0 +1,30 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_GAE_HPP
+#define SWARM_GAE_HPP
+
+#include <swarm/common.hpp>
+
+/**
+ * Generalized advantage estimation over a whole rollout in one backward pass.
+ * All buffers are contiguous and row major, rewards/values/dones/advantages/returns are [num_steps, num_envs],
+ * next_value and next_done hold the bootstrap values and terminal masks after the last step.
+ * dones[t] marks that the observation of step t started a new episode, exactly like the rollout storage in train().
+ */
+void compute_gae(const float* rewards, const float* values, const float* dones, const float* next_value,
+				 const float* next_done, std::size_t num_steps, std::size_t num_envs, float gamma, float gae_lambda,
+				 float* advantages, float* returns);
+
+struct GaeResult
+{
+	torch::Tensor advantages;
+	torch::Tensor returns;
+};
+
+// Tensor front end, runs the kernel on the CPU and hands the results back on the device of rewards
+GaeResult compute_gae(const torch::Tensor& rewards, const torch::Tensor& values, const torch::Tensor& dones,
+					  const torch::Tensor& next_value, const torch::Tensor& next_done, float gamma, float gae_lambda);
+
+#endif // SWARM_GAE_HPP
@@ -0,0 +1,69 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_METRICS_HPP
+#define SWARM_METRICS_HPP
+
+#include <swarm/SpscRing.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+// One row of training telemetry per PPO update. Loss values are means over the update's minibatches.
+struct MetricsRecord
+{
+	long   update		  = 0;
+	long   global_step	  = 0;
+	double time_s		  = 0.0;
+	double sps			  = 0.0;
+	long   policy_lag	  = 0;
+	double mean_reward	  = 0.0; // Per transition of the rollout
+	long   episodes		  = 0;	 // Finished during the rollout
+	double episode_return = 0.0;
+	double episode_length = 0.0;
+	double pg_loss		  = 0.0;
+	double v_loss		  = 0.0;
+	double entropy		  = 0.0;
+	double approx_kl	  = 0.0;
+	double clipfrac		  = 0.0;
+	double grad_norm	  = 0.0; // Before clipping
+};
+
+enum class MetricsFormat
+{
+	JsonLines,
+	Csv,
+};
+
+/**
+ * Writes MetricsRecords on a background thread. push() only copies the record into an SpscRing, so the training
+ * loop never waits on I/O; the writer drains the ring, and flushes the file whenever it runs dry.
+ * A full ring drops the record instead of blocking and counts it.
+ */
+class MetricsWriter
+{
+	SpscRing<MetricsRecord>	 m_ring;
+	std::ofstream			 m_out;
+	MetricsFormat			 m_format;
+	std::atomic<std::size_t> m_dropped{0};
+	std::jthread			 m_thread; // Last, so it is joined before the members it drains go away
+
+	void run(std::stop_token stop);
+	void write(const MetricsRecord& record);
+
+ public:
+	// The format follows the extension, .csv writes CSV with a header and everything else JSON lines
+	explicit MetricsWriter(const std::filesystem::path& path, std::size_t capacity = 1024);
+	~MetricsWriter();
+
+	MetricsWriter(const MetricsWriter&)			   = delete;
+	MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+	// Call from one thread only
+	bool		push(const MetricsRecord& record);
+	std::size_t dropped() const;
+};
+
+#endif // SWARM_METRICS_HPP
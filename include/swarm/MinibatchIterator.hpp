@@ -0,0 +1,76 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_MINIBATCHITERATOR_HPP
+#define SWARM_MINIBATCHITERATOR_HPP
+
+#include <swarm/common.hpp>
+#include <swarm/Philox.hpp>
+#include <swarm/RolloutStorage.hpp>
+#include <future>
+
+/**
+ * PPO epochs over the transitions of one RolloutStorage. The float32 fields GAE produced are interleaved into a single
+ * row per transition [advantage, return, value]. Every epoch permutes those rows, and the observations, actions and
+ * log-probs of the storage rows in their narrow storage types, once into contiguous buffers, so minibatches are plain
+ * slices and only the narrow slices are widened. The next epoch is shuffled on a background thread while the current
+ * one trains; its permutation is a Fisher-Yates shuffle drawn from rng on the calling thread, so runs stay
+ * reproducible on any device.
+ */
+class MinibatchIterator
+{
+ public:
+	struct Minibatch
+	{
+		torch::Tensor observations; // [M, obs_size]
+		torch::Tensor actions;		// [M], int64
+		torch::Tensor logprobs;		// [M]
+		torch::Tensor advantages;	// [M]
+		torch::Tensor returns;		// [M]
+		torch::Tensor values;		// [M]
+	};
+
+ private:
+	// One permutation of the packed fields and of the storage rows they belong to
+	struct Epoch
+	{
+		torch::Tensor			   packed;
+		RolloutStorage::StoredRows stored;
+	};
+
+	const RolloutStorage& m_storage;
+	torch::Tensor		  m_packed; // [batch, 3]
+	torch::Tensor		  m_rows;	// [batch], int64
+	long				  m_batch_size;
+	long				  m_minibatch_size;
+	long				  m_num_epochs;
+	long				  m_epoch = -1;
+	Philox&				  m_rng;
+	Epoch				  m_current;
+	std::future<Epoch>	  m_next;
+
+	std::future<Epoch> shuffle_async();
+
+ public:
+	// rows [batch] are indices into the storage's flattened num_steps * num_envs transitions, advantages, returns and
+	// values are [batch] and aligned with them. The storage must outlive the iterator.
+	MinibatchIterator(const RolloutStorage& storage, const torch::Tensor& rows, const torch::Tensor& advantages,
+					  const torch::Tensor& returns, const torch::Tensor& values, long minibatch_size, long num_epochs,
+					  Philox& rng);
+	~MinibatchIterator();
+
+	MinibatchIterator(const MinibatchIterator&)			   = delete;
+	MinibatchIterator& operator=(const MinibatchIterator&) = delete;
+
+	// Waits for the next shuffled epoch and starts shuffling the one after, false once all epochs were served
+	bool next_epoch();
+
+	// Slices of the current epoch widened to float32 / int64, views of it for every column stored in that type
+	Minibatch minibatch(long index) const;
+
+	long num_minibatches() const;
+	long minibatch_size() const;
+};
+
+#endif // SWARM_MINIBATCHITERATOR_HPP
@@ -0,0 +1,54 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_PARALLELMULTIENV_HPP
+#define SWARM_PARALLELMULTIENV_HPP
+
+#include <swarm/Training.hpp>
+#include <barrier>
+#include <exception>
+#include <thread>
+
+/**
+ * MultiEnv which splits its envs into contiguous shards and steps them on a persistent worker pool.
+ * Every worker steps and auto-resets its shard and writes into disjoint rows of the caller's buffers (step_into),
+ * the only synchronization per step is a start and a finish barrier. The calling thread works on shard 0.
+ * Results are identical to MultiEnv since every env keeps its own random source.
+ */
+struct ParallelMultiEnv : MultiEnv
+{
+	ParallelMultiEnv(std::unique_ptr<Environment> env, std::size_t num_envs, std::size_t num_workers);
+	~ParallelMultiEnv() override;
+
+	ParallelMultiEnv(const ParallelMultiEnv&)			 = delete;
+	ParallelMultiEnv& operator=(const ParallelMultiEnv&) = delete;
+
+	void		 step_into(const StepBuffers& buffers) override;
+	void		 reset_into(std::span<float> observations) override;
+	EpisodeStats take_episode_stats() override;
+	std::size_t	 get_num_workers() const;
+
+ private:
+	enum class Job
+	{
+		Step,
+		Reset,
+		Stop,
+	};
+
+	void worker_loop(std::size_t worker);
+	void run_shard(std::size_t worker);
+	void run(Job job);
+
+	std::size_t						m_num_workers;
+	std::barrier<>					m_start;
+	std::barrier<>					m_finish;
+	Job								m_job = Job::Step;
+	StepBuffers						m_buffers; // The caller's, set for the duration of one step or reset
+	std::vector<std::exception_ptr> m_errors;
+	std::vector<EpisodeStats>		m_worker_episodes; // Episodes finished in each shard, merged when taken
+	std::vector<std::jthread>		m_threads;
+};
+
+#endif // SWARM_PARALLELMULTIENV_HPP
@@ -0,0 +1,141 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_PHILOX_HPP
+#define SWARM_PHILOX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Stream ids under one seed. Every consumer of a training run draws from its own streams so none shifts another.
+inline constexpr std::uint64_t k_env_streams	 = 0; // + env index
+inline constexpr std::uint64_t k_sampling_stream = 1ULL << 62;
+inline constexpr std::uint64_t k_shuffle_stream	 = 2ULL << 62;
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): four random words as a pure function
+// of a 128 bit counter, here split into position and stream, and a 64 bit key
+constexpr std::array<std::uint32_t, 4> philox4x32(std::uint64_t counter, std::uint64_t stream, std::uint64_t key)
+{
+	constexpr std::uint64_t m0 = 0xD2511F53;
+	constexpr std::uint64_t m1 = 0xCD9E8D57;
+	std::uint32_t			c0 = static_cast<std::uint32_t>(counter);
+	std::uint32_t			c1 = static_cast<std::uint32_t>(counter >> 32);
+	std::uint32_t			c2 = static_cast<std::uint32_t>(stream);
+	std::uint32_t			c3 = static_cast<std::uint32_t>(stream >> 32);
+	std::uint32_t			k0 = static_cast<std::uint32_t>(key);
+	std::uint32_t			k1 = static_cast<std::uint32_t>(key >> 32);
+	for (int round = 0; round < 10; round++)
+	{
+		const std::uint64_t p0 = m0 * c0;
+		const std::uint64_t p1 = m1 * c2;
+		c0					   = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+		c1					   = static_cast<std::uint32_t>(p1);
+		c2					   = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+		c3					   = static_cast<std::uint32_t>(p0);
+		k0 += 0x9E3779B9;
+		k1 += 0xBB67AE85;
+	}
+	return {c0, c1, c2, c3};
+}
+
+// Top 24 bits as a float in [0, 1)
+constexpr float philox_uniform(std::uint32_t bits)
+{
+	return static_cast<float>(bits >> 8) * 0x1.0p-24f;
+}
+
+/**
+ * Sequential view of one Philox stream. Seeding is free and the whole state is four words, so envs and threads get
+ * their own stream instead of sharing a generator, and any draw can be replayed from (key, stream, counter).
+ * Satisfies UniformRandomBitGenerator, but prefer uniform() and below() which, unlike the std distributions, give the
+ * same numbers with every standard library.
+ */
+class Philox
+{
+ public:
+	using result_type = std::uint32_t;
+	// key, stream, counter of the next block, words of the current block already used
+	using State = std::array<std::uint64_t, 4>;
+
+	explicit Philox(std::uint64_t key = 0, std::uint64_t stream = 0)
+		: m_key(key)
+		, m_stream(stream)
+	{
+	}
+
+	void seed(std::uint64_t key, std::uint64_t stream = 0)
+	{
+		m_key	  = key;
+		m_stream  = stream;
+		m_counter = 0;
+		m_index	  = 4;
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		if (m_index == 4)
+		{
+			m_block = philox4x32(m_counter++, m_stream, m_key);
+			m_index = 0;
+		}
+		return m_block[m_index++];
+	}
+
+	float uniform(float low, float high) { return low + (high - low) * philox_uniform((*this)()); }
+
+	// Same numbers as n calls to uniform(), whole blocks are generated straight into out
+	void fill_uniform(float* out, std::size_t n, float low, float high)
+	{
+		std::size_t i = 0;
+		for (; i < n && m_index < 4; i++)
+		{
+			out[i] = uniform(low, high);
+		}
+		for (; i + 4 <= n; i += 4)
+		{
+			const auto block = philox4x32(m_counter++, m_stream, m_key);
+			for (std::size_t j = 0; j < 4; j++)
+			{
+				out[i + j] = low + (high - low) * philox_uniform(block[j]);
+			}
+		}
+		for (; i < n; i++)
+		{
+			out[i] = uniform(low, high);
+		}
+	}
+
+	// Integer in [0, bound) by multiply-shift, the bias is below bound / 2^32
+	std::uint32_t below(std::uint32_t bound)
+	{
+		return static_cast<std::uint32_t>((static_cast<std::uint64_t>((*this)()) * bound) >> 32);
+	}
+
+	State get_state() const { return {m_key, m_stream, m_counter, m_index}; }
+	void  set_state(const State& state)
+	{
+		m_key	  = state[0];
+		m_stream  = state[1];
+		m_counter = state[2];
+		m_index	  = static_cast<std::uint32_t>(state[3] < 4 ? state[3] : 4);
+		if (m_index < 4)
+		{
+			m_block = philox4x32(m_counter - 1, m_stream, m_key);
+		}
+	}
+
+ private:
+	std::uint64_t				 m_key;
+	std::uint64_t				 m_stream;
+	std::uint64_t				 m_counter = 0;
+	std::array<std::uint32_t, 4> m_block{};
+	std::uint32_t				 m_index = 4;
+};
+
+#endif // SWARM_PHILOX_HPP
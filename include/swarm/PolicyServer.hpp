@@ -0,0 +1,122 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_POLICYSERVER_HPP
+#define SWARM_POLICYSERVER_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+struct PolicyServerOptions
+{
+	std::size_t				  max_batch_size = 64;
+	std::chrono::microseconds max_delay{200}; // Longest the oldest request waits for others to join its batch
+};
+
+/**
+ * Latencies counted in fixed log-linear buckets: every power of two of microseconds is split into k_sub_buckets equal
+ * buckets, so a percentile overestimates by less than 1 / k_sub_buckets of its value (of a microsecond below 1 us) and
+ * the memory stays the same however many requests are served. The maximum is kept exactly.
+ */
+class LatencyHistogram
+{
+ public:
+	static constexpr std::size_t k_sub_buckets = 16;
+	static constexpr std::size_t k_octaves	   = 40; // [0, 1) us and then up to 2^39 us, longer ones land in the last
+
+	void record(double latency_us);
+
+	std::uint64_t count() const;
+	double		  max() const;
+	// Upper edge of the bucket holding the nearest-rank percentile p in [0, 1], capped at max(). 0 when empty.
+	double percentile(double p) const;
+
+ private:
+	std::array<std::uint64_t, k_octaves * k_sub_buckets> m_buckets{};
+	std::uint64_t										 m_count = 0;
+	double												 m_max	 = 0.0;
+};
+
+// Served requests since the stats were last taken
+struct PolicyServerStats
+{
+	std::uint64_t			   requests = 0;
+	std::uint64_t			   batches	= 0;
+	double					   p50_latency_us = 0.0; // From submit() until the future is ready
+	double					   p99_latency_us = 0.0;
+	double					   max_latency_us = 0.0;
+	std::vector<std::uint64_t> batch_sizes; // batch_sizes[n] batches of n requests, up to max_batch_size
+
+	double mean_batch_size() const;
+};
+
+/**
+ * Serves single observations from many client threads with one batched policy call. Clients submit() an
+ * observation and get a future of the action. A batcher thread takes the queued requests as soon as max_batch_size
+ * are waiting or the oldest has waited max_delay, runs the policy once on all of them and fulfils their futures.
+ * Alone a client pays at most max_delay on top of a batch of 1, under load the batches fill up and the policy cost
+ * per request drops while the queueing delay stays bounded.
+ *
+ * The policy only ever runs on the batcher thread, so a FrozenPolicy or FusedActorCritic that is not thread safe can
+ * be served as it is. The destructor serves the requests still queued before it joins the batcher.
+ */
+class PolicyServer
+{
+ public:
+	// observations is [batch, observation_size], writes one action per row, e.g. FrozenPolicy::act_greedy
+	using BatchPolicy = std::function<void(const float* observations, std::size_t batch, std::int64_t* actions)>;
+
+	PolicyServer(BatchPolicy policy, std::size_t observation_size, PolicyServerOptions options = {});
+	~PolicyServer();
+
+	PolicyServer(const PolicyServer&)			 = delete;
+	PolicyServer& operator=(const PolicyServer&) = delete;
+
+	// Thread safe. The observation is copied, the future throws what the policy threw.
+	std::future<std::int64_t> submit(std::span<const float> observation);
+	// Thread safe, resets the latencies and the histogram
+	PolicyServerStats take_stats();
+
+	std::size_t get_observation_size() const;
+
+ private:
+	using Clock = std::chrono::steady_clock;
+
+	void			   run(std::stop_token stop);
+	std::exception_ptr act(std::size_t batch); // Runs the policy on the batch, returns what it threw
+	void			   fulfil(std::size_t batch, const std::exception_ptr& error);
+
+	BatchPolicy			m_policy;
+	std::size_t			m_observation_size;
+	PolicyServerOptions m_options;
+
+	std::mutex							   m_mutex; // Guards the queue and the stats
+	std::condition_variable_any			   m_queued;
+	std::vector<float>					   m_queue_observations;
+	std::vector<std::promise<std::int64_t>> m_queue_promises;
+	std::vector<Clock::time_point>		   m_queue_submitted;
+
+	// Batcher thread only, reused for every batch
+	std::vector<float>					   m_observations;
+	std::vector<std::promise<std::int64_t>> m_promises;
+	std::vector<Clock::time_point>		   m_submitted;
+	std::vector<std::int64_t>			   m_actions;
+
+	LatencyHistogram		   m_latencies;
+	std::vector<std::uint64_t> m_batch_sizes;
+	std::uint64_t			   m_num_batches = 0;
+
+	std::jthread m_thread; // Last, so it is joined before the members it uses go away
+};
+
+#endif // SWARM_POLICYSERVER_HPP
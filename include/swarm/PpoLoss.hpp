@@ -0,0 +1,44 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_PPOLOSS_HPP
+#define SWARM_PPOLOSS_HPP
+
+#include <swarm/common.hpp>
+
+struct PpoLossInputs
+{
+	torch::Tensor newlogprob; // [B], differentiable
+	torch::Tensor entropy;	  // [B], differentiable
+	torch::Tensor newvalue;	  // [B], differentiable
+	torch::Tensor oldlogprob; // [B]
+	torch::Tensor advantages; // [B], raw, normalized per minibatch inside the loss
+	torch::Tensor returns;	  // [B]
+	torch::Tensor oldvalues;  // [B]
+};
+
+struct PpoLossResult
+{
+	torch::Tensor loss; // pg_loss - ent_coef * entropy_loss + vf_coef * v_loss
+	torch::Tensor pg_loss;
+	torch::Tensor v_loss;
+	torch::Tensor entropy_loss;
+	torch::Tensor approx_kl;
+	torch::Tensor clipfrac;
+};
+
+// Clipped PPO objective composed from regular tensor ops, the reference for fused_ppo_loss. Inputs may carry a
+// leading policy dimension, [K, B] for a StackedAgent: every reduction runs over the last dimension, so each policy
+// normalizes its own advantages and every result is [K].
+PpoLossResult ppo_loss(const PpoLossInputs& in, float clip_coef, float vf_coef, float ent_coef);
+
+/**
+ * Same objective as ppo_loss as one torch::autograd::Function: the forward pass computes the loss, the diagnostics
+ * and the analytic gradients for newlogprob, entropy and newvalue in one sweep over the minibatch (after a sweep
+ * for the advantage statistics), backward only scales them. Only loss is differentiable.
+ * Runs on CPU float32 tensors, anything else falls back to ppo_loss.
+ */
+PpoLossResult fused_ppo_loss(const PpoLossInputs& in, float clip_coef, float vf_coef, float ent_coef);
+
+#endif // SWARM_PPOLOSS_HPP
@@ -0,0 +1,77 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_QUANTIZEDPOLICY_HPP
+#define SWARM_QUANTIZEDPOLICY_HPP
+
+#include <swarm/FrozenPolicy.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Post-training int8 version of a dense policy for act_greedy. Weights are quantized symmetrically per output
+ * channel, every layer's input with one scale calibrated on observations the float policy has seen. The dot products
+ * run in exact int32 arithmetic in dense_forward_u8s8, only the rescale, bias and tanh between layers are float.
+ * Needs no libtorch.
+ *
+ * Not thread safe, every thread needs its own instance.
+ */
+class QuantizedPolicy
+{
+ public:
+	// layers as handed to write_frozen_policy, calibration is [n, observation_size] and should look like what the
+	// policy will be run on, e.g. recorded TrajectorySlice observations
+	QuantizedPolicy(std::span<const FrozenLayerSpec> layers, std::span<const float> calibration);
+
+	// observations is [batch, observation_size], logits is [batch, action_space_size]
+	void logits(const float* observations, std::size_t batch, float* logits);
+	// The index of the largest logit, compare it to the float policy with compare_greedy
+	void act_greedy(const float* observations, std::size_t batch, std::int64_t* actions);
+
+	std::size_t get_observation_size() const;
+	std::size_t get_action_space_size() const;
+	std::size_t get_num_layers() const;
+	// Bytes of quantized weights, scales and biases, what a forward pass streams through
+	std::size_t get_weight_bytes() const;
+
+ private:
+	struct Layer
+	{
+		std::size_t				  in;
+		std::size_t				  out;
+		std::size_t				  cols; // out rounded up to a multiple of 16, the padding outputs have zero weights
+		Activation				  activation;
+		float					  input_scale; // Input value of one quantization step
+		std::vector<std::int8_t>  weights;	   // [in / 4][cols][4], see dense_forward_u8s8
+		std::vector<float>		  output_scales; // input_scale * weight scale of the output channel
+		std::vector<std::int32_t> zero_point_sums; // 128 * sum of the output's weights, the input zero point's share
+		std::vector<float>		  bias;
+	};
+
+	const float* forward(const float* observation);
+
+	std::vector<Layer>		  m_layers;
+	std::vector<std::uint8_t> m_quantized; // Scratch, the current layer's input
+	std::vector<std::int32_t> m_accumulators;
+	std::vector<float>		  m_scratch;
+};
+
+// Greedy-action agreement of a quantized policy with its float reference
+struct QuantizationReport
+{
+	std::size_t samples	   = 0;
+	std::size_t agreements = 0; // Observations both policies pick the same action for
+	float		max_logit_error	 = 0.0f;
+	float		mean_logit_error = 0.0f;
+
+	double agreement() const;
+};
+
+// Runs both policies on observations ([n, observation_size], e.g. recorded TrajectorySlice observations)
+QuantizationReport compare_greedy(FrozenPolicy& reference, QuantizedPolicy& quantized,
+								  std::span<const float> observations);
+
+#endif // SWARM_QUANTIZEDPOLICY_HPP
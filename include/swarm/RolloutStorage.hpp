@@ -0,0 +1,88 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_ROLLOUTSTORAGE_HPP
+#define SWARM_ROLLOUTSTORAGE_HPP
+
+#include <swarm/common.hpp>
+#include <span>
+
+/**
+ * Rollout buffer of num_steps x num_envs transitions with a storage type per field.
+ * Actions are kept in the narrowest integer type holding the action space, dones are packed into bits and
+ * observations and values can be stored as bf16/fp16. Rewards and log-probs stay float32, GAE and the PPO ratio
+ * are too sensitive to round them. Everything is widened back to float32/int64 when it is read.
+ */
+class RolloutStorage
+{
+	long			  m_num_steps;
+	long			  m_num_envs;
+	long			  m_obs_size;
+	torch::Tensor	  m_obs;	  // [num_steps, num_envs, obs_size], obs_dtype
+	torch::Tensor	  m_actions;  // [num_steps, num_envs], narrow integer
+	torch::Tensor	  m_logprobs; // [num_steps, num_envs], float32
+	torch::Tensor	  m_rewards;  // [num_steps, num_envs], float32
+	torch::Tensor	  m_dones;	  // [num_steps, ceil(num_envs / 8)], one bit per env
+	torch::Tensor	  m_values;	  // [num_steps, num_envs], value_dtype
+	torch::Tensor	  m_bit_weights;
+
+	RolloutStorage(long num_steps, long num_envs, long obs_size);
+	// [rows, num_envs] flags to [rows, ceil(num_envs / 8)] bytes
+	torch::Tensor pack_bits(const torch::Tensor& flags) const;
+	torch::Tensor unpack_bits(const torch::Tensor& packed) const;
+
+ public:
+	RolloutStorage(long num_steps, long num_envs, long obs_size, std::size_t action_space_size,
+				   torch::ScalarType obs_dtype, torch::ScalarType value_dtype, torch::Device device);
+
+	/**
+	 * Storage over a whole rollout that already exists as float32 [num_steps, num_envs(, obs_size)] tensors, e.g.
+	 * in shared memory written by actor processes. Observations, log-probs, rewards and values are used as they are,
+	 * without a copy, so they must stay alive and unchanged while the storage is read. Only actions and dones are
+	 * converted to their narrow storage types.
+	 */
+	static RolloutStorage wrap(torch::Tensor obs, const torch::Tensor& actions, torch::Tensor logprobs,
+							   torch::Tensor rewards, const torch::Tensor& dones, torch::Tensor values,
+							   std::size_t action_space_size);
+
+	// Writes one step, every argument has num_envs rows and is narrowed to its storage type. obs and reward may be
+	// undefined when the env already wrote them into observation_row() and reward_row().
+	void store(long step, const torch::Tensor& obs, const torch::Tensor& action, const torch::Tensor& logprob,
+			   const torch::Tensor& reward, const torch::Tensor& done, const torch::Tensor& value);
+
+	// Rows for Environment::step_into() to write straight into, num_envs * obs_size and num_envs floats. Empty when
+	// the column is stored narrower than float32 or off the CPU, the step then goes through store().
+	std::span<float> observation_row(long step);
+	std::span<float> reward_row(long step);
+
+	// Whole rollout widened to float32 / int64, shaped [num_steps, num_envs(, obs_size)]
+	torch::Tensor observations() const;
+	torch::Tensor actions() const;
+	torch::Tensor logprobs() const;
+	torch::Tensor rewards() const;
+	torch::Tensor dones() const;
+	torch::Tensor values() const;
+
+	// Minibatch gathers over the flattened num_steps * num_envs batch, widened after the gather
+	torch::Tensor gather_observations(const torch::Tensor& indices) const;
+	torch::Tensor gather_actions(const torch::Tensor& indices) const;
+	torch::Tensor gather_logprobs(const torch::Tensor& indices) const;
+
+	// Observation, action and log-prob rows of the flattened batch in their storage types, e.g. one epoch's
+	// permutation that is sliced into minibatches and only widened per slice
+	struct StoredRows
+	{
+		torch::Tensor observations; // [n, obs_size], obs_dtype
+		torch::Tensor actions;		// [n], narrow integer
+		torch::Tensor logprobs;		// [n], float32
+	};
+	StoredRows gather_stored(const torch::Tensor& indices) const;
+
+	long		num_steps() const;
+	long		num_envs() const;
+	long		obs_size() const;
+	std::size_t bytes() const;
+};
+
+#endif // SWARM_ROLLOUTSTORAGE_HPP
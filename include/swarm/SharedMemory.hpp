@@ -0,0 +1,143 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SHAREDMEMORY_HPP
+#define SWARM_SHAREDMEMORY_HPP
+
+#include <swarm/EpisodeStats.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Anonymous MAP_SHARED mapping. Created before fork() it is the same memory in the parent and in every child, and
+ * there is no name to clean up when a process dies.
+ */
+class SharedMapping
+{
+ public:
+	explicit SharedMapping(std::size_t bytes);
+	~SharedMapping();
+
+	SharedMapping(const SharedMapping&)			   = delete;
+	SharedMapping& operator=(const SharedMapping&) = delete;
+
+	std::byte*	data() const;
+	std::size_t size() const;
+
+ private:
+	std::byte*	m_data = nullptr;
+	std::size_t m_size = 0;
+};
+
+// Blocks while word == expected, at most for timeout. A futex without the private flag, so it works across
+// processes, which std::atomic::wait does not promise.
+void shared_wait(const std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout);
+void shared_wake_all(std::atomic<std::uint32_t>& word);
+
+/**
+ * Latest policy weights for readers in other processes. The writer fills buffer version % 2 under a per buffer
+ * sequence count and then publishes the version, a reader copies the published buffer and retries when the writer
+ * touched it meanwhile (which takes the writer two publishes during one copy). Neither side ever blocks.
+ * One writer, any number of readers.
+ */
+class SharedWeights
+{
+ public:
+	explicit SharedWeights(std::size_t num_floats);
+
+	// Writer only
+	void publish(std::uint32_t version, const float* weights);
+	// Copies the latest weights into out and returns their version
+	std::uint32_t read(float* out) const;
+
+	std::uint32_t				 version() const;
+	std::atomic<std::uint32_t>&	 version_word();
+	std::size_t					 size() const;
+
+ private:
+	struct Control;
+
+	Control*	 control() const;
+	const float* buffer(std::size_t index) const;
+
+	std::size_t	  m_num_floats;
+	SharedMapping m_mapping;
+};
+
+// What an actor reports with its part of a rollout
+struct ActorReport
+{
+	std::int64_t policy_version = 0;
+	EpisodeStats episodes;
+};
+
+/**
+ * Rollouts written by actor processes straight into shared memory. Each of the k_num_slots slots holds one whole
+ * rollout as [num_steps, num_envs(, obs_size)] float32/int64 columns, actor a owns the env columns
+ * [a * envs_per_actor, (a + 1) * envs_per_actor) and bumps the slot's ready count when its part is complete. The
+ * learner wraps a slot whose count reached num_actors in tensors without copying and resets the count when it is
+ * done with it.
+ */
+class SharedRolloutRing
+{
+ public:
+	static constexpr std::size_t k_num_slots	  = 2;
+	static constexpr std::size_t k_error_capacity = 256;
+
+	SharedRolloutRing(std::size_t num_steps, std::size_t num_envs, std::size_t obs_size, std::size_t num_actors);
+
+	float*		  observations(std::size_t slot) const; // [num_steps, num_envs, obs_size]
+	std::int64_t* actions(std::size_t slot) const;		// [num_steps, num_envs]
+	float*		  logprobs(std::size_t slot) const;
+	float*		  values(std::size_t slot) const;
+	float*		  rewards(std::size_t slot) const;
+	float*		  dones(std::size_t slot) const;	  // Done flags before each step, like RolloutStorage::store
+	float*		  next_values(std::size_t slot) const; // [num_envs], bootstrap values after the last step
+	float*		  next_dones(std::size_t slot) const;
+	ActorReport&  report(std::size_t slot, std::size_t actor) const;
+
+	std::atomic<std::uint32_t>& ready(std::size_t slot) const;
+	// Set by the learner when the actors have to exit early
+	std::atomic<std::uint32_t>& stop() const;
+	// 0 until the learner is ready, then its first update + 1. Actors can be forked before the learner knows where a
+	// resumed run continues.
+	std::atomic<std::uint32_t>& start() const;
+
+	// First error of any actor wins, the learner rethrows it
+	void		set_error(const std::string& message);
+	bool		failed() const;
+	std::string error() const;
+
+	std::size_t num_steps() const;
+	std::size_t num_envs() const;
+	std::size_t obs_size() const;
+	std::size_t num_actors() const;
+	std::size_t envs_per_actor() const;
+
+ private:
+	struct Control;
+	// Byte offsets of the columns within a slot
+	struct Layout
+	{
+		std::size_t observations, actions, logprobs, values, rewards, dones, next_values, next_dones, reports;
+		std::size_t slot_bytes;
+	};
+
+	static Layout make_layout(std::size_t num_steps, std::size_t num_envs, std::size_t obs_size,
+							  std::size_t num_actors);
+	Control*	  control() const;
+	std::byte*	  slot_data(std::size_t slot) const;
+
+	std::size_t	  m_num_steps;
+	std::size_t	  m_num_envs;
+	std::size_t	  m_obs_size;
+	std::size_t	  m_num_actors;
+	Layout		  m_layout;
+	SharedMapping m_mapping;
+};
+
+#endif // SWARM_SHAREDMEMORY_HPP
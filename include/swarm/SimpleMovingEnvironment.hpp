@@ -8,7 +8,7 @@
 #include <swarm/Environment.hpp>
 #include <random>
 
-struct SimpleMovingEnvironment : Environment, sf::Drawable
+struct SimpleMovingEnvironment : Environment
 {
 	SimpleMovingEnvironment(sf::Vector2f position, sf::Vector2f velocity, sf::Vector2f goal)
 		: position(position)
@@ -16,34 +16,31 @@ struct SimpleMovingEnvironment : Environment, sf::Drawable
 		, goal(goal)
 	{
 	}
-	SimpleMovingEnvironment()
-	{
-		agent_shape.setFillColor(sf::Color::Green);
-		agent_shape.setRadius(10);
-		agent_shape.setPosition(position);
-
-		goal_shape.setFillColor(sf::Color::Red);
-		goal_shape.setSize({10, 10});
-		goal_shape.setPosition(position);
-	}
+	SimpleMovingEnvironment() = default;
 	sf::Vector2f position{};
 	sf::Vector2f velocity{};
 	sf::Vector2f goal{};
 	float last_distance{};
-	mutable sf::CircleShape agent_shape{};
-	sf::RectangleShape goal_shape{};
 	bool write_logs = false;
+	Philox rng{std::random_device{}()};
 	torch::Tensor				 get_current_observation() const;
 	StepResult					 step(const torch::Tensor& action) override;
+	void						 step_into(const StepBuffers& buffers) override;
 	std::size_t					 get_observation_size() const override;
 	std::size_t					 get_action_space_size() const override;
 	torch::Tensor				 reset() override;
+	void						 reset_into(std::span<float> observations) override;
+	void						 seed(std::uint64_t seed, std::uint64_t first_stream = k_env_streams) override;
+	bool						 save_state(torch::serialize::OutputArchive& archive) const override;
+	void						 load_state(torch::serialize::InputArchive& archive) override;
+	void						 write_snapshot(SwarmSnapshot& snapshot) const override;
+	void						 set_goal(sf::Vector2f new_goal_pos) override;
 	std::unique_ptr<Environment> clone() const override;
-	void set_goal(sf::Vector2f new_goal_pos);
 	void toggle_log();
 
-	 protected:
-	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+ private:
+	void reset_world();
+	void write_observation(float* out) const;
 };
 
 
@@ -0,0 +1,64 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SIMULATIONTHREAD_HPP
+#define SWARM_SIMULATIONTHREAD_HPP
+
+#include <swarm/Environment.hpp>
+#include <swarm/SpscRing.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/TripleBuffer.hpp>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <stop_token>
+#include <thread>
+
+/**
+ * Runs a policy in an env on its own thread at a fixed tick and publishes a SwarmSnapshot after every step through
+ * a TripleBuffer, so the render thread draws at its own frame rate and never holds up the simulation. A tick that
+ * overruns is not caught up on, the schedule restarts from now. Goals set by the render thread are queued and
+ * applied before the next step.
+ *
+ * observation is the env's current one, as returned by its last reset() or step(). The env and the policy belong to
+ * the simulation thread once constructed.
+ */
+class SimulationThread
+{
+ public:
+	using Policy = std::function<torch::Tensor(const torch::Tensor&)>;
+
+	SimulationThread(std::unique_ptr<Environment> env, torch::Tensor observation, Policy policy,
+					 std::chrono::nanoseconds tick);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&)			 = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Render thread only, moves the latest snapshot into snapshot(), false when there is none since the last call.
+	// Rethrows an error that stopped the simulation.
+	bool poll_snapshot();
+	// Render thread only
+	const SwarmSnapshot& snapshot() const;
+	// Render thread only, false when too many goals are still waiting for the simulation
+	bool set_goal(sf::Vector2f goal);
+
+ private:
+	void run(std::stop_token stop);
+	void step();
+
+	std::unique_ptr<Environment> m_env;
+	Policy						 m_policy;
+	std::chrono::nanoseconds	 m_tick;
+	torch::Tensor				 m_observation;
+	std::uint64_t				 m_ticks = 0;
+	TripleBuffer<SwarmSnapshot>	 m_snapshots;
+	SpscRing<sf::Vector2f>		 m_goals{16};
+	std::exception_ptr			 m_error;
+	std::atomic<bool>			 m_failed{false};
+	std::jthread				 m_thread; // Last, so it is joined before the members it uses go away
+};
+
+#endif // SWARM_SIMULATIONTHREAD_HPP
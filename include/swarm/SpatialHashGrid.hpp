@@ -0,0 +1,64 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SPATIALHASHGRID_HPP
+#define SWARM_SPATIALHASHGRID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * Uniform grid over a width x height world for neighbor queries. rebuild() counting-sorts the points by cell into
+ * reused buffers (no allocation once the point count is stable), so every row of cells a query touches is one
+ * contiguous run of coordinates which the distance test sweeps with AVX2 / AVX-512 when the CPU has them.
+ * Points outside the world are kept in the border cells, queries still return them at their true distance.
+ * Queries are const and safe to run from many threads between rebuilds.
+ */
+class SpatialHashGrid
+{
+ public:
+	static constexpr std::uint32_t k_no_point = std::numeric_limits<std::uint32_t>::max();
+
+	// cell_size is best around the usual query radius
+	SpatialHashGrid(float width, float height, float cell_size);
+
+	void rebuild(std::span<const float> x, std::span<const float> y);
+
+	// Appends every point within radius of (x, y) except exclude to out, in no particular order
+	void query_radius(float x, float y, float radius, std::vector<std::uint32_t>& out,
+					  std::uint32_t exclude = k_no_point) const;
+	// The up to index.size() nearest points within radius except exclude, closest first. Fills index and their
+	// squared distances, returns how many were found.
+	std::size_t query_knn(float x, float y, float radius, std::span<std::uint32_t> index, std::span<float> dist2,
+						  std::uint32_t exclude = k_no_point) const;
+
+	// The distance test this CPU runs, picked at runtime: "avx512", "avx2" or "scalar"
+	static const char* simd_isa();
+
+	std::size_t get_num_points() const;
+	std::size_t get_num_cells() const;
+	float		get_cell_size() const;
+
+ private:
+	std::size_t cell_x(float x) const;
+	std::size_t cell_y(float y) const;
+	// Calls visit(first, last) for the run of sorted points in each cell row overlapping the query square
+	template <typename Visit>
+	void for_each_run(float x, float y, float radius, Visit&& visit) const;
+
+	float					   m_cell_size;
+	float					   m_inv_cell_size;
+	std::size_t				   m_cells_x;
+	std::size_t				   m_cells_y;
+	std::vector<std::uint32_t> m_cell_start; // Prefix sums, points of cell c are [m_cell_start[c], m_cell_start[c + 1])
+	std::vector<std::uint32_t> m_cell_of;	 // Cell of each input point, kept between the two counting passes
+	std::vector<float>		   m_x;			 // Coordinates in cell order
+	std::vector<float>		   m_y;
+	std::vector<std::uint32_t> m_index; // Input index of each sorted point
+};
+
+#endif // SWARM_SPATIALHASHGRID_HPP
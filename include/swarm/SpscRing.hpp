@@ -0,0 +1,66 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SPSCRING_HPP
+#define SWARM_SPSCRING_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread. Capacity is rounded up to a power of
+ * two, the indices only ever grow and are masked on access. Head and tail live on their own cache lines so the
+ * two threads do not false-share.
+ */
+template <typename T>
+class SpscRing
+{
+	std::vector<T>							m_slots;
+	std::size_t								m_mask;
+	alignas(64) std::atomic<std::size_t>	m_head{0}; // Next slot to read, written by the consumer
+	alignas(64) std::atomic<std::size_t>	m_tail{0}; // Next slot to write, written by the producer
+
+ public:
+	explicit SpscRing(std::size_t capacity)
+		: m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+		, m_mask(m_slots.size() - 1)
+	{
+	}
+
+	// Producer only, false when the ring is full
+	bool try_push(const T& value)
+	{
+		const auto tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+		{
+			return false;
+		}
+		m_slots[tail & m_mask] = value;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only, false when the ring is empty
+	bool try_pop(T& value)
+	{
+		const auto head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = m_slots[head & m_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t capacity() const
+	{
+		return m_slots.size();
+	}
+};
+
+#endif // SWARM_SPSCRING_HPP
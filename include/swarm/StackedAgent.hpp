@@ -0,0 +1,53 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_STACKEDAGENT_HPP
+#define SWARM_STACKEDAGENT_HPP
+
+#include <swarm/Agent.hpp>
+#include <vector>
+
+/**
+ * K Agents as one module. Every Linear layer of the actor and the critic becomes a [K, in, out] weight and a
+ * [K, 1, out] bias, so a forward or backward pass of all K policies is one batched matmul per layer instead of K
+ * matmuls 64 wide. Inputs are [K, B, ...], row [k, b] belongs to policy k. Slices never mix, so one Adam over the
+ * stacked parameters steps every policy exactly like its own Adam would.
+ */
+class StackedAgent : public torch::nn::Module
+{
+public:
+	// Copies the current parameters of the agents, which all need the same layer sizes
+	explicit StackedAgent(const std::vector<Agent*>& agents);
+
+	torch::Tensor get_value(const torch::Tensor& observations); // [K, B, obs_size] -> [K, B, 1]
+	torch::Tensor actor_logits(const torch::Tensor& observations);
+	// Log probabilities and entropies of the given actions [K, B], like Agent::get_action_and_value
+	Agent::ActionDetails get_action_and_value(const torch::Tensor& observations, const torch::Tensor& actions);
+	// Inverse CDF sampling from uniform [K, B], like Agent::sample_action_and_value
+	Agent::ActionDetails sample_action_and_value(const torch::Tensor& observations, const torch::Tensor& uniform);
+
+	// Clips the gradients of every policy to max_norm on its own and returns the norms before clipping, [K]
+	torch::Tensor clip_grad_norm(double max_norm);
+	// Copies policy k back into agent
+	void unstack_into(std::size_t k, Agent& agent) const;
+
+	std::size_t num_policies() const;
+
+private:
+	struct Layer
+	{
+		torch::Tensor weight; // [K, in, out]
+		torch::Tensor bias;	  // [K, 1, out]
+	};
+
+	static torch::Tensor forward(const std::vector<Layer>& layers, torch::Tensor x);
+	Agent::ActionDetails details(const torch::Tensor& observations, const torch::Tensor& logits,
+								 const torch::Tensor& sampled_action);
+
+	std::vector<Layer> m_actor;
+	std::vector<Layer> m_critic;
+	std::size_t		   m_num_policies;
+};
+
+#endif // SWARM_STACKEDAGENT_HPP
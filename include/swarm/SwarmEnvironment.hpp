@@ -0,0 +1,103 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SWARMENVIRONMENT_HPP
+#define SWARM_SWARMENVIRONMENT_HPP
+
+#include <swarm/Environment.hpp>
+#include <swarm/SpatialHashGrid.hpp>
+#include <barrier>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * One world shared by num_agents agents which all chase the same goal. Agent state is stored as structure-of-arrays,
+ * a step consumes one action per agent from a shared policy and returns one observation row per agent, so train()
+ * treats every agent as an env. Physics and observations are computed in contiguous shards on a persistent worker
+ * pool (the calling thread works on shard 0). Between the two phases a barrier reduces the swarm centroid, which
+ * every agent observes relative to itself. With num_neighbors > 0 the same step also rebuilds a SpatialHashGrid and
+ * every observation gets a block of the num_neighbors nearest agents within k_neighbor_radius, closest first, as
+ * (dx, dy, present) relative to the perception radius and zero padded.
+ * An agent that reaches the goal respawns at a random position anywhere in the world, from its own Philox stream
+ * rng_stream + i; the others keep their episodes. The goal only moves on reset(), drawn from stream
+ * rng_stream + num_agents.
+ */
+struct SwarmEnvironment : Environment
+{
+	static constexpr std::size_t k_max_neighbors   = 16;
+	static constexpr float		 k_neighbor_radius = 100.0f;
+
+	explicit SwarmEnvironment(std::size_t num_agents, std::size_t num_workers = std::thread::hardware_concurrency(),
+							  std::size_t num_neighbors = 0);
+	~SwarmEnvironment() override;
+
+	SwarmEnvironment(const SwarmEnvironment&)			 = delete;
+	SwarmEnvironment& operator=(const SwarmEnvironment&) = delete;
+
+	std::vector<float> position_x;
+	std::vector<float> position_y;
+	std::vector<float> velocity_x;
+	std::vector<float> velocity_y;
+	std::vector<float> last_distance;
+	float			   goal_x	  = 0.0f;
+	float			   goal_y	  = 0.0f;
+	float			   centroid_x = 0.0f;
+	float			   centroid_y = 0.0f;
+	EpisodeTracker			   episodes;
+	std::uint64_t			   rng_key{std::random_device{}()};
+	std::uint64_t			   rng_stream = k_env_streams;
+	std::vector<std::uint64_t> rng_counter; // Per agent, plus the world's at the end
+
+	torch::Tensor				 get_current_observation() const;
+	StepResult					 step(const torch::Tensor& action) override;
+	void						 step_into(const StepBuffers& buffers) override;
+	std::size_t					 get_observation_size() const override;
+	std::size_t					 get_action_space_size() const override;
+	std::size_t					 get_num_envs() const override;
+	torch::Tensor				 reset() override;
+	void						 seed(std::uint64_t seed, std::uint64_t first_stream = k_env_streams) override;
+	EpisodeStats				 take_episode_stats() override;
+	bool						 save_state(torch::serialize::OutputArchive& archive) const override;
+	void						 load_state(torch::serialize::InputArchive& archive) override;
+	void						 write_snapshot(SwarmSnapshot& snapshot) const override;
+	void						 set_goal(sf::Vector2f goal) override;
+	std::unique_ptr<Environment> clone() const override;
+	std::size_t					 get_num_workers() const;
+	std::size_t					 get_num_neighbors() const;
+
+ private:
+	// Barrier completion, runs once all shards finished their physics
+	struct SyncWorld
+	{
+		SwarmEnvironment* env;
+		void			  operator()() noexcept;
+	};
+
+	void worker_loop(std::size_t worker);
+	void step_shard(std::size_t worker);
+	void observe_shard(std::size_t worker);
+	void write_observation(std::size_t i, float* row) const;
+	void update_centroid();
+	void rebuild_grid();
+	void respawn(std::size_t i);
+
+	std::size_t					 m_num_workers;
+	std::barrier<>				 m_start;
+	std::barrier<SyncWorld>		 m_physics;
+	std::barrier<>				 m_finish;
+	bool						 m_stop = false;
+	const std::int64_t*			 m_actions = nullptr;
+	float*						 m_observations = nullptr;
+	float*						 m_rewards = nullptr;
+	float*						 m_dones = nullptr;
+	std::vector<double>			 m_partial_x; // Per-shard position sums for the centroid
+	std::vector<double>			 m_partial_y;
+	std::vector<EpisodeStats>	 m_worker_episodes;
+	std::size_t					 m_num_neighbors;
+	SpatialHashGrid				 m_grid;
+	std::vector<std::jthread>	 m_threads; // Last, so the workers stop before the members they use go away
+};
+
+#endif // SWARM_SWARMENVIRONMENT_HPP
@@ -0,0 +1,44 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SWARMRENDERER_HPP
+#define SWARM_SWARMRENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+// What the viewer draws of one simulation tick, filled by Environment::write_snapshot
+struct SwarmSnapshot
+{
+	std::vector<sf::Vector2f> agents;
+	std::vector<sf::Vector2f> goals;
+	std::uint64_t			  tick = 0;
+
+	void clear();
+};
+
+/**
+ * Draws a whole snapshot with a single draw call: every agent and goal becomes a quad of two triangles in one
+ * sf::VertexArray, which is rebuilt in place by update() and keeps its capacity between frames.
+ * Agents are green 20x20 squares and goals red 10x10 squares, both anchored at their top left corner like the
+ * shapes SimpleMovingEnvironment used to draw.
+ */
+class SwarmRenderer : public sf::Drawable
+{
+ public:
+	static constexpr float k_agent_size = 20.0f;
+	static constexpr float k_goal_size	= 10.0f;
+
+	void		update(const SwarmSnapshot& snapshot);
+	std::size_t get_vertex_count() const;
+
+ protected:
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+ private:
+	sf::VertexArray m_vertices{sf::PrimitiveType::Triangles};
+};
+
+#endif // SWARM_SWARMRENDERER_HPP
@@ -0,0 +1,112 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_SWEEP_HPP
+#define SWARM_SWEEP_HPP
+
+#include <swarm/Training.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Sets the numeric TrainingConfig field `name`, integer fields are rounded. Throws std::invalid_argument for names
+// that are not sweepable, which includes num_env_workers and max_policy_lag.
+void set_config_field(TrainingConfig& config, const std::string& name, double value);
+
+/**
+ * Search space over TrainingConfig fields. With num_samples == 0 every combination of the grid values is one trial
+ * and ranges are not allowed. Otherwise it is a random search of num_samples trials, each picking one value of every
+ * grid field and drawing every range from a Philox stream of seed.
+ */
+struct SweepSpec
+{
+	struct Range
+	{
+		std::string name;
+		double		min;
+		double		max;
+		bool		log_scale = false; // Uniform in log space, for learning rates and the like
+	};
+
+	std::vector<std::pair<std::string, std::vector<double>>> grid;
+	std::vector<Range>										 ranges;
+	std::size_t												 num_samples = 0;
+	std::uint64_t											 seed		 = 0;
+};
+
+// Field name and value of every swept field of one run
+using SweepTrial = std::vector<std::pair<std::string, double>>;
+
+std::vector<SweepTrial> make_sweep_trials(const SweepSpec& spec);
+
+/**
+ * Median stopping rule. A run reports its score when it reaches a rung, and it is stopped when the score is below the
+ * median of what the other runs reported at that rung, once at least min_peers of them did. Runs that were stopped
+ * at a later rung still count, so the bar only reflects runs that got this far.
+ */
+class MedianStoppingRule
+{
+ public:
+	MedianStoppingRule(std::size_t num_rungs, std::size_t min_peers);
+
+	// Whether the run should stop
+	bool report(std::size_t rung, double score);
+
+ private:
+	std::vector<std::vector<double>> m_scores; // Per rung
+	std::size_t						 m_min_peers;
+};
+
+struct SweepOptions
+{
+	std::filesystem::path	  out_dir		= "sweep";
+	std::size_t				  cores_per_run = 1;
+	std::vector<int>		  cores{};				 // Empty takes every core this process may run on
+	std::vector<double>		  rungs{0.25, 0.5, 0.75}; // Fractions of total_timesteps, empty never stops a run
+	std::size_t				  min_peers	   = 3;
+	std::size_t				  score_window = 10; // Updates with finished episodes the score averages over
+	std::chrono::milliseconds poll_interval{500};
+};
+
+enum class SweepStatus
+{
+	Finished,
+	Stopped, // By the stopping rule
+	Failed,
+};
+
+struct SweepResult
+{
+	std::size_t trial = 0;
+	SweepTrial	parameters;
+	SweepStatus status		= SweepStatus::Failed;
+	long		global_step = 0;
+	double		score		= 0.0; // Mean episode return over the last score_window updates with episodes, NaN if none
+	double		sps			= 0.0;
+	double		time_s		= 0.0;
+};
+
+// Builds a run's env, vectorized envs need the trial's num_envs
+using EnvFactory = std::function<std::unique_ptr<Environment>(const TrainingConfig&)>;
+
+/**
+ * Runs every trial as its own forked training process, pinned to a disjoint set of cores_per_run cores with
+ * libtorch's intra-op pool sized to match, so cores.size() / cores_per_run runs share the machine without
+ * oversubscribing it and a slot is refilled as soon as its run ends. Runs are followed through their metrics files,
+ * losing ones are stopped by a MedianStoppingRule over the options' rungs to free their cores early.
+ *
+ * out_dir gets run_<i>.csv (metrics), run_<i>.log (stdout and stderr) and results.csv, the table that is also
+ * returned in trial order. Call it before this process ran anything on libtorch's thread pools, they do not survive
+ * fork().
+ */
+std::vector<SweepResult> run_sweep(const TrainingConfig& base, const SweepSpec& spec, const EnvFactory& make_env,
+								   const SweepOptions& options = {});
+
+#endif // SWARM_SWEEP_HPP
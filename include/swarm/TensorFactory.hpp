@@ -24,6 +24,7 @@ class TensorFactory
 	}
 public:
 	static TensorFactory& instance();
+	torch::Device device() const;
 	torch::nn::Linear create_linear(std::size_t in, std::size_t out, float std=std::sqrt(2.0f)) const;
 };
 
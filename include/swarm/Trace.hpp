@@ -0,0 +1,86 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_TRACE_HPP
+#define SWARM_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Scoped timers for the training hot path. SWARM_TRACE_SCOPE records one complete event into a thread-local buffer
+// while tracing is enabled at runtime, and compiles to nothing when the build has ENABLE_TRACING=OFF.
+#ifdef SWARM_ENABLE_TRACING
+inline constexpr bool k_tracing_compiled = true;
+#define SWARM_TRACE_CONCAT_(a, b) a##b
+#define SWARM_TRACE_CONCAT(a, b)  SWARM_TRACE_CONCAT_(a, b)
+// name must be a string literal, only the pointer is stored
+#define SWARM_TRACE_SCOPE(name) TraceScope SWARM_TRACE_CONCAT(swarm_trace_scope_, __COUNTER__){name}
+#else
+inline constexpr bool k_tracing_compiled = false;
+#define SWARM_TRACE_SCOPE(name) ((void)0)
+#endif
+
+inline std::atomic<bool> g_tracing_enabled{false};
+
+inline bool tracing_enabled()
+{
+	return g_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+inline std::int64_t trace_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+void record_trace_event(const char* name, std::int64_t start_ns, std::int64_t end_ns);
+
+class TraceScope
+{
+	const char*	 m_name;
+	std::int64_t m_start;
+
+ public:
+	explicit TraceScope(const char* name)
+		: m_name(name)
+		, m_start(tracing_enabled() ? trace_now_ns() : -1)
+	{
+	}
+	~TraceScope()
+	{
+		if (m_start >= 0)
+		{
+			record_trace_event(m_name, m_start, trace_now_ns());
+		}
+	}
+	TraceScope(const TraceScope&)			 = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// Drops all recorded events and starts recording
+void start_tracing();
+void stop_tracing();
+
+// Label for the calling thread in the exported trace
+void set_trace_thread_name(std::string name);
+
+struct TracePhase
+{
+	std::string	 name;
+	std::int64_t total_ns;
+	long		 count;
+};
+
+// Total time per event name over all threads for events that started at or after since_ns, longest first
+std::vector<TracePhase> trace_summary(std::int64_t since_ns = 0);
+
+// Chrome trace event JSON, open it in chrome://tracing or ui.perfetto.dev
+void write_chrome_trace(const std::filesystem::path& path);
+
+#endif // SWARM_TRACE_HPP
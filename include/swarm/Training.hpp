@@ -6,13 +6,17 @@
 #define SWARM_TRAINING_HPP
 #include <swarm/Agent.hpp>
 #include <swarm/Environment.hpp>
+#include <filesystem>
 #include <memory>
+#include <optional>
 
 
 struct MultiEnv :  Environment
 {
 	std::vector<std::unique_ptr<Environment>> envs;
+	EpisodeTracker							  episodes;
 	MultiEnv(std::unique_ptr<Environment> env, std::size_t num_envs)
+		: episodes(num_envs)
 	{
 		for (std::size_t i = 0; i < num_envs-1; i++)
 		{
@@ -22,32 +26,15 @@ struct MultiEnv :  Environment
 	}
 	StepResult step(const torch::Tensor& action) override
 	{
-		std::vector<torch::Tensor> observations;
-		std::vector<torch::Tensor> rewards;
-		std::vector<torch::Tensor> dones;
-		observations.reserve(envs.size());
-		rewards.reserve(envs.size());
-		dones.reserve(envs.size());
+		return step_buffered(action);
+	}
+	void step_into(const StepBuffers& buffers) override
+	{
+		check_buffers(buffers);
 		for (std::size_t i = 0; i < envs.size(); i++)
 		{
-			auto res = envs[i]->step(action[i]);
-
-			auto done_val = res.done.item<long>();
-			dones.push_back(res.done);
-			rewards.push_back(res.reward);
-
-			if (done_val != 0) {
-				// episode ended — reset immediately for next timestep
-				observations.push_back(envs[i]->reset());
-			} else {
-				observations.push_back(res.observations);
-			}
+			step_env(i, buffers, episodes.finished);
 		}
-		return {
-			torch::stack(observations),
-			torch::stack(rewards),
-			torch::stack(dones)
-		};
 	}
 	std::size_t								  get_observation_size() const override
 	{
@@ -58,20 +45,95 @@ struct MultiEnv :  Environment
 		return envs[0]->get_action_space_size();
 
 	}
+	std::size_t								  get_num_envs() const override
+	{
+		return envs.size();
+	}
+	EpisodeStats							  take_episode_stats() override
+	{
+		return episodes.take();
+	}
+	bool									  save_state(torch::serialize::OutputArchive& archive) const override
+	{
+		for (std::size_t i = 0; i < envs.size(); i++)
+		{
+			torch::serialize::OutputArchive env_archive;
+			if (!envs[i]->save_state(env_archive))
+			{
+				return false;
+			}
+			archive.write(std::format("env{}", i), env_archive);
+		}
+		return true;
+	}
+	void									  load_state(torch::serialize::InputArchive& archive) override
+	{
+		for (std::size_t i = 0; i < envs.size(); i++)
+		{
+			torch::serialize::InputArchive env_archive;
+			archive.read(std::format("env{}", i), env_archive);
+			envs[i]->load_state(env_archive);
+		}
+	}
+	void									  seed(std::uint64_t seed, std::uint64_t first_stream = k_env_streams) override
+	{
+		for (std::size_t i = 0; i < envs.size(); i++)
+		{
+			envs[i]->seed(seed, first_stream + i);
+		}
+	}
+	void									  write_snapshot(SwarmSnapshot& snapshot) const override
+	{
+		for (const auto& env : envs)
+		{
+			env->write_snapshot(snapshot);
+		}
+	}
+	void									  set_goal(sf::Vector2f goal) override
+	{
+		for (auto& env : envs)
+		{
+			env->set_goal(goal);
+		}
+	}
 	std::unique_ptr<Environment>			  clone() const override
 	{
 		return nullptr; // Unused
 	}
 	torch::Tensor									  reset() override
 	{
-		std::vector<torch::Tensor> observations;
-		observations.reserve(envs.size());
+		auto observations = torch::empty(
+			{static_cast<long>(envs.size()), static_cast<long>(get_observation_size())}, torch::kFloat32);
+		reset_into({observations.data_ptr<float>(), static_cast<std::size_t>(observations.numel())});
+		return observations;
+	}
+	void reset_into(std::span<float> observations) override
+	{
+		const std::size_t obs_size = get_observation_size();
+		check_observations(observations);
+		for (std::size_t i = 0; i < envs.size(); i++)
+		{
+			episodes.reset_env(i);
+			envs[i]->reset_into(observations.subspan(i * obs_size, obs_size));
+		}
+	}
 
-		for (auto& env : envs)
+ protected:
+	// Steps env i on its row of the buffers, a finished env is reset and its row gets the next episode's observation.
+	// Finished episodes go into `finished`, so the shards of ParallelMultiEnv can keep their own.
+	void step_env(std::size_t i, const StepBuffers& buffers, EpisodeStats& finished)
+	{
+		const std::size_t obs_size	  = get_observation_size();
+		const auto		  observation = buffers.observations.subspan(i * obs_size, obs_size);
+		envs[i]->step_into({buffers.actions.subspan(i, 1), observation, buffers.rewards.subspan(i, 1),
+							buffers.dones.subspan(i, 1)});
+		const bool done = buffers.dones[i] != 0.0f;
+		episodes.step(i, buffers.rewards[i], done, finished);
+		if (done)
 		{
-			observations.push_back(env->reset());
+			// episode ended — reset immediately for next timestep
+			envs[i]->reset_into(observation);
 		}
-		return torch::stack(observations);
 	}
 };
 
@@ -88,8 +150,32 @@ struct TrainingConfig {
 	float vf_coef = 0.5f;
 	float ent_coef = 0.01f;
 	float max_grad_norm = 0.5f;
+	long num_env_workers = 1; // >1 steps non-vectorized envs on a persistent thread pool (ParallelMultiEnv)
+	std::optional<std::uint64_t> seed{}; // Seeds torch and the Philox streams of envs, sampling and shuffles, unset draws one
+	bool pipelined = false; // Collect the next rollout on an actor thread while the learner updates
+	long max_policy_lag = 1; // Updates the actor's policy snapshot may trail the learner by, 0 or 1 (train() throws otherwise)
+	long num_actor_processes = 0; // >0 collects rollouts in forked processes over shared memory, num_envs must split evenly
+	torch::ScalarType obs_dtype = torch::kFloat32; // Rollout storage type, kBFloat16/kHalf halve the memory
+	torch::ScalarType value_dtype = torch::kFloat32;
+	bool fused_inference = false; // Sample rollout actions with the libtorch-free FusedActorCritic on the CPU
+	std::optional<torch::Device> device{}; // Defaults to the device TensorFactory picked
+	int intra_op_threads = 0; // libtorch thread pools, 0 keeps libtorch's default. Env workers are separate.
+	int inter_op_threads = 0;
+	bool bf16_autocast = false; // Forward passes in bf16, worth it on CPUs with AVX512-BF16/AMX
+	bool fused_ppo_loss = false; // Loss and its gradients in a single pass (CPU), see PpoLoss.hpp
+	std::filesystem::path trace_path{}; // Chrome trace of the SWARM_TRACE_SCOPE phases plus a breakdown in the log, empty disables
+	std::filesystem::path metrics_path{}; // Per-update metrics as JSON lines (CSV for .csv), written off-thread, empty disables
+	long checkpoint_interval = 0; // Updates between checkpoints (and one at the end), written off-thread, 0 disables
+	std::filesystem::path checkpoint_path = "checkpoint.pt";
+	bool resume = false; // Continue from checkpoint_path when it exists, bit-exact for non-pipelined runs
+	std::filesystem::path trajectory_path{}; // Every collected step (with positions for drawable envs), see TrajectoryRecorder, empty disables
 };
 
 void train(Agent& agent, std::unique_ptr<Environment> env, const TrainingConfig& config={});
+// Trains agents[k] on envs[k] (num_envs each) for every k at once as one StackedAgent, so K small policies cost about
+// as much as one wide one. Every policy trains for total_timesteps, as long as train() would train it alone.
+// Synchronous only: no pipelining, actor processes, checkpoints, metrics or trajectories.
+void train_population(const std::vector<Agent*>& agents, std::vector<std::unique_ptr<Environment>> envs,
+					  const TrainingConfig& config = {});
 
 #endif // SWARM_TRAINING_HPP
\ No newline at end of file
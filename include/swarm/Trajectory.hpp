@@ -0,0 +1,178 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_TRAJECTORY_HPP
+#define SWARM_TRAJECTORY_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+struct SwarmSnapshot;
+
+// One step of every env handed to TrajectoryRecorder::record, each pointer covers num_envs rows
+struct TrajectoryRow
+{
+	const float*		observations; // [num_envs, obs_size]
+	const std::int64_t* actions;
+	const float*		logprobs;
+	const float*		values;
+	const float*		rewards;
+	const float*		dones;			   // Whether the step ended the episode, nonzero is true
+	const float*		positions = nullptr; // [num_envs, 4] agent x, y and goal x, y, only read when recorded
+};
+
+/**
+ * Zero-copy view of consecutive steps within one chunk of a recording, every column is [num_steps, num_envs(, width)]
+ * row major. Actions are stored as int32 and dones as bytes, positions is empty when they were not recorded.
+ */
+struct TrajectorySlice
+{
+	std::size_t						first_step = 0;
+	std::size_t						num_steps  = 0;
+	std::span<const float>			observations;
+	std::span<const std::int32_t>	actions;
+	std::span<const float>			logprobs;
+	std::span<const float>			values;
+	std::span<const float>			rewards;
+	std::span<const std::uint8_t>	dones;
+	std::span<const float>			positions;
+};
+
+// Column offsets of one chunk, shared by the recorder and the reader. Defined in Trajectory.cpp.
+struct TrajectoryLayout
+{
+	std::size_t obs_size;
+	std::size_t num_envs;
+	std::size_t steps_per_chunk;
+	bool		has_positions;
+	std::size_t observations;
+	std::size_t actions;
+	std::size_t logprobs;
+	std::size_t values;
+	std::size_t rewards;
+	std::size_t dones;
+	std::size_t positions;
+	std::size_t chunk_bytes; // Whole pages, so every chunk can be mapped on its own
+
+	TrajectoryLayout(std::size_t num_envs, std::size_t obs_size, std::size_t steps_per_chunk, bool has_positions);
+	TrajectorySlice slice(const std::byte* chunk, std::size_t first_step, std::size_t row, std::size_t count) const;
+};
+
+/**
+ * Streams steps into a chunked columnar file: a header page followed by fixed size chunks of steps_per_chunk
+ * steps, each holding one column per field. record() copies a step straight into a chunk which is mmap'd ahead of
+ * time. Full chunks go to a background flusher which syncs and unmaps them, preallocates and maps the next ones and
+ * advances the step count in the header, so the step loop never touches the disk and a crash leaves a readable
+ * prefix. The step loop only waits when the disk falls more than k_chunks_ahead chunks behind; those waits are
+ * counted.
+ *
+ * record() and close() must be called from one thread.
+ */
+class TrajectoryRecorder
+{
+ public:
+	static constexpr std::uint32_t k_version	  = 1;
+	static constexpr std::size_t   k_chunks_ahead = 4;
+
+	TrajectoryRecorder(const std::filesystem::path& path, std::size_t num_envs, std::size_t obs_size,
+					   bool with_positions = false, std::size_t steps_per_chunk = 256);
+	// Closes the recording, errors are lost, call close() to see them
+	~TrajectoryRecorder();
+
+	TrajectoryRecorder(const TrajectoryRecorder&)			 = delete;
+	TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+	// Rethrows the error of an earlier flush
+	void record(const TrajectoryRow& row);
+	// Flushes the last partial chunk, trims the preallocated tail and waits for the disk. Rethrows flush errors.
+	void close();
+
+	std::size_t get_num_steps() const;
+	std::size_t get_num_envs() const;
+	std::size_t get_observation_size() const;
+	bool		has_positions() const;
+	std::size_t get_num_stalls() const;
+
+ private:
+	struct Chunk
+	{
+		std::byte*	data  = nullptr;
+		std::size_t index = 0;
+		std::size_t steps = 0;
+	};
+
+	void run();
+	void flush(const Chunk& chunk);
+	void map_next_chunk();
+	void acquire_chunk();
+	void rethrow_error(); // Needs m_mutex
+	void finish();
+
+	TrajectoryLayout		m_layout;
+	int						m_fd	 = -1;
+	std::byte*				m_header = nullptr;
+	Chunk					m_current;
+	std::size_t				m_num_steps	 = 0;
+	std::size_t				m_num_stalls = 0;
+	bool					m_closed	 = false;
+	std::mutex				m_mutex;
+	std::condition_variable m_cv;
+	std::deque<Chunk>		m_ready; // Mapped and preallocated, written by the flusher
+	std::deque<Chunk>		m_full;	 // Waiting to be flushed, written by record()
+	std::size_t				m_next_chunk	= 0; // Flusher only
+	std::size_t				m_flushed_steps = 0; // Flusher only
+	bool					m_failed		= false; // Flusher only, set by the first error and never cleared
+	bool					m_closing		= false;
+	std::exception_ptr		m_error;
+	std::jthread			m_thread; // Last, so it is joined before the members it uses go away
+};
+
+/**
+ * Read-only view of a recording, also of one that is still being written (up to its last flushed chunk). The file
+ * is mmap'd as a whole, so step() and slice() are random access over recordings far larger than memory and only
+ * the touched pages are read.
+ */
+class TrajectoryReader
+{
+ public:
+	explicit TrajectoryReader(const std::filesystem::path& path);
+	~TrajectoryReader();
+
+	TrajectoryReader(const TrajectoryReader&)			 = delete;
+	TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+	TrajectorySlice step(std::size_t step) const;
+	// Steps [first_step, first_step + count) as one view per chunk they touch
+	std::vector<TrajectorySlice> slice(std::size_t first_step, std::size_t count) const;
+	// Whole chunk i, the natural unit for scanning a recording front to back
+	TrajectorySlice chunk(std::size_t index) const;
+	// Asks the kernel to read steps [first_step, first_step + count) ahead, e.g. before a replay reaches them
+	void prefetch(std::size_t first_step, std::size_t count) const;
+	// Agents and goals of one step for the viewer, needs a recording with positions
+	void write_snapshot(std::size_t step, SwarmSnapshot& snapshot) const;
+
+	std::size_t get_num_steps() const;
+	std::size_t get_num_chunks() const;
+	std::size_t get_num_envs() const;
+	std::size_t get_observation_size() const;
+	bool		has_positions() const;
+
+ private:
+	const std::byte* chunk_data(std::size_t index) const;
+
+	const std::byte* m_mapping = nullptr;
+	std::size_t		 m_size	   = 0;
+	std::size_t		 m_num_steps{};
+	TrajectoryLayout m_layout{1, 1, 1, false};
+};
+
+#endif // SWARM_TRAJECTORY_HPP
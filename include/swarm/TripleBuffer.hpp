@@ -0,0 +1,68 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#ifndef SWARM_TRIPLEBUFFER_HPP
+#define SWARM_TRIPLEBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free hand-off of the latest value from one producer to one consumer thread. The producer fills back() and
+ * publish() swaps it with the shared middle slot, the consumer's update() swaps the middle slot with front() when
+ * it holds something newer. Neither side ever waits or sees a half written value. Intermediate values the
+ * consumer did not pick up in time are dropped, which is what a viewer of a faster simulation wants.
+ */
+template <typename T>
+class TripleBuffer
+{
+	static constexpr std::uint8_t k_index = 0b011;
+	static constexpr std::uint8_t k_fresh = 0b100; // Set on the middle slot until the consumer took it
+
+	std::array<T, 3>					 m_slots{};
+	alignas(64) std::atomic<std::uint8_t> m_middle{1};
+	alignas(64) std::uint8_t			 m_back	 = 0; // Producer only
+	alignas(64) std::uint8_t			 m_front = 2; // Consumer only
+
+ public:
+	TripleBuffer() = default;
+	explicit TripleBuffer(const T& initial)
+		: m_slots{initial, initial, initial}
+	{
+	}
+
+	// Producer only, the slot to fill, it still holds whatever value was in it before
+	T& back()
+	{
+		return m_slots[m_back];
+	}
+
+	// Producer only, makes back() the latest value and hands the producer a free slot
+	void publish()
+	{
+		const auto previous = m_middle.exchange(m_back | k_fresh, std::memory_order_acq_rel);
+		m_back				= previous & k_index;
+	}
+
+	// Consumer only, moves the latest published value into front(), false when nothing new was published
+	bool update()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & k_fresh) == 0)
+		{
+			return false;
+		}
+		const auto previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+		m_front				= previous & k_index;
+		return true;
+	}
+
+	// Consumer only
+	const T& front() const
+	{
+		return m_slots[m_front];
+	}
+};
+
+#endif // SWARM_TRIPLEBUFFER_HPP
@@ -2,3 +2,65 @@
 // Created by chris on 11/12/25.
 //
 #include <swarm/Agent.hpp>
+
+void Agent::pack_into(FusedActorCritic& kernel) const
+{
+	// Linear layers sit at index 0, 2 and 4 of both Sequentials, the Tanhs in between have no parameters
+	for (std::size_t layer = 0; layer < 3; layer++)
+	{
+		const auto index = std::to_string(layer * 2);
+		for (const auto* network : {&m_actor, &m_critic})
+		{
+			auto params = (*network)->named_parameters();
+			auto weight = params[index + ".weight"].detach().to(torch::kCPU, torch::kFloat32).contiguous();
+			auto bias	= params[index + ".bias"].detach().to(torch::kCPU, torch::kFloat32).contiguous();
+			if (network == &m_actor)
+			{
+				kernel.set_actor_layer(layer, weight.data_ptr<float>(), bias.data_ptr<float>());
+			}
+			else
+			{
+				kernel.set_critic_layer(layer, weight.data_ptr<float>(), bias.data_ptr<float>());
+			}
+		}
+	}
+}
+
+FusedActorCritic Agent::make_fused() const
+{
+	auto first_layer = m_actor->named_parameters()["0.weight"];
+	auto last_layer	 = m_actor->named_parameters()["4.weight"];
+	FusedActorCritic kernel(first_layer.size(1), first_layer.size(0), last_layer.size(0));
+	pack_into(kernel);
+	return kernel;
+}
+
+std::vector<FrozenLayerSpec> Agent::actor_layers(std::vector<torch::Tensor>& tensors) const
+{
+	auto params = m_actor->named_parameters();
+	std::vector<FrozenLayerSpec> layers;
+	for (std::size_t layer = 0; layer < 3; layer++)
+	{
+		const auto index  = std::to_string(layer * 2);
+		auto	   weight = params[index + ".weight"].detach().to(torch::kCPU, torch::kFloat32).contiguous();
+		auto	   bias	  = params[index + ".bias"].detach().to(torch::kCPU, torch::kFloat32).contiguous();
+		layers.push_back({static_cast<std::size_t>(weight.size(1)), static_cast<std::size_t>(weight.size(0)),
+						  layer < 2 ? Activation::Tanh : Activation::None, weight.data_ptr<float>(),
+						  bias.data_ptr<float>()});
+		tensors.push_back(std::move(weight));
+		tensors.push_back(std::move(bias));
+	}
+	return layers;
+}
+
+void Agent::export_frozen(const std::filesystem::path& path) const
+{
+	std::vector<torch::Tensor> tensors;
+	write_frozen_policy(path, actor_layers(tensors));
+}
+
+QuantizedPolicy Agent::quantize_actor(std::span<const float> calibration) const
+{
+	std::vector<torch::Tensor> tensors;
+	return QuantizedPolicy(actor_layers(tensors), calibration);
+}
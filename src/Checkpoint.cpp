@@ -0,0 +1,176 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/Checkpoint.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+void write_rng(torch::serialize::OutputArchive& archive, const std::string& key, const Philox& rng)
+{
+	const auto state = rng.get_state();
+	write_counters(archive, key, {state.begin(), state.end()});
+}
+
+void read_rng(torch::serialize::InputArchive& archive, const std::string& key, Philox& rng)
+{
+	std::vector<std::uint64_t> values(std::tuple_size_v<Philox::State>);
+	read_counters(archive, key, values);
+	Philox::State state;
+	std::copy(values.begin(), values.end(), state.begin());
+	rng.set_state(state);
+}
+
+void write_floats(torch::serialize::OutputArchive& archive, const std::string& key, const std::vector<float>& values)
+{
+	auto tensor = torch::from_blob(const_cast<float*>(values.data()), {static_cast<long>(values.size())},
+								   torch::kFloat32);
+	archive.write(key, tensor.clone());
+}
+
+void read_floats(torch::serialize::InputArchive& archive, const std::string& key, std::vector<float>& values)
+{
+	torch::Tensor tensor;
+	archive.read(key, tensor);
+	if (tensor.numel() != static_cast<long>(values.size()))
+	{
+		throw std::runtime_error(
+			std::format("Checkpoint field '{}' has {} values, expected {}", key, tensor.numel(), values.size()));
+	}
+	tensor = tensor.to(torch::kFloat32).contiguous();
+	std::copy_n(tensor.data_ptr<float>(), values.size(), values.begin());
+}
+
+void write_counters(torch::serialize::OutputArchive& archive, const std::string& key,
+					const std::vector<std::uint64_t>& values)
+{
+	auto tensor = torch::empty({static_cast<long>(values.size())}, torch::kLong);
+	std::copy(values.begin(), values.end(), reinterpret_cast<std::uint64_t*>(tensor.data_ptr<std::int64_t>()));
+	archive.write(key, tensor);
+}
+
+void read_counters(torch::serialize::InputArchive& archive, const std::string& key, std::vector<std::uint64_t>& values)
+{
+	torch::Tensor tensor;
+	archive.read(key, tensor);
+	if (tensor.numel() != static_cast<long>(values.size()) || tensor.scalar_type() != torch::kLong)
+	{
+		throw std::runtime_error(std::format("Checkpoint field '{}' has {} values, expected {} int64", key,
+											 tensor.numel(), values.size()));
+	}
+	tensor = tensor.contiguous();
+	const auto* data = reinterpret_cast<const std::uint64_t*>(tensor.data_ptr<std::int64_t>());
+	std::copy_n(data, values.size(), values.begin());
+}
+
+static void fsync_path(const std::filesystem::path& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		throw std::runtime_error(std::format("Could not open {} to sync it", path.string()));
+	}
+	const int result = ::fsync(fd);
+	::close(fd);
+	if (result != 0)
+	{
+		throw std::runtime_error(std::format("fsync of {} failed", path.string()));
+	}
+}
+
+CheckpointWriter::CheckpointWriter(std::filesystem::path path)
+	: m_path(std::move(path))
+	, m_thread([this](std::stop_token stop) { run(std::move(stop)); })
+{
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	// The writer finishes the pending checkpoint before it stops, a clean shutdown must not lose the last one
+	m_thread.request_stop();
+}
+
+void CheckpointWriter::run(std::stop_token stop)
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock lock(m_mutex);
+			m_cv.wait(lock, stop, [&] { return static_cast<bool>(m_pending); });
+			if (!m_pending)
+			{
+				return;
+			}
+			job		  = std::exchange(m_pending, nullptr);
+			m_writing = true;
+		}
+		std::exception_ptr error;
+		try
+		{
+			write(job);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		{
+			std::lock_guard lock(m_mutex);
+			m_writing = false;
+			m_written += error ? 0 : 1;
+			if (error)
+			{
+				m_error = error;
+			}
+		}
+		m_cv.notify_all();
+	}
+}
+
+void CheckpointWriter::write(const Job& job)
+{
+	torch::serialize::OutputArchive archive;
+	job(archive);
+
+	auto tmp_path = m_path;
+	tmp_path += ".tmp";
+	archive.save_to(tmp_path.string());
+	fsync_path(tmp_path);
+	std::filesystem::rename(tmp_path, m_path);
+	// The rename itself is only durable once the directory entry is synced
+	fsync_path(m_path.has_parent_path() ? m_path.parent_path() : std::filesystem::path("."));
+}
+
+void CheckpointWriter::rethrow_error()
+{
+	if (m_error)
+	{
+		std::rethrow_exception(std::exchange(m_error, nullptr));
+	}
+}
+
+void CheckpointWriter::submit(Job job)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		rethrow_error();
+		m_pending = std::move(job);
+	}
+	m_cv.notify_all();
+}
+
+void CheckpointWriter::wait()
+{
+	std::unique_lock lock(m_mutex);
+	m_cv.wait(lock, [&] { return !m_pending && !m_writing; });
+	rethrow_error();
+}
+
+const std::filesystem::path& CheckpointWriter::path() const
+{
+	return m_path;
+}
+long CheckpointWriter::get_num_written() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_written;
+}
@@ -0,0 +1,409 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/DenseKernels.hpp>
+#include <algorithm>
+#include <cstring>
+
+// On x86-64 with GCC or Clang every SIMD kernel is compiled for its own ISA with a target attribute and the best one
+// the CPU supports is picked on first use, so the default build runs them without ENABLE_NATIVE_ARCH. Other builds
+// run the portable loops.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SWARM_KERNEL_DISPATCH 1
+#define SWARM_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Outputs j .. cols of dense_forward, all of them in the portable kernel and the leftovers in the SIMD ones
+static void dense_forward_tail(std::size_t j, const float* x, std::size_t in, const float* w, std::size_t ld,
+							   const float* bias, std::size_t cols, float* y)
+{
+	for (; j < cols; j++)
+	{
+		float acc = bias[j];
+		for (std::size_t k = 0; k < in; k++)
+		{
+			acc += x[k] * w[k * ld + j];
+		}
+		y[j] = acc;
+	}
+}
+
+static void dense_forward_scalar(const float* x, std::size_t in, const float* w, std::size_t ld, const float* bias,
+								 std::size_t cols, float* y)
+{
+	dense_forward_tail(0, x, in, w, ld, bias, cols, y);
+}
+
+#ifdef SWARM_KERNEL_DISPATCH
+SWARM_TARGET("avx512f")
+static void dense_forward_avx512(const float* x, std::size_t in, const float* w, std::size_t ld, const float* bias,
+								 std::size_t cols, float* y)
+{
+	std::size_t j = 0;
+	// Four accumulators per sweep hide the FMA latency
+	for (; j + 64 <= cols; j += 64)
+	{
+		__m512 acc0 = _mm512_loadu_ps(bias + j);
+		__m512 acc1 = _mm512_loadu_ps(bias + j + 16);
+		__m512 acc2 = _mm512_loadu_ps(bias + j + 32);
+		__m512 acc3 = _mm512_loadu_ps(bias + j + 48);
+		for (std::size_t k = 0; k < in; k++)
+		{
+			const __m512 xk	 = _mm512_set1_ps(x[k]);
+			const float* row = w + k * ld + j;
+			acc0			 = _mm512_fmadd_ps(xk, _mm512_loadu_ps(row), acc0);
+			acc1			 = _mm512_fmadd_ps(xk, _mm512_loadu_ps(row + 16), acc1);
+			acc2			 = _mm512_fmadd_ps(xk, _mm512_loadu_ps(row + 32), acc2);
+			acc3			 = _mm512_fmadd_ps(xk, _mm512_loadu_ps(row + 48), acc3);
+		}
+		_mm512_storeu_ps(y + j, acc0);
+		_mm512_storeu_ps(y + j + 16, acc1);
+		_mm512_storeu_ps(y + j + 32, acc2);
+		_mm512_storeu_ps(y + j + 48, acc3);
+	}
+	for (; j + 16 <= cols; j += 16)
+	{
+		__m512 acc = _mm512_loadu_ps(bias + j);
+		for (std::size_t k = 0; k < in; k++)
+		{
+			acc = _mm512_fmadd_ps(_mm512_set1_ps(x[k]), _mm512_loadu_ps(w + k * ld + j), acc);
+		}
+		_mm512_storeu_ps(y + j, acc);
+	}
+	dense_forward_tail(j, x, in, w, ld, bias, cols, y);
+}
+
+SWARM_TARGET("avx2,fma")
+static void dense_forward_avx2(const float* x, std::size_t in, const float* w, std::size_t ld, const float* bias,
+							   std::size_t cols, float* y)
+{
+	std::size_t j = 0;
+	for (; j + 32 <= cols; j += 32)
+	{
+		__m256 acc0 = _mm256_loadu_ps(bias + j);
+		__m256 acc1 = _mm256_loadu_ps(bias + j + 8);
+		__m256 acc2 = _mm256_loadu_ps(bias + j + 16);
+		__m256 acc3 = _mm256_loadu_ps(bias + j + 24);
+		for (std::size_t k = 0; k < in; k++)
+		{
+			const __m256 xk	 = _mm256_set1_ps(x[k]);
+			const float* row = w + k * ld + j;
+			acc0			 = _mm256_fmadd_ps(xk, _mm256_loadu_ps(row), acc0);
+			acc1			 = _mm256_fmadd_ps(xk, _mm256_loadu_ps(row + 8), acc1);
+			acc2			 = _mm256_fmadd_ps(xk, _mm256_loadu_ps(row + 16), acc2);
+			acc3			 = _mm256_fmadd_ps(xk, _mm256_loadu_ps(row + 24), acc3);
+		}
+		_mm256_storeu_ps(y + j, acc0);
+		_mm256_storeu_ps(y + j + 8, acc1);
+		_mm256_storeu_ps(y + j + 16, acc2);
+		_mm256_storeu_ps(y + j + 24, acc3);
+	}
+	for (; j + 8 <= cols; j += 8)
+	{
+		__m256 acc = _mm256_loadu_ps(bias + j);
+		for (std::size_t k = 0; k < in; k++)
+		{
+			acc = _mm256_fmadd_ps(_mm256_set1_ps(x[k]), _mm256_loadu_ps(w + k * ld + j), acc);
+		}
+		_mm256_storeu_ps(y + j, acc);
+	}
+	dense_forward_tail(j, x, in, w, ld, bias, cols, y);
+}
+#endif
+
+using DenseForward = void (*)(const float*, std::size_t, const float*, std::size_t, const float*, std::size_t, float*);
+
+struct DenseKernel
+{
+	const char*	 isa;
+	DenseForward forward;
+};
+
+static DenseKernel select_dense_kernel()
+{
+#ifdef SWARM_KERNEL_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return {"avx512", dense_forward_avx512};
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return {"avx2", dense_forward_avx2};
+	}
+#endif
+	return {"scalar", dense_forward_scalar};
+}
+
+static const DenseKernel& dense_kernel()
+{
+	static const DenseKernel kernel = select_dense_kernel();
+	return kernel;
+}
+
+void dense_forward(const float* x, std::size_t in, const float* w, std::size_t ld, const float* bias,
+				   std::size_t cols, float* y)
+{
+	dense_kernel().forward(x, in, w, ld, bias, cols, y);
+}
+
+const char* dense_kernel_isa()
+{
+	return dense_kernel().isa;
+}
+
+// Outputs j .. cols of dense_forward_u8s8
+static void dense_forward_u8s8_tail(std::size_t j, const std::uint8_t* x, std::size_t in, const std::int8_t* w,
+									std::size_t cols, std::int32_t* acc)
+{
+	const std::size_t groups = in / k_int8_group;
+	for (; j < cols; j++)
+	{
+		std::int32_t sum = 0;
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			const std::int8_t* wj = w + (g * cols + j) * k_int8_group;
+			for (std::size_t t = 0; t < k_int8_group; t++)
+			{
+				sum += std::int32_t{x[g * k_int8_group + t]} * std::int32_t{wj[t]};
+			}
+		}
+		acc[j] = sum;
+	}
+}
+
+static void dense_forward_u8s8_scalar(const std::uint8_t* x, std::size_t in, const std::int8_t* w, std::size_t cols,
+									  std::int32_t* acc)
+{
+	dense_forward_u8s8_tail(0, x, in, w, cols, acc);
+}
+
+#ifdef SWARM_KERNEL_DISPATCH
+// The four inputs of group g as one 32-bit word, what vpdpbusd broadcasts
+static std::int32_t load_group(const std::uint8_t* x, std::size_t g)
+{
+	std::int32_t word;
+	std::memcpy(&word, x + g * k_int8_group, sizeof(word));
+	return word;
+}
+
+SWARM_TARGET("avx512f,avx512vnni")
+static void dense_forward_u8s8_avx512_vnni(const std::uint8_t* x, std::size_t in, const std::int8_t* w,
+										   std::size_t cols, std::int32_t* acc)
+{
+	const std::size_t groups = in / k_int8_group;
+	std::size_t		  j		 = 0;
+	// Every 32-bit lane sums its output's four products of a group, 16 outputs per register
+	for (; j + 64 <= cols; j += 64)
+	{
+		__m512i acc0 = _mm512_setzero_si512();
+		__m512i acc1 = _mm512_setzero_si512();
+		__m512i acc2 = _mm512_setzero_si512();
+		__m512i acc3 = _mm512_setzero_si512();
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			const __m512i		xg	= _mm512_set1_epi32(load_group(x, g));
+			const std::int8_t* row = w + (g * cols + j) * k_int8_group;
+			acc0					= _mm512_dpbusd_epi32(acc0, xg, _mm512_loadu_si512(row));
+			acc1					= _mm512_dpbusd_epi32(acc1, xg, _mm512_loadu_si512(row + 64));
+			acc2					= _mm512_dpbusd_epi32(acc2, xg, _mm512_loadu_si512(row + 128));
+			acc3					= _mm512_dpbusd_epi32(acc3, xg, _mm512_loadu_si512(row + 192));
+		}
+		_mm512_storeu_si512(acc + j, acc0);
+		_mm512_storeu_si512(acc + j + 16, acc1);
+		_mm512_storeu_si512(acc + j + 32, acc2);
+		_mm512_storeu_si512(acc + j + 48, acc3);
+	}
+	for (; j + 16 <= cols; j += 16)
+	{
+		__m512i sum = _mm512_setzero_si512();
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			sum = _mm512_dpbusd_epi32(sum, _mm512_set1_epi32(load_group(x, g)),
+									  _mm512_loadu_si512(w + (g * cols + j) * k_int8_group));
+		}
+		_mm512_storeu_si512(acc + j, sum);
+	}
+	dense_forward_u8s8_tail(j, x, in, w, cols, acc);
+}
+
+SWARM_TARGET("avx2,avxvnni")
+static void dense_forward_u8s8_avx_vnni(const std::uint8_t* x, std::size_t in, const std::int8_t* w, std::size_t cols,
+										std::int32_t* acc)
+{
+	const std::size_t groups = in / k_int8_group;
+	std::size_t		  j		 = 0;
+	for (; j + 32 <= cols; j += 32)
+	{
+		__m256i acc0 = _mm256_setzero_si256();
+		__m256i acc1 = _mm256_setzero_si256();
+		__m256i acc2 = _mm256_setzero_si256();
+		__m256i acc3 = _mm256_setzero_si256();
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			const __m256i xg  = _mm256_set1_epi32(load_group(x, g));
+			const auto*	  row = reinterpret_cast<const __m256i*>(w + (g * cols + j) * k_int8_group);
+			acc0			  = _mm256_dpbusd_avx_epi32(acc0, xg, _mm256_loadu_si256(row));
+			acc1			  = _mm256_dpbusd_avx_epi32(acc1, xg, _mm256_loadu_si256(row + 1));
+			acc2			  = _mm256_dpbusd_avx_epi32(acc2, xg, _mm256_loadu_si256(row + 2));
+			acc3			  = _mm256_dpbusd_avx_epi32(acc3, xg, _mm256_loadu_si256(row + 3));
+		}
+		auto* out = reinterpret_cast<__m256i*>(acc + j);
+		_mm256_storeu_si256(out, acc0);
+		_mm256_storeu_si256(out + 1, acc1);
+		_mm256_storeu_si256(out + 2, acc2);
+		_mm256_storeu_si256(out + 3, acc3);
+	}
+	for (; j + 8 <= cols; j += 8)
+	{
+		__m256i sum = _mm256_setzero_si256();
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			sum = _mm256_dpbusd_avx_epi32(
+				sum, _mm256_set1_epi32(load_group(x, g)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + (g * cols + j) * k_int8_group)));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j), sum);
+	}
+	dense_forward_u8s8_tail(j, x, in, w, cols, acc);
+}
+
+// No u8 x s8 dot product without VNNI, and vpmaddubsw saturates at int16. Both sides are widened to int16 instead,
+// vpmaddwd sums pairs into int32 and a horizontal add joins the two pairs of every output.
+SWARM_TARGET("avx2")
+static __m256i widen_group(const std::uint8_t* x, std::size_t g)
+{
+	return _mm256_broadcastq_epi64(_mm_cvtepu8_epi16(_mm_cvtsi32_si128(load_group(x, g))));
+}
+
+SWARM_TARGET("avx2")
+static __m256i madd_group(__m256i sum, const std::int8_t* w, __m256i xg)
+{
+	const __m256i w16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+	return _mm256_add_epi32(sum, _mm256_madd_epi16(w16, xg));
+}
+
+// Per 128-bit lane [j, j + 1, j + 4, j + 5] and [j + 2, j + 3, j + 6, j + 7], the permute puts them in order
+SWARM_TARGET("avx2")
+static __m256i join_pairs(__m256i lo, __m256i hi)
+{
+	return _mm256_permute4x64_epi64(_mm256_hadd_epi32(lo, hi), 0xD8);
+}
+
+SWARM_TARGET("avx2")
+static void dense_forward_u8s8_avx2(const std::uint8_t* x, std::size_t in, const std::int8_t* w, std::size_t cols,
+									std::int32_t* acc)
+{
+	const std::size_t groups = in / k_int8_group;
+	std::size_t		  j		 = 0;
+	for (; j + 16 <= cols; j += 16)
+	{
+		__m256i sums[4] = {}; // Two partial sums for each of outputs j .. j + 3, j + 4 .. j + 7 and so on
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			const __m256i		xg	= widen_group(x, g);
+			const std::int8_t* row = w + (g * cols + j) * k_int8_group;
+			for (std::size_t block = 0; block < 4; block++)
+			{
+				sums[block] = madd_group(sums[block], row + block * 16, xg);
+			}
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j), join_pairs(sums[0], sums[1]));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j + 8), join_pairs(sums[2], sums[3]));
+	}
+	for (; j + 8 <= cols; j += 8)
+	{
+		__m256i lo = _mm256_setzero_si256();
+		__m256i hi = _mm256_setzero_si256();
+		for (std::size_t g = 0; g < groups; g++)
+		{
+			const __m256i		xg	= widen_group(x, g);
+			const std::int8_t* row = w + (g * cols + j) * k_int8_group;
+			lo						= madd_group(lo, row, xg);
+			hi						= madd_group(hi, row + 16, xg);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j), join_pairs(lo, hi));
+	}
+	dense_forward_u8s8_tail(j, x, in, w, cols, acc);
+}
+#endif
+
+using DenseForwardU8S8 = void (*)(const std::uint8_t*, std::size_t, const std::int8_t*, std::size_t, std::int32_t*);
+
+struct Int8Kernel
+{
+	const char*		 name;
+	DenseForwardU8S8 forward;
+};
+
+static Int8Kernel select_int8_kernel()
+{
+#ifdef SWARM_KERNEL_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vnni"))
+	{
+		return {"avx512-vnni", dense_forward_u8s8_avx512_vnni};
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("avxvnni"))
+	{
+		return {"avx-vnni", dense_forward_u8s8_avx_vnni};
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return {"avx2", dense_forward_u8s8_avx2};
+	}
+#endif
+	return {"scalar", dense_forward_u8s8_scalar};
+}
+
+static const Int8Kernel& int8_kernel()
+{
+	static const Int8Kernel kernel = select_int8_kernel();
+	return kernel;
+}
+
+void dense_forward_u8s8(const std::uint8_t* x, std::size_t in, const std::int8_t* w, std::size_t cols,
+						std::int32_t* acc)
+{
+	int8_kernel().forward(x, in, w, cols, acc);
+}
+
+const char* int8_kernel_name()
+{
+	return int8_kernel().name;
+}
+
+// Eigen's rational approximation, branch free so the loop in tanh_inplace vectorizes
+static float fast_tanh(float x)
+{
+	constexpr float clamp = 7.90531110763549805f;
+	constexpr float a1 = 4.89352455891786e-03f, a3 = 6.37261928875436e-04f, a5 = 1.48572235717979e-05f,
+					a7 = 5.12229709037114e-08f, a9 = -8.60467152213735e-11f, a11 = 2.00018790482477e-13f,
+					a13 = -2.76076847742355e-16f;
+	constexpr float b0 = 4.89352518554385e-03f, b2 = 2.26843463243900e-03f, b4 = 1.18534705686654e-04f,
+					b6 = 1.19825839466702e-06f;
+	x			   = std::clamp(x, -clamp, clamp);
+	const float x2 = x * x;
+	float		p  = a13;
+	p			   = p * x2 + a11;
+	p			   = p * x2 + a9;
+	p			   = p * x2 + a7;
+	p			   = p * x2 + a5;
+	p			   = p * x2 + a3;
+	p			   = p * x2 + a1;
+	p *= x;
+	float q = b6;
+	q		= q * x2 + b4;
+	q		= q * x2 + b2;
+	q		= q * x2 + b0;
+	return p / q;
+}
+
+void tanh_inplace(float* y, std::size_t n)
+{
+	for (std::size_t j = 0; j < n; j++)
+	{
+		y[j] = fast_tanh(y[j]);
+	}
+}
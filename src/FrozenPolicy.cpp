@@ -0,0 +1,297 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/DenseKernels.hpp>
+#include <swarm/FrozenPolicy.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+static_assert(std::endian::native == std::endian::little, "Frozen policies are stored little endian");
+
+static constexpr char k_magic[8] = {'S', 'W', 'R', 'M', 'P', 'O', 'L', '\0'};
+
+struct FrozenHeader
+{
+	char		  magic[8];
+	std::uint32_t version;
+	std::uint32_t num_layers;
+	std::uint64_t file_size;
+	std::uint32_t input_size;
+	std::uint32_t output_size;
+	std::uint64_t layer_table_offset;
+	std::uint8_t  reserved[24];
+};
+static_assert(sizeof(FrozenHeader) == 64);
+
+struct FrozenLayerRecord
+{
+	std::uint32_t in;
+	std::uint32_t out;
+	Activation	  activation;
+	std::uint32_t reserved;
+	std::uint64_t weight_offset; // [in, out] input major
+	std::uint64_t bias_offset;	 // [out]
+};
+static_assert(sizeof(FrozenLayerRecord) == 32);
+
+static std::size_t align_bytes(std::size_t offset)
+{
+	return (offset + k_kernel_alignment - 1) / k_kernel_alignment * k_kernel_alignment;
+}
+
+// Whether count elements of element_size bytes at offset lie inside a file of file_size bytes. The offsets and counts
+// come from the file, the checks are ordered so that none of them can wrap around.
+static bool within_file(std::uint64_t offset, std::uint64_t count, std::size_t element_size, std::size_t file_size)
+{
+	return offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+void write_frozen_policy(const std::filesystem::path& path, std::span<const FrozenLayerSpec> layers)
+{
+	if (layers.empty())
+	{
+		throw std::invalid_argument("A frozen policy needs at least one layer");
+	}
+	for (std::size_t i = 1; i < layers.size(); i++)
+	{
+		if (layers[i].in != layers[i - 1].out)
+		{
+			throw std::invalid_argument(std::format("Layer {} expects {} inputs but layer {} has {} outputs", i,
+													layers[i].in, i - 1, layers[i - 1].out));
+		}
+	}
+
+	std::vector<FrozenLayerRecord> table(layers.size());
+	std::size_t offset = align_bytes(sizeof(FrozenHeader) + table.size() * sizeof(FrozenLayerRecord));
+	for (std::size_t i = 0; i < layers.size(); i++)
+	{
+		table[i].in			   = static_cast<std::uint32_t>(layers[i].in);
+		table[i].out		   = static_cast<std::uint32_t>(layers[i].out);
+		table[i].activation	   = layers[i].activation;
+		table[i].reserved	   = 0;
+		table[i].weight_offset = offset;
+		offset				   = align_bytes(offset + layers[i].in * layers[i].out * sizeof(float));
+		table[i].bias_offset   = offset;
+		offset				   = align_bytes(offset + layers[i].out * sizeof(float));
+	}
+
+	std::vector<std::byte> file(offset);
+	FrozenHeader		   header{};
+	std::memcpy(header.magic, k_magic, sizeof(k_magic));
+	header.version			  = FrozenPolicy::k_version;
+	header.num_layers		  = static_cast<std::uint32_t>(layers.size());
+	header.file_size		  = offset;
+	header.input_size		  = static_cast<std::uint32_t>(layers.front().in);
+	header.output_size		  = static_cast<std::uint32_t>(layers.back().out);
+	header.layer_table_offset = sizeof(FrozenHeader);
+	std::memcpy(file.data(), &header, sizeof(header));
+	std::memcpy(file.data() + sizeof(header), table.data(), table.size() * sizeof(FrozenLayerRecord));
+
+	for (std::size_t i = 0; i < layers.size(); i++)
+	{
+		auto* weight = reinterpret_cast<float*>(file.data() + table[i].weight_offset);
+		for (std::size_t j = 0; j < layers[i].out; j++)
+		{
+			for (std::size_t k = 0; k < layers[i].in; k++)
+			{
+				weight[k * layers[i].out + j] = layers[i].weight[j * layers[i].in + k];
+			}
+		}
+		std::memcpy(file.data() + table[i].bias_offset, layers[i].bias, layers[i].out * sizeof(float));
+	}
+
+	auto tmp_path = path;
+	tmp_path += ".tmp";
+	{
+		std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+		if (!out)
+		{
+			throw std::runtime_error(std::format("Could not write frozen policy to {}", tmp_path.string()));
+		}
+	}
+	std::filesystem::rename(tmp_path, path);
+}
+
+FrozenPolicy::FrozenPolicy(const std::filesystem::path& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		throw std::runtime_error(std::format("Could not open frozen policy {}", path.string()));
+	}
+	struct stat st{};
+	if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FrozenHeader))
+	{
+		::close(fd);
+		throw std::runtime_error(std::format("{} is not a frozen policy", path.string()));
+	}
+	m_size	   = static_cast<std::size_t>(st.st_size);
+	void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error(std::format("Could not map frozen policy {}", path.string()));
+	}
+	m_mapping = static_cast<const std::byte*>(data);
+	::madvise(data, m_size, MADV_WILLNEED);
+
+	const auto fail = [&](std::string_view reason) {
+		unmap();
+		throw std::runtime_error(std::format("Invalid frozen policy {}: {}", path.string(), reason));
+	};
+
+	const auto* header = reinterpret_cast<const FrozenHeader*>(m_mapping);
+	if (std::memcmp(header->magic, k_magic, sizeof(k_magic)) != 0)
+	{
+		fail("bad magic");
+	}
+	if (header->version != k_version)
+	{
+		fail(std::format("version {} but this build reads version {}", header->version, k_version));
+	}
+	if (header->file_size != m_size || header->num_layers == 0
+		|| !within_file(header->layer_table_offset, header->num_layers, sizeof(FrozenLayerRecord), m_size))
+	{
+		fail("truncated");
+	}
+	if (header->layer_table_offset % alignof(FrozenLayerRecord) != 0)
+	{
+		fail("misaligned layer table");
+	}
+
+	m_layers	  = reinterpret_cast<const FrozenLayerRecord*>(m_mapping + header->layer_table_offset);
+	m_num_layers  = header->num_layers;
+	m_input_size  = header->input_size;
+	m_output_size = header->output_size;
+	m_max_width	  = 0;
+	std::size_t expected_in = m_input_size;
+	for (std::size_t i = 0; i < m_num_layers; i++)
+	{
+		const auto& layer = m_layers[i];
+		if (layer.in != expected_in || layer.out == 0)
+		{
+			fail(std::format("layer {} has shape [{}, {}]", i, layer.in, layer.out));
+		}
+		if (layer.weight_offset % k_kernel_alignment != 0 || layer.bias_offset % k_kernel_alignment != 0
+			|| !within_file(layer.weight_offset, std::uint64_t{layer.in} * layer.out, sizeof(float), m_size)
+			|| !within_file(layer.bias_offset, layer.out, sizeof(float), m_size))
+		{
+			fail(std::format("layer {} points outside the file", i));
+		}
+		if (layer.activation != Activation::None && layer.activation != Activation::Tanh)
+		{
+			fail(std::format("layer {} has unknown activation {}", i, static_cast<std::uint32_t>(layer.activation)));
+		}
+		expected_in = layer.out;
+		m_max_width = std::max<std::size_t>(m_max_width, layer.out);
+	}
+	if (expected_in != m_output_size)
+	{
+		fail("output size does not match the last layer");
+	}
+	m_scratch.resize(2 * round_up_to_lane(m_max_width));
+}
+
+FrozenPolicy::~FrozenPolicy()
+{
+	unmap();
+}
+
+FrozenPolicy::FrozenPolicy(FrozenPolicy&& other) noexcept
+	: m_mapping(std::exchange(other.m_mapping, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+	, m_layers(std::exchange(other.m_layers, nullptr))
+	, m_num_layers(other.m_num_layers)
+	, m_input_size(other.m_input_size)
+	, m_output_size(other.m_output_size)
+	, m_max_width(other.m_max_width)
+	, m_scratch(std::move(other.m_scratch))
+{
+}
+
+FrozenPolicy& FrozenPolicy::operator=(FrozenPolicy&& other) noexcept
+{
+	if (this != &other)
+	{
+		unmap();
+		m_mapping	  = std::exchange(other.m_mapping, nullptr);
+		m_size		  = std::exchange(other.m_size, 0);
+		m_layers	  = std::exchange(other.m_layers, nullptr);
+		m_num_layers  = other.m_num_layers;
+		m_input_size  = other.m_input_size;
+		m_output_size = other.m_output_size;
+		m_max_width	  = other.m_max_width;
+		m_scratch	  = std::move(other.m_scratch);
+	}
+	return *this;
+}
+
+void FrozenPolicy::unmap()
+{
+	if (m_mapping != nullptr)
+	{
+		::munmap(const_cast<std::byte*>(m_mapping), m_size);
+		m_mapping = nullptr;
+	}
+}
+
+const float* FrozenPolicy::forward(const float* observation)
+{
+	const float* input	= observation;
+	float*		 buffers[2] = {m_scratch.data(), m_scratch.data() + round_up_to_lane(m_max_width)};
+	for (std::size_t i = 0; i < m_num_layers; i++)
+	{
+		const auto&	 layer	= m_layers[i];
+		const auto*	 weight = reinterpret_cast<const float*>(m_mapping + layer.weight_offset);
+		const auto*	 bias	= reinterpret_cast<const float*>(m_mapping + layer.bias_offset);
+		float*		 output = buffers[i % 2];
+		dense_forward(input, layer.in, weight, layer.out, bias, layer.out, output);
+		if (layer.activation == Activation::Tanh)
+		{
+			tanh_inplace(output, layer.out);
+		}
+		input = output;
+	}
+	return input;
+}
+
+void FrozenPolicy::logits(const float* observations, std::size_t batch, float* logits)
+{
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		const float* out = forward(observations + i * m_input_size);
+		std::copy_n(out, m_output_size, logits + i * m_output_size);
+	}
+}
+
+void FrozenPolicy::act_greedy(const float* observations, std::size_t batch, std::int64_t* actions)
+{
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		const float* out = forward(observations + i * m_input_size);
+		actions[i]		 = std::max_element(out, out + m_output_size) - out;
+	}
+}
+
+std::size_t FrozenPolicy::get_observation_size() const
+{
+	return m_input_size;
+}
+std::size_t FrozenPolicy::get_action_space_size() const
+{
+	return m_output_size;
+}
+std::size_t FrozenPolicy::get_num_layers() const
+{
+	return m_num_layers;
+}
@@ -0,0 +1,224 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/DenseKernels.hpp>
+#include <swarm/FusedActorCritic.hpp>
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <new>
+#include <stdexcept>
+
+void FusedActorCritic::AlignedDelete::operator()(float* ptr) const
+{
+	::operator delete[](ptr, std::align_val_t{k_kernel_alignment});
+}
+
+FusedActorCritic::FusedActorCritic(std::size_t obs_size, std::size_t hidden_size, std::size_t action_size)
+	: m_obs_size(obs_size)
+	, m_hidden(hidden_size)
+	, m_actions(action_size)
+{
+	if (obs_size == 0 || hidden_size == 0 || action_size == 0)
+	{
+		throw std::invalid_argument("FusedActorCritic needs non empty layers");
+	}
+	// Layer 1: [obs, 2H], layer 2: [H, 2H], layer 3: [H, A + 1]. Actor columns first, critic columns after them.
+	m_w1			   = 0;
+	m_b1			   = m_w1 + round_up_to_lane(obs_size * 2 * hidden_size);
+	m_w2			   = m_b1 + round_up_to_lane(2 * hidden_size);
+	m_b2			   = m_w2 + round_up_to_lane(hidden_size * 2 * hidden_size);
+	m_w3			   = m_b2 + round_up_to_lane(2 * hidden_size);
+	m_b3			   = m_w3 + round_up_to_lane(hidden_size * (action_size + 1));
+	const std::size_t total = m_b3 + round_up_to_lane(action_size + 1);
+
+	m_weights.reset(static_cast<float*>(::operator new[](total * sizeof(float), std::align_val_t{k_kernel_alignment})));
+	std::fill_n(m_weights.get(), total, 0.0f);
+	// h1 [2H], h2 [2H], outputs [A + 1], probabilities [A]
+	m_scratch.resize(round_up_to_lane(2 * hidden_size) * 2 + round_up_to_lane(action_size + 1) + round_up_to_lane(action_size));
+}
+
+void FusedActorCritic::set_actor_layer(std::size_t layer, const float* weight, const float* bias)
+{
+	const std::size_t h = m_hidden;
+	switch (layer)
+	{
+		case 0:
+			for (std::size_t j = 0; j < h; j++)
+			{
+				for (std::size_t k = 0; k < m_obs_size; k++)
+				{
+					m_weights[m_w1 + k * 2 * h + j] = weight[j * m_obs_size + k];
+				}
+				m_weights[m_b1 + j] = bias[j];
+			}
+			break;
+		case 1:
+			for (std::size_t j = 0; j < h; j++)
+			{
+				for (std::size_t k = 0; k < h; k++)
+				{
+					m_weights[m_w2 + k * 2 * h + j] = weight[j * h + k];
+				}
+				m_weights[m_b2 + j] = bias[j];
+			}
+			break;
+		case 2:
+			for (std::size_t j = 0; j < m_actions; j++)
+			{
+				for (std::size_t k = 0; k < h; k++)
+				{
+					m_weights[m_w3 + k * (m_actions + 1) + j] = weight[j * h + k];
+				}
+				m_weights[m_b3 + j] = bias[j];
+			}
+			break;
+		default: throw std::invalid_argument(std::format("Unexpected layer={}", layer));
+	}
+}
+
+void FusedActorCritic::set_critic_layer(std::size_t layer, const float* weight, const float* bias)
+{
+	const std::size_t h = m_hidden;
+	switch (layer)
+	{
+		case 0:
+			for (std::size_t j = 0; j < h; j++)
+			{
+				for (std::size_t k = 0; k < m_obs_size; k++)
+				{
+					m_weights[m_w1 + k * 2 * h + h + j] = weight[j * m_obs_size + k];
+				}
+				m_weights[m_b1 + h + j] = bias[j];
+			}
+			break;
+		case 1:
+			for (std::size_t j = 0; j < h; j++)
+			{
+				for (std::size_t k = 0; k < h; k++)
+				{
+					m_weights[m_w2 + k * 2 * h + h + j] = weight[j * h + k];
+				}
+				m_weights[m_b2 + h + j] = bias[j];
+			}
+			break;
+		case 2:
+			for (std::size_t k = 0; k < h; k++)
+			{
+				m_weights[m_w3 + k * (m_actions + 1) + m_actions] = weight[k];
+			}
+			m_weights[m_b3 + m_actions] = bias[0];
+			break;
+		default: throw std::invalid_argument(std::format("Unexpected layer={}", layer));
+	}
+}
+
+void FusedActorCritic::forward(const float* observation, bool with_critic)
+{
+	const std::size_t h		  = m_hidden;
+	const std::size_t ld3	  = m_actions + 1;
+	const float*	  weights = m_weights.get();
+	float*			  h1	  = m_scratch.data();
+	float*			  h2	  = h1 + round_up_to_lane(2 * h);
+	float*			  out	  = h2 + round_up_to_lane(2 * h);
+
+	// Actor and critic share the first matrix, the actor alone only needs its half of the columns
+	dense_forward(observation, m_obs_size, weights + m_w1, 2 * h, weights + m_b1, with_critic ? 2 * h : h, h1);
+	tanh_inplace(h1, with_critic ? 2 * h : h);
+
+	dense_forward(h1, h, weights + m_w2, 2 * h, weights + m_b2, h, h2);
+	if (with_critic)
+	{
+		dense_forward(h1 + h, h, weights + m_w2 + h, 2 * h, weights + m_b2 + h, h, h2 + h);
+	}
+	tanh_inplace(h2, with_critic ? 2 * h : h);
+
+	dense_forward(h2, h, weights + m_w3, ld3, weights + m_b3, m_actions, out);
+	if (with_critic)
+	{
+		dense_forward(h2 + h, h, weights + m_w3 + m_actions, ld3, weights + m_b3 + m_actions, 1, out + m_actions);
+	}
+}
+
+void FusedActorCritic::act(const float* observations, std::size_t batch, std::int64_t* actions, float* log_probs,
+						   float* values)
+{
+	const float* out   = m_scratch.data() + 2 * round_up_to_lane(2 * m_hidden);
+	float*		 probs = m_scratch.data() + 2 * round_up_to_lane(2 * m_hidden) + round_up_to_lane(m_actions + 1);
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		forward(observations + i * m_obs_size, true);
+
+		const float max_logit = *std::max_element(out, out + m_actions);
+		float		sum		  = 0.0f;
+		for (std::size_t a = 0; a < m_actions; a++)
+		{
+			probs[a] = std::exp(out[a] - max_logit);
+			sum += probs[a];
+		}
+
+		// Inverse CDF, falls back to the last action if rounding leaves the threshold uncovered
+		const float	 threshold = m_rng.uniform(0.0f, 1.0f) * sum;
+		std::size_t	 action	   = m_actions - 1;
+		float		 cumulative = 0.0f;
+		for (std::size_t a = 0; a < m_actions; a++)
+		{
+			cumulative += probs[a];
+			if (threshold < cumulative)
+			{
+				action = a;
+				break;
+			}
+		}
+
+		actions[i]	 = static_cast<std::int64_t>(action);
+		log_probs[i] = out[action] - max_logit - std::log(sum);
+		values[i]	 = out[m_actions];
+	}
+}
+
+void FusedActorCritic::act_greedy(const float* observations, std::size_t batch, std::int64_t* actions)
+{
+	const float* out = m_scratch.data() + 2 * round_up_to_lane(2 * m_hidden);
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		forward(observations + i * m_obs_size, false);
+		actions[i] = std::max_element(out, out + m_actions) - out;
+	}
+}
+
+void FusedActorCritic::actor_logits(const float* observations, std::size_t batch, float* logits)
+{
+	const float* out = m_scratch.data() + 2 * round_up_to_lane(2 * m_hidden);
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		forward(observations + i * m_obs_size, false);
+		std::copy_n(out, m_actions, logits + i * m_actions);
+	}
+}
+
+void FusedActorCritic::seed(std::uint64_t seed, std::uint64_t stream)
+{
+	m_rng.seed(seed, stream);
+}
+Philox::State FusedActorCritic::get_rng_state() const
+{
+	return m_rng.get_state();
+}
+void FusedActorCritic::set_rng_state(const Philox::State& state)
+{
+	m_rng.set_state(state);
+}
+
+std::size_t FusedActorCritic::get_observation_size() const
+{
+	return m_obs_size;
+}
+std::size_t FusedActorCritic::get_hidden_size() const
+{
+	return m_hidden;
+}
+std::size_t FusedActorCritic::get_action_space_size() const
+{
+	return m_actions;
+}
@@ -0,0 +1,106 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/Gae.hpp>
+
+void compute_gae(const float* rewards, const float* values, const float* dones, const float* next_value,
+				 const float* next_done, std::size_t num_steps, std::size_t num_envs, float gamma, float gae_lambda,
+				 float* advantages, float* returns)
+{
+	if (num_steps == 0)
+	{
+		return;
+	}
+	const float gamma_lambda = gamma * gae_lambda;
+
+	// The last step bootstraps from next_value, lastgaelam starts at zero
+	{
+		const std::size_t row = (num_steps - 1) * num_envs;
+		for (std::size_t e = 0; e < num_envs; e++)
+		{
+			const float nextnonterminal = 1.0f - next_done[e];
+			const float delta			= rewards[row + e] + gamma * next_value[e] * nextnonterminal - values[row + e];
+			advantages[row + e]			= delta;
+			returns[row + e]			= delta + values[row + e];
+		}
+	}
+
+	// Every other step reads lastgaelam straight from the advantage row below it
+	for (std::size_t t = num_steps - 1; t-- > 0;)
+	{
+		const std::size_t row  = t * num_envs;
+		const std::size_t next = row + num_envs;
+		for (std::size_t e = 0; e < num_envs; e++)
+		{
+			const float nextnonterminal = 1.0f - dones[next + e];
+			const float delta = rewards[row + e] + gamma * values[next + e] * nextnonterminal - values[row + e];
+			const float advantage = delta + gamma_lambda * nextnonterminal * advantages[next + e];
+			advantages[row + e]	  = advantage;
+			returns[row + e]	  = advantage + values[row + e];
+		}
+	}
+}
+
+// The kernel reads raw float32 rows, anything on another device or of another floating type is copied over
+static torch::Tensor to_host(const torch::Tensor& tensor)
+{
+	return tensor.to(torch::kCPU, torch::kFloat32).contiguous();
+}
+
+static void check_rows(const char* name, const torch::Tensor& tensor, long num_steps, long num_envs)
+{
+	if (tensor.sizes() != torch::IntArrayRef{num_steps, num_envs})
+	{
+		throw std::invalid_argument(std::format("Expected {} of shape [{}, {}], got {}", name, num_steps, num_envs,
+												c10::str(tensor.sizes())));
+	}
+}
+
+// next_value comes straight from the critic as [num_envs, 1], any shape holding one value per env is accepted
+static void check_bootstrap(const char* name, const torch::Tensor& tensor, long num_envs)
+{
+	if (tensor.numel() != num_envs)
+	{
+		throw std::invalid_argument(
+			std::format("Expected {} with one value per env ({}), got {}", name, num_envs, c10::str(tensor.sizes())));
+	}
+}
+
+GaeResult compute_gae(const torch::Tensor& rewards, const torch::Tensor& values, const torch::Tensor& dones,
+					  const torch::Tensor& next_value, const torch::Tensor& next_done, float gamma, float gae_lambda)
+{
+	if (rewards.dim() != 2)
+	{
+		throw std::invalid_argument(std::format("Expected rewards of shape [num_steps, num_envs], got {} dims",
+												rewards.dim()));
+	}
+	const auto num_steps = rewards.size(0);
+	const auto num_envs	 = rewards.size(1);
+	check_rows("values", values, num_steps, num_envs);
+	check_rows("dones", dones, num_steps, num_envs);
+	check_bootstrap("next_value", next_value, num_envs);
+	check_bootstrap("next_done", next_done, num_envs);
+	for (const auto* tensor : {&rewards, &values, &dones, &next_value, &next_done})
+	{
+		if (!tensor->is_floating_point())
+		{
+			throw std::invalid_argument(
+				std::format("compute_gae takes floating point tensors, got {}", c10::toString(tensor->scalar_type())));
+		}
+	}
+
+	auto h_rewards	  = to_host(rewards);
+	auto h_values	  = to_host(values);
+	auto h_dones	  = to_host(dones);
+	auto h_next_value = to_host(next_value).reshape({num_envs});
+	auto h_next_done  = to_host(next_done).reshape({num_envs});
+	auto advantages	  = torch::empty({num_steps, num_envs}, torch::kFloat32);
+	auto returns	  = torch::empty({num_steps, num_envs}, torch::kFloat32);
+
+	compute_gae(h_rewards.data_ptr<float>(), h_values.data_ptr<float>(), h_dones.data_ptr<float>(),
+				h_next_value.data_ptr<float>(), h_next_done.data_ptr<float>(), static_cast<std::size_t>(num_steps),
+				static_cast<std::size_t>(num_envs), gamma, gae_lambda, advantages.data_ptr<float>(),
+				returns.data_ptr<float>());
+
+	return {advantages.to(rewards.device()), returns.to(rewards.device())};
+}
@@ -0,0 +1,112 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/Metrics.hpp>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+static constexpr std::array k_columns{
+	"update",  "global_step", "time_s", "sps",	   "policy_lag", "mean_reward", "episodes",	 "episode_return",
+	"episode_length", "pg_loss", "v_loss", "entropy", "approx_kl", "clipfrac",	   "grad_norm",
+};
+
+static std::array<double, k_columns.size()> values(const MetricsRecord& r)
+{
+	return {static_cast<double>(r.update), static_cast<double>(r.global_step), r.time_s, r.sps,
+			static_cast<double>(r.policy_lag), r.mean_reward, static_cast<double>(r.episodes), r.episode_return,
+			r.episode_length, r.pg_loss, r.v_loss, r.entropy, r.approx_kl, r.clipfrac, r.grad_norm};
+}
+
+MetricsWriter::MetricsWriter(const std::filesystem::path& path, std::size_t capacity)
+	: m_ring(capacity)
+	, m_out(path)
+	, m_format(path.extension() == ".csv" ? MetricsFormat::Csv : MetricsFormat::JsonLines)
+{
+	if (!m_out)
+	{
+		throw std::runtime_error(std::format("Could not open {} for writing", path.string()));
+	}
+	if (m_format == MetricsFormat::Csv)
+	{
+		for (std::size_t i = 0; i < k_columns.size(); i++)
+		{
+			m_out << (i == 0 ? "" : ",") << k_columns[i];
+		}
+		m_out << '\n';
+	}
+	m_thread = std::jthread([this](std::stop_token stop) { run(std::move(stop)); });
+}
+
+MetricsWriter::~MetricsWriter()
+{
+	m_thread.request_stop();
+	m_thread.join();
+}
+
+void MetricsWriter::run(std::stop_token stop)
+{
+	MetricsRecord record;
+	while (true)
+	{
+		// Read the flag before draining so nothing pushed before the stop request is lost
+		const bool stopping = stop.stop_requested();
+		while (m_ring.try_pop(record))
+		{
+			write(record);
+		}
+		m_out.flush();
+		if (stopping)
+		{
+			return;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+}
+
+void MetricsWriter::write(const MetricsRecord& record)
+{
+	const auto row = values(record);
+	if (m_format == MetricsFormat::Csv)
+	{
+		for (std::size_t i = 0; i < row.size(); i++)
+		{
+			m_out << (i == 0 ? "" : ",") << std::format("{}", row[i]);
+		}
+		m_out << '\n';
+		return;
+	}
+	m_out << '{';
+	for (std::size_t i = 0; i < row.size(); i++)
+	{
+		// JSON has no NaN or infinity
+		m_out << (i == 0 ? "" : ",") << std::format("\"{}\":", k_columns[i]);
+		if (std::isfinite(row[i]))
+		{
+			m_out << std::format("{}", row[i]);
+		}
+		else
+		{
+			m_out << "null";
+		}
+	}
+	m_out << "}\n";
+}
+
+bool MetricsWriter::push(const MetricsRecord& record)
+{
+	if (m_ring.try_push(record))
+	{
+		return true;
+	}
+	m_dropped.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+std::size_t MetricsWriter::dropped() const
+{
+	return m_dropped.load(std::memory_order_relaxed);
+}
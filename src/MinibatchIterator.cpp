@@ -0,0 +1,93 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/MinibatchIterator.hpp>
+#include <algorithm>
+
+MinibatchIterator::MinibatchIterator(const RolloutStorage& storage, const torch::Tensor& rows,
+									 const torch::Tensor& advantages, const torch::Tensor& returns,
+									 const torch::Tensor& values, long minibatch_size, long num_epochs, Philox& rng)
+	: m_storage(storage)
+	, m_rows(rows.reshape({-1}).to(torch::kLong))
+	, m_batch_size(m_rows.size(0))
+	, m_minibatch_size(minibatch_size)
+	, m_num_epochs(num_epochs)
+	, m_rng(rng)
+{
+	if (minibatch_size <= 0 || minibatch_size > m_batch_size)
+	{
+		throw std::invalid_argument(
+			std::format("Minibatch size {} is outside of the batch of {}", minibatch_size, m_batch_size));
+	}
+	torch::NoGradGuard nograd;
+	auto column = [&](const torch::Tensor& t) { return t.reshape({m_batch_size, 1}).to(torch::kFloat32); };
+	m_packed	= torch::cat({column(advantages), column(returns), column(values)}, 1);
+	if (m_num_epochs > 0)
+	{
+		m_next = shuffle_async();
+	}
+}
+
+MinibatchIterator::~MinibatchIterator()
+{
+	// A pending shuffle still reads m_packed, m_rows and the storage
+	if (m_next.valid())
+	{
+		m_next.wait();
+	}
+}
+
+std::future<MinibatchIterator::Epoch> MinibatchIterator::shuffle_async()
+{
+	auto  perm	  = torch::arange(m_batch_size, torch::kLong);
+	auto* indices = perm.data_ptr<std::int64_t>();
+	for (long i = m_batch_size - 1; i > 0; i--)
+	{
+		std::swap(indices[i], indices[m_rng.below(static_cast<std::uint32_t>(i + 1))]);
+	}
+	perm = perm.to(m_packed.device());
+	return std::async(std::launch::async, [this, perm = std::move(perm)] {
+		torch::NoGradGuard nograd;
+		return Epoch{m_packed.index_select(0, perm), m_storage.gather_stored(m_rows.index_select(0, perm))};
+	});
+}
+
+bool MinibatchIterator::next_epoch()
+{
+	if (m_epoch + 1 >= m_num_epochs)
+	{
+		return false;
+	}
+	m_epoch++;
+	m_current = m_next.get();
+	if (m_epoch + 1 < m_num_epochs)
+	{
+		m_next = shuffle_async();
+	}
+	return true;
+}
+
+MinibatchIterator::Minibatch MinibatchIterator::minibatch(long index) const
+{
+	const long start  = index * m_minibatch_size;
+	const long end	  = std::min(start + m_minibatch_size, m_batch_size);
+	const auto slice  = [&](const torch::Tensor& column) { return column.slice(0, start, end); };
+	auto	   packed = slice(m_current.packed);
+	return {
+		slice(m_current.stored.observations).to(torch::kFloat32),
+		slice(m_current.stored.actions).to(torch::kLong),
+		slice(m_current.stored.logprobs),
+		packed.select(1, 0),
+		packed.select(1, 1),
+		packed.select(1, 2),
+	};
+}
+
+long MinibatchIterator::num_minibatches() const
+{
+	return (m_batch_size + m_minibatch_size - 1) / m_minibatch_size;
+}
+long MinibatchIterator::minibatch_size() const
+{
+	return m_minibatch_size;
+}
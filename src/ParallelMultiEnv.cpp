@@ -0,0 +1,117 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/ParallelMultiEnv.hpp>
+#include <swarm/Trace.hpp>
+
+ParallelMultiEnv::ParallelMultiEnv(std::unique_ptr<Environment> env, std::size_t num_envs, std::size_t num_workers)
+	: MultiEnv(std::move(env), num_envs)
+	, m_num_workers(std::clamp<std::size_t>(num_workers, 1, num_envs))
+	, m_start(static_cast<std::ptrdiff_t>(m_num_workers))
+	, m_finish(static_cast<std::ptrdiff_t>(m_num_workers))
+	, m_errors(m_num_workers)
+	, m_worker_episodes(m_num_workers)
+{
+	m_threads.reserve(m_num_workers - 1);
+	for (std::size_t worker = 1; worker < m_num_workers; worker++)
+	{
+		m_threads.emplace_back([this, worker] { worker_loop(worker); });
+	}
+}
+
+ParallelMultiEnv::~ParallelMultiEnv()
+{
+	m_job = Job::Stop;
+	m_start.arrive_and_wait();
+	// jthreads join on destruction
+}
+
+std::size_t ParallelMultiEnv::get_num_workers() const
+{
+	return m_num_workers;
+}
+
+void ParallelMultiEnv::worker_loop(std::size_t worker)
+{
+	set_trace_thread_name(std::format("env worker {}", worker));
+	while (true)
+	{
+		m_start.arrive_and_wait();
+		if (m_job == Job::Stop)
+		{
+			return;
+		}
+		run_shard(worker);
+		m_finish.arrive_and_wait();
+	}
+}
+
+void ParallelMultiEnv::run_shard(std::size_t worker)
+{
+	SWARM_TRACE_SCOPE("env_shard");
+	const std::size_t begin	   = worker * envs.size() / m_num_workers;
+	const std::size_t end	   = (worker + 1) * envs.size() / m_num_workers;
+	const std::size_t obs_size = get_observation_size();
+	try
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			if (m_job == Job::Reset)
+			{
+				episodes.reset_env(i);
+				envs[i]->reset_into(m_buffers.observations.subspan(i * obs_size, obs_size));
+			}
+			else
+			{
+				step_env(i, m_buffers, m_worker_episodes[worker]);
+			}
+		}
+	}
+	catch (...)
+	{
+		m_errors[worker] = std::current_exception();
+	}
+}
+
+void ParallelMultiEnv::run(Job job)
+{
+	m_job = job;
+	m_start.arrive_and_wait();
+	run_shard(0);
+	m_finish.arrive_and_wait();
+
+	for (auto& error : m_errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(std::exchange(error, nullptr));
+		}
+	}
+}
+
+void ParallelMultiEnv::step_into(const StepBuffers& buffers)
+{
+	check_buffers(buffers);
+	m_buffers = buffers;
+	run(Job::Step);
+	m_buffers = {};
+}
+
+void ParallelMultiEnv::reset_into(std::span<float> observations)
+{
+	check_observations(observations);
+	m_buffers.observations = observations;
+	run(Job::Reset);
+	m_buffers = {};
+}
+
+EpisodeStats ParallelMultiEnv::take_episode_stats()
+{
+	// Workers only touch their stats between the barriers of step() and reset()
+	auto stats = episodes.take();
+	for (auto& worker : m_worker_episodes)
+	{
+		stats += std::exchange(worker, {});
+	}
+	return stats;
+}
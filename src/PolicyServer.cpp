@@ -0,0 +1,231 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/PolicyServer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+// Octave 0 holds [0, 1) us, octave o >= 1 holds [2^(o - 1), 2^o) us
+static std::size_t bucket_index(double latency_us)
+{
+	if (!(latency_us > 0.0))
+	{
+		return 0;
+	}
+	// latency_us = mantissa * 2^exponent with mantissa in [0.5, 1)
+	int			 exponent = 0;
+	const double mantissa = std::frexp(latency_us, &exponent);
+	if (exponent <= 0)
+	{
+		return static_cast<std::size_t>(latency_us * LatencyHistogram::k_sub_buckets);
+	}
+	const auto octave = static_cast<std::size_t>(exponent);
+	if (octave >= LatencyHistogram::k_octaves)
+	{
+		return LatencyHistogram::k_octaves * LatencyHistogram::k_sub_buckets - 1;
+	}
+	const auto sub = static_cast<std::size_t>((2.0 * mantissa - 1.0) * LatencyHistogram::k_sub_buckets);
+	return octave * LatencyHistogram::k_sub_buckets + std::min(sub, LatencyHistogram::k_sub_buckets - 1);
+}
+
+static double bucket_upper_edge(std::size_t index)
+{
+	const std::size_t octave = index / LatencyHistogram::k_sub_buckets;
+	const double	  sub	 = static_cast<double>(index % LatencyHistogram::k_sub_buckets + 1);
+	if (octave == 0)
+	{
+		return sub / LatencyHistogram::k_sub_buckets;
+	}
+	const double low = std::ldexp(1.0, static_cast<int>(octave) - 1);
+	return low + low * sub / LatencyHistogram::k_sub_buckets;
+}
+
+void LatencyHistogram::record(double latency_us)
+{
+	m_buckets[bucket_index(latency_us)]++;
+	m_count++;
+	m_max = std::max(m_max, latency_us);
+}
+
+std::uint64_t LatencyHistogram::count() const
+{
+	return m_count;
+}
+
+double LatencyHistogram::max() const
+{
+	return m_max;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+	if (m_count == 0)
+	{
+		return 0.0;
+	}
+	const auto rank = std::clamp<std::uint64_t>(
+		static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(m_count))), 1, m_count);
+	std::uint64_t seen = 0;
+	for (std::size_t i = 0; i < m_buckets.size(); i++)
+	{
+		seen += m_buckets[i];
+		if (seen >= rank)
+		{
+			return std::min(bucket_upper_edge(i), m_max);
+		}
+	}
+	return m_max;
+}
+
+double PolicyServerStats::mean_batch_size() const
+{
+	return batches == 0 ? 0.0 : static_cast<double>(requests) / static_cast<double>(batches);
+}
+
+PolicyServer::PolicyServer(BatchPolicy policy, std::size_t observation_size, PolicyServerOptions options)
+	: m_policy(std::move(policy))
+	, m_observation_size(observation_size)
+	, m_options(options)
+	, m_batch_sizes(options.max_batch_size + 1)
+{
+	if (observation_size == 0 || options.max_batch_size == 0)
+	{
+		throw std::invalid_argument(std::format(
+			"PolicyServer needs observations and batches of at least one, got {} and {}", observation_size,
+			options.max_batch_size));
+	}
+	m_observations.reserve(options.max_batch_size * observation_size);
+	m_promises.reserve(options.max_batch_size);
+	m_submitted.reserve(options.max_batch_size);
+	m_actions.resize(options.max_batch_size);
+	m_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+PolicyServer::~PolicyServer()
+{
+	// The batcher serves what is still queued before it returns
+	m_thread.request_stop();
+}
+
+std::size_t PolicyServer::get_observation_size() const
+{
+	return m_observation_size;
+}
+
+std::future<std::int64_t> PolicyServer::submit(std::span<const float> observation)
+{
+	if (observation.size() != m_observation_size)
+	{
+		throw std::invalid_argument(
+			std::format("Expected an observation of {} floats, got {}", m_observation_size, observation.size()));
+	}
+	std::promise<std::int64_t> promise;
+	auto					   future = promise.get_future();
+	std::size_t				   queued = 0;
+	{
+		std::lock_guard lock(m_mutex);
+		m_queue_observations.insert(m_queue_observations.end(), observation.begin(), observation.end());
+		m_queue_promises.push_back(std::move(promise));
+		m_queue_submitted.push_back(Clock::now());
+		queued = m_queue_promises.size();
+	}
+	// The batcher waits either for a first request or for a full batch, nothing in between wakes it
+	if (queued == 1 || queued == m_options.max_batch_size)
+	{
+		m_queued.notify_one();
+	}
+	return future;
+}
+
+void PolicyServer::run(std::stop_token stop)
+{
+	std::unique_lock lock(m_mutex);
+	while (true)
+	{
+		m_queued.wait(lock, stop, [this] { return !m_queue_promises.empty(); });
+		if (m_queue_promises.empty())
+		{
+			return; // Stopped with nothing left to serve
+		}
+		// Others may join until the oldest request's deadline, a full batch or a stop cut that short
+		const auto deadline = m_queue_submitted.front() + m_options.max_delay;
+		m_queued.wait_until(lock, stop, deadline,
+							[this] { return m_queue_promises.size() >= m_options.max_batch_size; });
+
+		const std::size_t batch = std::min(m_queue_promises.size(), m_options.max_batch_size);
+		const auto		  rows	= static_cast<std::ptrdiff_t>(batch);
+		const auto		  floats = static_cast<std::ptrdiff_t>(batch * m_observation_size);
+		m_observations.assign(m_queue_observations.begin(), m_queue_observations.begin() + floats);
+		m_queue_observations.erase(m_queue_observations.begin(), m_queue_observations.begin() + floats);
+		m_promises.clear();
+		std::move(m_queue_promises.begin(), m_queue_promises.begin() + rows, std::back_inserter(m_promises));
+		m_queue_promises.erase(m_queue_promises.begin(), m_queue_promises.begin() + rows);
+		m_submitted.assign(m_queue_submitted.begin(), m_queue_submitted.begin() + rows);
+		m_queue_submitted.erase(m_queue_submitted.begin(), m_queue_submitted.begin() + rows);
+
+		lock.unlock();
+		const auto error  = act(batch);
+		const auto served = Clock::now();
+		lock.lock();
+
+		// Counted before the clients are woken, so stats taken after a future is ready include its request
+		m_num_batches++;
+		m_batch_sizes[batch]++;
+		for (const auto submitted : m_submitted)
+		{
+			m_latencies.record(std::chrono::duration<double, std::micro>(served - submitted).count());
+		}
+		lock.unlock();
+		fulfil(batch, error);
+		lock.lock();
+	}
+}
+
+std::exception_ptr PolicyServer::act(std::size_t batch)
+{
+	try
+	{
+		m_policy(m_observations.data(), batch, m_actions.data());
+		return nullptr;
+	}
+	catch (...)
+	{
+		return std::current_exception();
+	}
+}
+
+void PolicyServer::fulfil(std::size_t batch, const std::exception_ptr& error)
+{
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		if (error)
+		{
+			m_promises[i].set_exception(error);
+		}
+		else
+		{
+			m_promises[i].set_value(m_actions[i]);
+		}
+	}
+}
+
+PolicyServerStats PolicyServer::take_stats()
+{
+	LatencyHistogram  latencies;
+	PolicyServerStats stats;
+	{
+		std::lock_guard lock(m_mutex);
+		latencies		  = std::exchange(m_latencies, {});
+		stats.batches	  = std::exchange(m_num_batches, 0);
+		stats.batch_sizes = std::exchange(m_batch_sizes, std::vector<std::uint64_t>(m_options.max_batch_size + 1));
+	}
+	stats.requests		 = latencies.count();
+	stats.max_latency_us = latencies.max();
+	stats.p99_latency_us = latencies.percentile(0.99);
+	stats.p50_latency_us = latencies.percentile(0.50);
+	return stats;
+}
@@ -0,0 +1,180 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/PpoLoss.hpp>
+#include <algorithm>
+#include <cmath>
+
+PpoLossResult ppo_loss(const PpoLossInputs& in, float clip_coef, float vf_coef, float ent_coef)
+{
+	auto logratio = in.newlogprob - in.oldlogprob;
+	auto ratio	  = logratio.exp();
+
+	// Normalize advantages
+	auto mb_advantages = (in.advantages - in.advantages.mean(-1, true)) / (in.advantages.std(-1, true, true) + 1e-8);
+
+	// Policy loss
+	auto pg_loss1 = -mb_advantages * ratio;
+	auto pg_loss2 = -mb_advantages * torch::clamp(ratio, 1 - clip_coef, 1 + clip_coef);
+	auto pg_loss  = torch::max(pg_loss1, pg_loss2).mean(-1);
+
+	// Value loss
+	auto newvalue		  = in.newvalue.reshape(in.returns.sizes());
+	auto v_loss_unclipped = (newvalue - in.returns).pow(2);
+	auto v_clipped		  = in.oldvalues + torch::clamp(newvalue - in.oldvalues, -clip_coef, clip_coef);
+	auto v_loss_clipped	  = (v_clipped - in.returns).pow(2);
+	auto v_loss_max		  = torch::max(v_loss_unclipped, v_loss_clipped);
+	auto v_loss			  = 0.5 * v_loss_max.mean(-1);
+
+	auto entropy_loss = in.entropy.mean(-1);
+	auto loss		  = pg_loss - ent_coef * entropy_loss + v_loss * vf_coef;
+
+	torch::Tensor approx_kl;
+	torch::Tensor clipfrac;
+	{
+		torch::NoGradGuard nograd;
+		approx_kl = ((ratio - 1) - logratio).mean(-1);
+		clipfrac  = ((ratio - 1.0).abs() > clip_coef).to(torch::kFloat32).mean(-1);
+	}
+	return {loss, pg_loss, v_loss, entropy_loss, approx_kl, clipfrac};
+}
+
+// Gradient of max(a, b) with respect to the chosen side, ties split the gradient like torch::max does
+static float max_grad(float a, float b, float grad_a, float grad_b)
+{
+	if (a > b)
+	{
+		return grad_a;
+	}
+	if (a < b)
+	{
+		return grad_b;
+	}
+	return 0.5f * (grad_a + grad_b);
+}
+
+struct FusedPpoLossFunction : torch::autograd::Function<FusedPpoLossFunction>
+{
+	static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx, torch::Tensor newlogprob,
+												  torch::Tensor entropy, torch::Tensor newvalue,
+												  torch::Tensor oldlogprob, torch::Tensor advantages,
+												  torch::Tensor returns, torch::Tensor oldvalues, double clip_coef,
+												  double vf_coef, double ent_coef)
+	{
+		newlogprob = newlogprob.contiguous();
+		entropy	   = entropy.contiguous();
+		newvalue   = newvalue.contiguous();
+		oldlogprob = oldlogprob.contiguous();
+		advantages = advantages.contiguous();
+		returns	   = returns.contiguous();
+		oldvalues  = oldvalues.contiguous();
+
+		const long	 n	   = newlogprob.numel();
+		const float* lp	   = newlogprob.data_ptr<float>();
+		const float* ent   = entropy.data_ptr<float>();
+		const float* v	   = newvalue.data_ptr<float>();
+		const float* old   = oldlogprob.data_ptr<float>();
+		const float* adv   = advantages.data_ptr<float>();
+		const float* ret   = returns.data_ptr<float>();
+		const float* old_v = oldvalues.data_ptr<float>();
+
+		auto   grad_logprob = torch::empty({n}, torch::kFloat32);
+		auto   grad_entropy = torch::full({n}, static_cast<float>(-ent_coef / static_cast<double>(n)));
+		auto   grad_value	= torch::empty({n}, torch::kFloat32);
+		float* g_lp			= grad_logprob.data_ptr<float>();
+		float* g_v			= grad_value.data_ptr<float>();
+
+		// Advantage statistics, std is unbiased like torch::std
+		double adv_sum = 0.0;
+		for (long i = 0; i < n; i++)
+		{
+			adv_sum += adv[i];
+		}
+		const double adv_mean = adv_sum / static_cast<double>(n);
+		double		 adv_sq	  = 0.0;
+		for (long i = 0; i < n; i++)
+		{
+			adv_sq += (adv[i] - adv_mean) * (adv[i] - adv_mean);
+		}
+		const float adv_std	 = static_cast<float>(std::sqrt(adv_sq / static_cast<double>(std::max(n - 1, 1L))));
+		const float adv_inv	 = 1.0f / (adv_std + 1e-8f);
+		const float clip	 = static_cast<float>(clip_coef);
+		const float inv_n	 = 1.0f / static_cast<float>(n);
+		const float v_scale	 = static_cast<float>(vf_coef) * inv_n; // d(vf_coef * 0.5 * mean(x^2)) / dx = vf_coef * x / n
+
+		double pg_sum = 0.0, v_sum = 0.0, ent_sum = 0.0, kl_sum = 0.0, clip_count = 0.0;
+		for (long i = 0; i < n; i++)
+		{
+			const float a		 = (adv[i] - static_cast<float>(adv_mean)) * adv_inv;
+			const float logratio = lp[i] - old[i];
+			const float ratio	 = std::exp(logratio);
+
+			const bool	in_clip = ratio >= 1.0f - clip && ratio <= 1.0f + clip;
+			const float pg1		= -a * ratio;
+			const float pg2		= -a * std::clamp(ratio, 1.0f - clip, 1.0f + clip);
+			pg_sum += std::max(pg1, pg2);
+			// d(ratio) / d(logprob) = ratio
+			g_lp[i] = max_grad(pg1, pg2, -a * ratio, in_clip ? -a * ratio : 0.0f) * inv_n;
+
+			const float diff	   = v[i] - old_v[i];
+			const bool	v_in_clip  = diff >= -clip && diff <= clip;
+			const float unclipped  = v[i] - ret[i];
+			const float clipped	   = old_v[i] + std::clamp(diff, -clip, clip) - ret[i];
+			const float v_loss1	   = unclipped * unclipped;
+			const float v_loss2	   = clipped * clipped;
+			v_sum += std::max(v_loss1, v_loss2);
+			g_v[i] = max_grad(v_loss1, v_loss2, unclipped, v_in_clip ? clipped : 0.0f) * v_scale;
+
+			ent_sum += ent[i];
+			kl_sum += (ratio - 1.0f) - logratio;
+			clip_count += std::abs(ratio - 1.0f) > clip ? 1.0 : 0.0;
+		}
+
+		const double dn			  = static_cast<double>(n);
+		const double pg_loss	  = pg_sum / dn;
+		const double v_loss		  = 0.5 * v_sum / dn;
+		const double entropy_loss = ent_sum / dn;
+		const double loss		  = pg_loss - ent_coef * entropy_loss + vf_coef * v_loss;
+
+		ctx->save_for_backward({grad_logprob, grad_entropy, grad_value});
+		auto scalar	 = [](double x) { return torch::tensor(static_cast<float>(x)); };
+		auto outputs = torch::autograd::variable_list{scalar(loss),			scalar(pg_loss),	   scalar(v_loss),
+													  scalar(entropy_loss), scalar(kl_sum / dn), scalar(clip_count / dn)};
+		ctx->mark_non_differentiable({outputs[1], outputs[2], outputs[3], outputs[4], outputs[5]});
+		return outputs;
+	}
+
+	static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+												   torch::autograd::variable_list grad_outputs)
+	{
+		auto saved = ctx->get_saved_variables();
+		auto grad  = grad_outputs[0];
+		return {saved[0] * grad,
+				saved[1] * grad,
+				saved[2] * grad,
+				torch::Tensor(),
+				torch::Tensor(),
+				torch::Tensor(),
+				torch::Tensor(),
+				torch::Tensor(),
+				torch::Tensor(),
+				torch::Tensor()};
+	}
+};
+
+PpoLossResult fused_ppo_loss(const PpoLossInputs& in, float clip_coef, float vf_coef, float ent_coef)
+{
+	const auto fusable = [](const torch::Tensor& t) {
+		return t.device().is_cpu() && t.scalar_type() == torch::kFloat32;
+	};
+	if (in.newlogprob.dim() != 1
+		|| !(fusable(in.newlogprob) && fusable(in.entropy) && fusable(in.newvalue) && fusable(in.oldlogprob)
+		  && fusable(in.advantages) && fusable(in.returns) && fusable(in.oldvalues)))
+	{
+		return ppo_loss(in, clip_coef, vf_coef, ent_coef);
+	}
+	auto out = FusedPpoLossFunction::apply(in.newlogprob.view(-1), in.entropy.view(-1), in.newvalue.view(-1),
+										   in.oldlogprob.view(-1), in.advantages.view(-1), in.returns.view(-1),
+										   in.oldvalues.view(-1), clip_coef, vf_coef, ent_coef);
+	return {out[0], out[1], out[2], out[3], out[4], out[5]};
+}
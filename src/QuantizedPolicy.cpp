@@ -0,0 +1,261 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/DenseKernels.hpp>
+#include <swarm/QuantizedPolicy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+// Outputs are padded to whole AVX-512 registers of int32 accumulators
+static constexpr std::size_t k_int8_cols = 16;
+// Inputs are unsigned with this zero point, vpdpbusd multiplies unsigned by signed bytes
+static constexpr std::int32_t k_input_zero_point = 128;
+
+static std::size_t round_up(std::size_t n, std::size_t multiple)
+{
+	return (n + multiple - 1) / multiple * multiple;
+}
+
+// Largest absolute input every layer sees on the calibration set, run through the same float kernels as FrozenPolicy
+static std::vector<float> calibrate(std::span<const FrozenLayerSpec> layers, std::span<const float> calibration)
+{
+	std::vector<std::vector<float>> weights(layers.size());
+	std::size_t						max_width = 0;
+	for (std::size_t i = 0; i < layers.size(); i++)
+	{
+		const auto& layer = layers[i];
+		weights[i].resize(layer.in * layer.out);
+		for (std::size_t j = 0; j < layer.out; j++)
+		{
+			for (std::size_t k = 0; k < layer.in; k++)
+			{
+				weights[i][k * layer.out + j] = layer.weight[j * layer.in + k];
+			}
+		}
+		max_width = std::max(max_width, layer.out);
+	}
+
+	std::vector<float> ranges(layers.size(), 0.0f);
+	std::vector<float> scratch(2 * round_up_to_lane(max_width));
+	float*			   buffers[2] = {scratch.data(), scratch.data() + round_up_to_lane(max_width)};
+	const std::size_t  rows		  = calibration.size() / layers.front().in;
+	for (std::size_t row = 0; row < rows; row++)
+	{
+		const float* input = calibration.data() + row * layers.front().in;
+		for (std::size_t i = 0; i < layers.size(); i++)
+		{
+			const auto& layer = layers[i];
+			for (std::size_t k = 0; k < layer.in; k++)
+			{
+				ranges[i] = std::max(ranges[i], std::abs(input[k]));
+			}
+			float* output = buffers[i % 2];
+			dense_forward(input, layer.in, weights[i].data(), layer.out, layer.bias, layer.out, output);
+			if (layer.activation == Activation::Tanh)
+			{
+				tanh_inplace(output, layer.out);
+			}
+			input = output;
+		}
+	}
+	return ranges;
+}
+
+QuantizedPolicy::QuantizedPolicy(std::span<const FrozenLayerSpec> layers, std::span<const float> calibration)
+{
+	if (layers.empty())
+	{
+		throw std::invalid_argument("A quantized policy needs at least one layer");
+	}
+	for (std::size_t i = 1; i < layers.size(); i++)
+	{
+		if (layers[i].in != layers[i - 1].out)
+		{
+			throw std::invalid_argument(std::format("Layer {} expects {} inputs but layer {} has {} outputs", i,
+													layers[i].in, i - 1, layers[i - 1].out));
+		}
+	}
+	if (calibration.empty() || calibration.size() % layers.front().in != 0)
+	{
+		throw std::invalid_argument(std::format("Calibration needs whole observations of {} floats, got {} floats",
+												layers.front().in, calibration.size()));
+	}
+
+	const auto	ranges	   = calibrate(layers, calibration);
+	std::size_t max_inputs = 0;
+	std::size_t max_cols   = 0;
+	for (std::size_t i = 0; i < layers.size(); i++)
+	{
+		const auto& spec   = layers[i];
+		const auto	groups = round_up(spec.in, k_int8_group) / k_int8_group;
+		Layer		layer;
+		layer.in		  = spec.in;
+		layer.out		  = spec.out;
+		layer.cols		  = round_up(spec.out, k_int8_cols);
+		layer.activation  = spec.activation;
+		layer.input_scale = ranges[i] > 0.0f ? ranges[i] / 127.0f : 1.0f;
+		layer.weights.assign(groups * layer.cols * k_int8_group, 0);
+		layer.output_scales.assign(layer.cols, 0.0f);
+		layer.zero_point_sums.assign(layer.cols, 0);
+		layer.bias.assign(layer.cols, 0.0f);
+		for (std::size_t j = 0; j < spec.out; j++)
+		{
+			const float* row	= spec.weight + j * spec.in;
+			float		 range	= 0.0f;
+			for (std::size_t k = 0; k < spec.in; k++)
+			{
+				range = std::max(range, std::abs(row[k]));
+			}
+			const float	 scale = range > 0.0f ? range / 127.0f : 1.0f;
+			std::int32_t sum   = 0;
+			for (std::size_t k = 0; k < spec.in; k++)
+			{
+				const auto q = static_cast<std::int8_t>(std::clamp(std::nearbyint(row[k] / scale), -127.0f, 127.0f));
+				layer.weights[((k / k_int8_group) * layer.cols + j) * k_int8_group + k % k_int8_group] = q;
+				sum += q;
+			}
+			layer.output_scales[j]	 = layer.input_scale * scale;
+			layer.zero_point_sums[j] = k_input_zero_point * sum;
+			layer.bias[j]			 = spec.bias[j];
+		}
+		max_inputs = std::max(max_inputs, groups * k_int8_group);
+		max_cols   = std::max(max_cols, layer.cols);
+		m_layers.push_back(std::move(layer));
+	}
+	m_quantized.resize(max_inputs);
+	m_accumulators.resize(max_cols);
+	m_scratch.resize(2 * max_cols);
+}
+
+// Inputs beyond the calibrated range saturate. Plain locals, a byte store could alias anything in a member.
+static void quantize_input(const float* x, std::size_t n, float inv_scale, std::uint8_t* q)
+{
+	for (std::size_t k = 0; k < n; k++)
+	{
+		const float step = std::clamp(std::nearbyint(x[k] * inv_scale), -127.0f, 127.0f);
+		q[k]			 = static_cast<std::uint8_t>(static_cast<std::int32_t>(step) + k_input_zero_point);
+	}
+	// Pads to a whole group with the zero point, the padding inputs meet zero weights either way
+	std::fill(q + n, q + round_up(n, k_int8_group), static_cast<std::uint8_t>(k_input_zero_point));
+}
+
+const float* QuantizedPolicy::forward(const float* observation)
+{
+	const float* input		= observation;
+	float*		 buffers[2] = {m_scratch.data(), m_scratch.data() + m_scratch.size() / 2};
+	for (std::size_t i = 0; i < m_layers.size(); i++)
+	{
+		const auto& layer = m_layers[i];
+		quantize_input(input, layer.in, 1.0f / layer.input_scale, m_quantized.data());
+		dense_forward_u8s8(m_quantized.data(), round_up(layer.in, k_int8_group), layer.weights.data(), layer.cols,
+						   m_accumulators.data());
+
+		float* output = buffers[i % 2];
+		for (std::size_t j = 0; j < layer.out; j++)
+		{
+			output[j] = layer.output_scales[j] * static_cast<float>(m_accumulators[j] - layer.zero_point_sums[j])
+					  + layer.bias[j];
+		}
+		if (layer.activation == Activation::Tanh)
+		{
+			tanh_inplace(output, layer.out);
+		}
+		input = output;
+	}
+	return input;
+}
+
+void QuantizedPolicy::logits(const float* observations, std::size_t batch, float* logits)
+{
+	const std::size_t in  = get_observation_size();
+	const std::size_t out = get_action_space_size();
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		const float* result = forward(observations + i * in);
+		std::copy_n(result, out, logits + i * out);
+	}
+}
+
+void QuantizedPolicy::act_greedy(const float* observations, std::size_t batch, std::int64_t* actions)
+{
+	const std::size_t in  = get_observation_size();
+	const std::size_t out = get_action_space_size();
+	for (std::size_t i = 0; i < batch; i++)
+	{
+		const float* result = forward(observations + i * in);
+		actions[i]			= std::max_element(result, result + out) - result;
+	}
+}
+
+std::size_t QuantizedPolicy::get_observation_size() const
+{
+	return m_layers.front().in;
+}
+std::size_t QuantizedPolicy::get_action_space_size() const
+{
+	return m_layers.back().out;
+}
+std::size_t QuantizedPolicy::get_num_layers() const
+{
+	return m_layers.size();
+}
+std::size_t QuantizedPolicy::get_weight_bytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto& layer : m_layers)
+	{
+		bytes += layer.weights.size() * sizeof(std::int8_t) + layer.output_scales.size() * sizeof(float)
+			   + layer.zero_point_sums.size() * sizeof(std::int32_t) + layer.bias.size() * sizeof(float);
+	}
+	return bytes;
+}
+
+double QuantizationReport::agreement() const
+{
+	return samples == 0 ? 0.0 : static_cast<double>(agreements) / static_cast<double>(samples);
+}
+
+QuantizationReport compare_greedy(FrozenPolicy& reference, QuantizedPolicy& quantized,
+								  std::span<const float> observations)
+{
+	const std::size_t in  = reference.get_observation_size();
+	const std::size_t out = reference.get_action_space_size();
+	if (quantized.get_observation_size() != in || quantized.get_action_space_size() != out)
+	{
+		throw std::invalid_argument(std::format("Cannot compare a [{}, {}] policy to a [{}, {}] one", in, out,
+												quantized.get_observation_size(), quantized.get_action_space_size()));
+	}
+	if (observations.size() % in != 0)
+	{
+		throw std::invalid_argument(
+			std::format("Expected whole observations of {} floats, got {} floats", in, observations.size()));
+	}
+
+	QuantizationReport report;
+	report.samples = observations.size() / in;
+	std::vector<float> expected(out);
+	std::vector<float> actual(out);
+	double			   error_sum = 0.0;
+	for (std::size_t i = 0; i < report.samples; i++)
+	{
+		reference.logits(observations.data() + i * in, 1, expected.data());
+		quantized.logits(observations.data() + i * in, 1, actual.data());
+		if (std::ranges::max_element(expected) - expected.begin() == std::ranges::max_element(actual) - actual.begin())
+		{
+			report.agreements++;
+		}
+		for (std::size_t j = 0; j < out; j++)
+		{
+			const float error		= std::abs(expected[j] - actual[j]);
+			report.max_logit_error = std::max(report.max_logit_error, error);
+			error_sum			   += error;
+		}
+	}
+	if (report.samples > 0)
+	{
+		report.mean_logit_error = static_cast<float>(error_sum / static_cast<double>(report.samples * out));
+	}
+	return report;
+}
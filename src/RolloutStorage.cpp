@@ -0,0 +1,182 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/RolloutStorage.hpp>
+
+static torch::ScalarType action_dtype(std::size_t action_space_size)
+{
+	if (action_space_size <= 256)
+	{
+		return torch::kUInt8;
+	}
+	if (action_space_size <= 32768)
+	{
+		return torch::kInt16;
+	}
+	return torch::kInt32;
+}
+
+static void check_float_dtype(torch::ScalarType dtype, const char* field)
+{
+	if (dtype != torch::kFloat32 && dtype != torch::kBFloat16 && dtype != torch::kHalf)
+	{
+		throw std::invalid_argument(std::format("Unsupported storage type for {}: {}", field, c10::toString(dtype)));
+	}
+}
+
+RolloutStorage::RolloutStorage(long num_steps, long num_envs, long obs_size)
+	: m_num_steps(num_steps)
+	, m_num_envs(num_envs)
+	, m_obs_size(obs_size)
+{
+}
+
+RolloutStorage::RolloutStorage(long num_steps, long num_envs, long obs_size, std::size_t action_space_size,
+							   torch::ScalarType obs_dtype, torch::ScalarType value_dtype, torch::Device device)
+	: RolloutStorage(num_steps, num_envs, obs_size)
+{
+	check_float_dtype(obs_dtype, "observations");
+	check_float_dtype(value_dtype, "values");
+	const auto options = torch::TensorOptions().device(device);
+	m_obs			   = torch::zeros({num_steps, num_envs, obs_size}, options.dtype(obs_dtype));
+	m_actions		   = torch::zeros({num_steps, num_envs}, options.dtype(action_dtype(action_space_size)));
+	m_logprobs		   = torch::zeros({num_steps, num_envs}, options.dtype(torch::kFloat32));
+	m_rewards		   = torch::zeros({num_steps, num_envs}, options.dtype(torch::kFloat32));
+	m_dones			   = torch::zeros({num_steps, (num_envs + 7) / 8}, options.dtype(torch::kUInt8));
+	m_values		   = torch::zeros({num_steps, num_envs}, options.dtype(value_dtype));
+	m_bit_weights	   = torch::tensor({1, 2, 4, 8, 16, 32, 64, 128}, options.dtype(torch::kUInt8));
+}
+
+RolloutStorage RolloutStorage::wrap(torch::Tensor obs, const torch::Tensor& actions, torch::Tensor logprobs,
+									torch::Tensor rewards, const torch::Tensor& dones, torch::Tensor values,
+									std::size_t action_space_size)
+{
+	RolloutStorage storage(obs.size(0), obs.size(1), obs.size(2));
+	storage.m_bit_weights = torch::tensor({1, 2, 4, 8, 16, 32, 64, 128}, obs.options().dtype(torch::kUInt8));
+	storage.m_obs		  = std::move(obs);
+	storage.m_actions	  = actions.to(action_dtype(action_space_size));
+	storage.m_logprobs	  = std::move(logprobs);
+	storage.m_rewards	  = std::move(rewards);
+	storage.m_dones		  = storage.pack_bits(dones);
+	storage.m_values	  = std::move(values);
+	return storage;
+}
+
+torch::Tensor RolloutStorage::pack_bits(const torch::Tensor& flags) const
+{
+	const long padded = (m_num_envs + 7) / 8 * 8;
+	auto	   rows	  = flags.reshape({-1, m_num_envs});
+	auto	   bits	  = torch::zeros({rows.size(0), padded}, m_bit_weights.options());
+	bits.slice(1, 0, m_num_envs).copy_(rows.ne(0));
+	return bits.view({rows.size(0), -1, 8}).mul(m_bit_weights).sum(-1).to(torch::kUInt8);
+}
+
+torch::Tensor RolloutStorage::unpack_bits(const torch::Tensor& packed) const
+{
+	auto bits = packed.unsqueeze(-1).bitwise_and(m_bit_weights).ne(0);
+	return bits.flatten(-2).slice(-1, 0, m_num_envs).to(torch::kFloat32);
+}
+
+void RolloutStorage::store(long step, const torch::Tensor& obs, const torch::Tensor& action,
+						   const torch::Tensor& logprob, const torch::Tensor& reward, const torch::Tensor& done,
+						   const torch::Tensor& value)
+{
+	if (obs.defined())
+	{
+		m_obs[step].copy_(obs.reshape({m_num_envs, m_obs_size}));
+	}
+	m_actions[step].copy_(action.reshape(-1));
+	m_logprobs[step].copy_(logprob.reshape(-1));
+	if (reward.defined())
+	{
+		m_rewards[step].copy_(reward.reshape(-1));
+	}
+	m_dones[step].copy_(pack_bits(done.to(m_dones.device()))[0]);
+	m_values[step].copy_(value.reshape(-1));
+}
+
+// Row step of a [num_steps, ...] column as writable floats, empty unless the column is float32 in host memory
+static std::span<float> float_row(torch::Tensor& column, long step)
+{
+	if (!column.is_cpu() || column.scalar_type() != torch::kFloat32 || !column.is_contiguous())
+	{
+		return {};
+	}
+	const auto row_size = static_cast<std::size_t>(column.numel() / column.size(0));
+	return {column.data_ptr<float>() + static_cast<std::size_t>(step) * row_size, row_size};
+}
+
+std::span<float> RolloutStorage::observation_row(long step)
+{
+	return float_row(m_obs, step);
+}
+std::span<float> RolloutStorage::reward_row(long step)
+{
+	return float_row(m_rewards, step);
+}
+
+torch::Tensor RolloutStorage::observations() const
+{
+	return m_obs.to(torch::kFloat32);
+}
+torch::Tensor RolloutStorage::actions() const
+{
+	return m_actions.to(torch::kLong);
+}
+torch::Tensor RolloutStorage::logprobs() const
+{
+	return m_logprobs;
+}
+torch::Tensor RolloutStorage::rewards() const
+{
+	return m_rewards;
+}
+torch::Tensor RolloutStorage::dones() const
+{
+	return unpack_bits(m_dones);
+}
+torch::Tensor RolloutStorage::values() const
+{
+	return m_values.to(torch::kFloat32);
+}
+
+torch::Tensor RolloutStorage::gather_observations(const torch::Tensor& indices) const
+{
+	return m_obs.view({m_num_steps * m_num_envs, m_obs_size}).index_select(0, indices).to(torch::kFloat32);
+}
+torch::Tensor RolloutStorage::gather_actions(const torch::Tensor& indices) const
+{
+	return m_actions.view({m_num_steps * m_num_envs}).index_select(0, indices).to(torch::kLong);
+}
+torch::Tensor RolloutStorage::gather_logprobs(const torch::Tensor& indices) const
+{
+	return m_logprobs.view({m_num_steps * m_num_envs}).index_select(0, indices);
+}
+
+RolloutStorage::StoredRows RolloutStorage::gather_stored(const torch::Tensor& indices) const
+{
+	const long batch = m_num_steps * m_num_envs;
+	return {
+		m_obs.view({batch, m_obs_size}).index_select(0, indices),
+		m_actions.view({batch}).index_select(0, indices),
+		m_logprobs.view({batch}).index_select(0, indices),
+	};
+}
+
+long RolloutStorage::num_steps() const
+{
+	return m_num_steps;
+}
+long RolloutStorage::num_envs() const
+{
+	return m_num_envs;
+}
+long RolloutStorage::obs_size() const
+{
+	return m_obs_size;
+}
+std::size_t RolloutStorage::bytes() const
+{
+	return m_obs.nbytes() + m_actions.nbytes() + m_logprobs.nbytes() + m_rewards.nbytes() + m_dones.nbytes()
+		 + m_values.nbytes();
+}
@@ -0,0 +1,323 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/SharedMemory.hpp>
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t)
+				  && std::atomic<std::uint32_t>::is_always_lock_free,
+			  "Futexes need plain 32 bit atomics");
+
+static constexpr std::size_t k_alignment	 = 64;
+static constexpr std::size_t k_control_bytes = 4096;
+
+static std::size_t align_up(std::size_t offset, std::size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+SharedMapping::SharedMapping(std::size_t bytes)
+	: m_size(bytes)
+{
+	void* data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error(std::format("Could not map {} bytes of shared memory", m_size));
+	}
+	m_data = static_cast<std::byte*>(data);
+}
+
+SharedMapping::~SharedMapping()
+{
+	::munmap(m_data, m_size);
+}
+
+std::byte* SharedMapping::data() const
+{
+	return m_data;
+}
+
+std::size_t SharedMapping::size() const
+{
+	return m_size;
+}
+
+void shared_wait(const std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::milliseconds timeout)
+{
+	const auto		seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+	const timespec	relative{static_cast<time_t>(seconds.count()),
+							 static_cast<long>(std::chrono::nanoseconds(timeout - seconds).count())};
+	// Spurious wakeups, timeouts and EAGAIN (the word already changed) all just return, callers loop
+	::syscall(SYS_futex, reinterpret_cast<const std::uint32_t*>(&word), FUTEX_WAIT, expected, &relative, nullptr, 0);
+}
+
+void shared_wake_all(std::atomic<std::uint32_t>& word)
+{
+	::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+struct SharedWeights::Control
+{
+	std::atomic<std::uint32_t> version{0};
+	std::atomic<std::uint32_t> sequence[2]{};		 // Odd while the writer fills the buffer
+	std::atomic<std::uint32_t> buffer_version[2]{}; // Version each buffer holds, read inside the sequence window
+};
+
+SharedWeights::SharedWeights(std::size_t num_floats)
+	: m_num_floats(num_floats)
+	, m_mapping(k_alignment + 2 * align_up(num_floats * sizeof(float), k_alignment))
+{
+	new (m_mapping.data()) Control{};
+}
+
+SharedWeights::Control* SharedWeights::control() const
+{
+	return std::launder(reinterpret_cast<Control*>(m_mapping.data()));
+}
+
+const float* SharedWeights::buffer(std::size_t index) const
+{
+	const auto offset = k_alignment + index * align_up(m_num_floats * sizeof(float), k_alignment);
+	return reinterpret_cast<const float*>(m_mapping.data() + offset);
+}
+
+void SharedWeights::publish(std::uint32_t version, const float* weights)
+{
+	auto*		 c		  = control();
+	const auto	 index	  = version % 2;
+	auto&		 sequence = c->sequence[index];
+	const auto	 start	  = sequence.load(std::memory_order_relaxed);
+	sequence.store(start + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(const_cast<float*>(buffer(index)), weights, m_num_floats * sizeof(float));
+	c->buffer_version[index].store(version, std::memory_order_relaxed);
+	sequence.store(start + 2, std::memory_order_release);
+	c->version.store(version, std::memory_order_release);
+	shared_wake_all(c->version);
+}
+
+std::uint32_t SharedWeights::read(float* out) const
+{
+	const auto* c = control();
+	while (true)
+	{
+		const auto index = c->version.load(std::memory_order_acquire) % 2;
+		const auto start = c->sequence[index].load(std::memory_order_acquire);
+		if (start % 2 != 0)
+		{
+			continue;
+		}
+		std::memcpy(out, buffer(index), m_num_floats * sizeof(float));
+		const auto version = c->buffer_version[index].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (c->sequence[index].load(std::memory_order_relaxed) == start)
+		{
+			return version;
+		}
+	}
+}
+
+std::uint32_t SharedWeights::version() const
+{
+	return control()->version.load(std::memory_order_acquire);
+}
+
+std::atomic<std::uint32_t>& SharedWeights::version_word()
+{
+	return control()->version;
+}
+
+std::size_t SharedWeights::size() const
+{
+	return m_num_floats;
+}
+
+struct SharedRolloutRing::Control
+{
+	std::atomic<std::uint32_t> ready[k_num_slots]{};
+	std::atomic<std::uint32_t> stop{0};
+	std::atomic<std::uint32_t> start{0};
+	std::atomic<std::uint32_t> failed{0}; // 1 while the first error is written, 2 once it can be read
+	char					   error[k_error_capacity]{};
+};
+
+SharedRolloutRing::Layout SharedRolloutRing::make_layout(std::size_t num_steps, std::size_t num_envs,
+														 std::size_t obs_size, std::size_t num_actors)
+{
+	const std::size_t rows	 = num_steps * num_envs;
+	std::size_t		  offset = 0;
+	const auto column = [&](std::size_t bytes) {
+		const auto start = offset;
+		offset			 = align_up(offset + bytes, k_alignment);
+		return start;
+	};
+	Layout layout{};
+	layout.observations = column(rows * obs_size * sizeof(float));
+	layout.actions		= column(rows * sizeof(std::int64_t));
+	layout.logprobs		= column(rows * sizeof(float));
+	layout.values		= column(rows * sizeof(float));
+	layout.rewards		= column(rows * sizeof(float));
+	layout.dones		= column(rows * sizeof(float));
+	layout.next_values	= column(num_envs * sizeof(float));
+	layout.next_dones	= column(num_envs * sizeof(float));
+	layout.reports		= column(num_actors * sizeof(ActorReport));
+	layout.slot_bytes	= align_up(offset, k_control_bytes);
+	return layout;
+}
+
+SharedRolloutRing::SharedRolloutRing(std::size_t num_steps, std::size_t num_envs, std::size_t obs_size,
+									 std::size_t num_actors)
+	: m_num_steps(num_steps)
+	, m_num_envs(num_envs)
+	, m_obs_size(obs_size)
+	, m_num_actors(num_actors)
+	, m_layout(make_layout(num_steps, num_envs, obs_size, num_actors))
+	, m_mapping(k_control_bytes + k_num_slots * m_layout.slot_bytes)
+{
+	if (num_actors == 0 || num_envs % num_actors != 0)
+	{
+		throw std::invalid_argument(
+			std::format("{} envs cannot be split evenly over {} actor processes", num_envs, num_actors));
+	}
+	static_assert(sizeof(Control) <= k_control_bytes);
+	new (m_mapping.data()) Control{};
+	for (std::size_t slot = 0; slot < k_num_slots; slot++)
+	{
+		for (std::size_t actor = 0; actor < num_actors; actor++)
+		{
+			new (&report(slot, actor)) ActorReport{};
+		}
+	}
+}
+
+SharedRolloutRing::Control* SharedRolloutRing::control() const
+{
+	return std::launder(reinterpret_cast<Control*>(m_mapping.data()));
+}
+
+std::byte* SharedRolloutRing::slot_data(std::size_t slot) const
+{
+	return m_mapping.data() + k_control_bytes + slot * m_layout.slot_bytes;
+}
+
+float* SharedRolloutRing::observations(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.observations);
+}
+
+std::int64_t* SharedRolloutRing::actions(std::size_t slot) const
+{
+	return reinterpret_cast<std::int64_t*>(slot_data(slot) + m_layout.actions);
+}
+
+float* SharedRolloutRing::logprobs(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.logprobs);
+}
+
+float* SharedRolloutRing::values(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.values);
+}
+
+float* SharedRolloutRing::rewards(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.rewards);
+}
+
+float* SharedRolloutRing::dones(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.dones);
+}
+
+float* SharedRolloutRing::next_values(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.next_values);
+}
+
+float* SharedRolloutRing::next_dones(std::size_t slot) const
+{
+	return reinterpret_cast<float*>(slot_data(slot) + m_layout.next_dones);
+}
+
+ActorReport& SharedRolloutRing::report(std::size_t slot, std::size_t actor) const
+{
+	return reinterpret_cast<ActorReport*>(slot_data(slot) + m_layout.reports)[actor];
+}
+
+std::atomic<std::uint32_t>& SharedRolloutRing::ready(std::size_t slot) const
+{
+	return control()->ready[slot];
+}
+
+std::atomic<std::uint32_t>& SharedRolloutRing::stop() const
+{
+	return control()->stop;
+}
+
+std::atomic<std::uint32_t>& SharedRolloutRing::start() const
+{
+	return control()->start;
+}
+
+void SharedRolloutRing::set_error(const std::string& message)
+{
+	auto*		  c		   = control();
+	std::uint32_t expected = 0;
+	if (!c->failed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+	{
+		return;
+	}
+	const auto length = std::min(message.size(), k_error_capacity - 1);
+	std::memcpy(c->error, message.data(), length);
+	c->error[length] = '\0';
+	c->failed.store(2, std::memory_order_release);
+	// The learner waits on the ready counts
+	for (auto& ready : c->ready)
+	{
+		shared_wake_all(ready);
+	}
+}
+
+bool SharedRolloutRing::failed() const
+{
+	return control()->failed.load(std::memory_order_acquire) == 2;
+}
+
+std::string SharedRolloutRing::error() const
+{
+	return failed() ? std::string(control()->error) : std::string();
+}
+
+std::size_t SharedRolloutRing::num_steps() const
+{
+	return m_num_steps;
+}
+
+std::size_t SharedRolloutRing::num_envs() const
+{
+	return m_num_envs;
+}
+
+std::size_t SharedRolloutRing::obs_size() const
+{
+	return m_obs_size;
+}
+
+std::size_t SharedRolloutRing::num_actors() const
+{
+	return m_num_actors;
+}
+
+std::size_t SharedRolloutRing::envs_per_actor() const
+{
+	return m_num_envs / m_num_actors;
+}
@@ -2,12 +2,11 @@
 // Created by chris on 11/14/25.
 //
 #include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/Checkpoint.hpp>
+#include <swarm/SwarmRenderer.hpp>
 
-torch::Tensor SimpleMovingEnvironment::get_current_observation() const
+void SimpleMovingEnvironment::write_observation(float* out) const
 {
-	std::vector<float> observations;
-	observations.push_back(velocity.x);
-	observations.push_back(velocity.y);
 	auto goal_dir = goal - position;
 	auto dist = goal_dir.length();
 	if (dist > 1e-6f) {
@@ -21,15 +20,38 @@ torch::Tensor SimpleMovingEnvironment::get_current_observation() const
 
 	float max_dist = std::sqrt(1920.0f * 1920.0f + 1080.0f * 1080.0f); // ~2200
 	float norm_dist = dist / max_dist;
-	observations.push_back(goal_dir.x);
-	observations.push_back(goal_dir.y);
-	observations.push_back(norm_dist);
-	return torch::tensor(observations, torch::kFloat32);
+	out[0] = velocity.x;
+	out[1] = velocity.y;
+	out[2] = goal_dir.x;
+	out[3] = goal_dir.y;
+	out[4] = norm_dist;
+}
+
+torch::Tensor SimpleMovingEnvironment::get_current_observation() const
+{
+	auto observations = torch::empty({5}, torch::kFloat32);
+	write_observation(observations.data_ptr<float>());
+	return observations;
 }
 
 Environment::StepResult SimpleMovingEnvironment::step(const torch::Tensor& action)
 {
-	long action_val = action.item<long>();
+	const std::int64_t action_val = action.item<long>();
+	auto observations = torch::empty({5}, torch::kFloat32);
+	float reward = 0.0f;
+	float done = 0.0f;
+	step_into({{&action_val, 1}, {observations.data_ptr<float>(), 5}, {&reward, 1}, {&done, 1}});
+	return {
+		observations,
+		torch::tensor(reward, torch::kFloat32),
+		torch::tensor(done,  torch::kFloat32)
+	};
+}
+
+void SimpleMovingEnvironment::step_into(const StepBuffers& buffers)
+{
+	check_buffers(buffers);
+	const auto action_val = buffers.actions[0];
 	velocity = {0, 0}; // Reset velocity
 	switch (action_val)
 	{
@@ -65,11 +87,9 @@ Environment::StepResult SimpleMovingEnvironment::step(const torch::Tensor& actio
 
 	last_distance = new_dist;
 
-	return {
-		get_current_observation(),
-		torch::tensor(reward, torch::kFloat32),
-		torch::tensor(done,  torch::kFloat32)
-	};
+	buffers.rewards[0] = reward;
+	buffers.dones[0] = static_cast<float>(done);
+	write_observation(buffers.observations.data());
 }
 std::size_t	  SimpleMovingEnvironment::get_observation_size() const
 {
@@ -79,40 +99,64 @@ std::size_t	  SimpleMovingEnvironment::get_action_space_size() const
 {
 	return 4; // Right Left Up Do
 }
-torch::Tensor SimpleMovingEnvironment::reset()
+void SimpleMovingEnvironment::reset_world()
 {
-	std::mt19937_64 rng{std::random_device{}()};
-	std::uniform_real_distribution<float> x_dist{0, 1920};
-	std::uniform_real_distribution<float> y_dist{0, 1080};
-	std::uniform_real_distribution<float> vel_dis{-30, 30};
-
-	position.x = x_dist(rng);
-	position.y = y_dist(rng);
-	velocity.x = vel_dis(rng);
-	velocity.y = vel_dis(rng);
-	goal.x = x_dist(rng);
-	goal.y = y_dist(rng);
+	position.x = rng.uniform(0, 1920);
+	position.y = rng.uniform(0, 1080);
+	velocity.x = rng.uniform(-30, 30);
+	velocity.y = rng.uniform(-30, 30);
+	goal.x = rng.uniform(0, 1920);
+	goal.y = rng.uniform(0, 1080);
 
 	last_distance = (goal - position).length();
-	goal_shape.setPosition(goal);
+}
+torch::Tensor SimpleMovingEnvironment::reset()
+{
+	reset_world();
 	return get_current_observation();
 }
+void SimpleMovingEnvironment::reset_into(std::span<float> observations)
+{
+	check_observations(observations);
+	reset_world();
+	write_observation(observations.data());
+}
+void SimpleMovingEnvironment::seed(std::uint64_t seed, std::uint64_t first_stream)
+{
+	rng.seed(seed, first_stream);
+}
+bool SimpleMovingEnvironment::save_state(torch::serialize::OutputArchive& archive) const
+{
+	write_floats(archive, "state", {position.x, position.y, velocity.x, velocity.y, goal.x, goal.y, last_distance});
+	write_rng(archive, "rng", rng);
+	return true;
+}
+void SimpleMovingEnvironment::load_state(torch::serialize::InputArchive& archive)
+{
+	std::vector<float> state(7);
+	read_floats(archive, "state", state);
+	position	  = {state[0], state[1]};
+	velocity	  = {state[2], state[3]};
+	goal		  = {state[4], state[5]};
+	last_distance = state[6];
+	read_rng(archive, "rng", rng);
+}
 std::unique_ptr<Environment> SimpleMovingEnvironment::clone() const
 {
-	return std::make_unique<SimpleMovingEnvironment>(*this);
+	auto copy = std::make_unique<SimpleMovingEnvironment>(*this);
+	copy->rng.seed(std::random_device{}()); // Clones must not replay our episodes
+	return copy;
+}
+void SimpleMovingEnvironment::write_snapshot(SwarmSnapshot& snapshot) const
+{
+	snapshot.agents.push_back(position);
+	snapshot.goals.push_back(goal);
 }
 void SimpleMovingEnvironment::set_goal(sf::Vector2f new_goal_pos)
 {
 	goal = new_goal_pos;
-	goal_shape.setPosition(goal);
 }
 void SimpleMovingEnvironment::toggle_log()
 {
 	write_logs = !write_logs;
-}
-void SimpleMovingEnvironment::draw(sf::RenderTarget& target, sf::RenderStates states) const
-{
-	agent_shape.setPosition(position);
-	target.draw(agent_shape, states);
-	target.draw(goal_shape, states);
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/SimulationThread.hpp>
+
+SimulationThread::SimulationThread(std::unique_ptr<Environment> env, torch::Tensor observation, Policy policy,
+								   std::chrono::nanoseconds tick)
+	: m_env(std::move(env))
+	, m_policy(std::move(policy))
+	, m_tick(tick)
+	, m_observation(std::move(observation))
+{
+	m_env->write_snapshot(m_snapshots.back());
+	m_snapshots.publish();
+	m_thread = std::jthread([this](std::stop_token stop) { run(std::move(stop)); });
+}
+
+SimulationThread::~SimulationThread()
+{
+	m_thread.request_stop();
+}
+
+void SimulationThread::run(std::stop_token stop)
+{
+	try
+	{
+		torch::NoGradGuard no_grad;
+		auto			   next = std::chrono::steady_clock::now();
+		while (!stop.stop_requested())
+		{
+			step();
+			next += m_tick;
+			const auto now = std::chrono::steady_clock::now();
+			if (next < now)
+			{
+				next = now;
+			}
+			std::this_thread::sleep_until(next);
+		}
+	}
+	catch (...)
+	{
+		m_error = std::current_exception();
+		m_failed.store(true, std::memory_order_release);
+	}
+}
+
+void SimulationThread::step()
+{
+	sf::Vector2f goal;
+	while (m_goals.try_pop(goal))
+	{
+		m_env->set_goal(goal);
+	}
+	auto result	  = m_env->step(m_policy(m_observation));
+	m_observation = std::move(result.observations);
+
+	auto& snapshot = m_snapshots.back();
+	snapshot.clear();
+	m_env->write_snapshot(snapshot);
+	snapshot.tick = ++m_ticks;
+	m_snapshots.publish();
+}
+
+bool SimulationThread::poll_snapshot()
+{
+	if (m_failed.load(std::memory_order_acquire) && m_error)
+	{
+		std::rethrow_exception(std::exchange(m_error, nullptr));
+	}
+	return m_snapshots.update();
+}
+
+const SwarmSnapshot& SimulationThread::snapshot() const
+{
+	return m_snapshots.front();
+}
+
+bool SimulationThread::set_goal(sf::Vector2f goal)
+{
+	return m_goals.try_push(goal);
+}
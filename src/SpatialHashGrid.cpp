@@ -0,0 +1,300 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/SpatialHashGrid.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+// On x86-64 with GCC or Clang the distance test is compiled for AVX2 and AVX-512 with target attributes and picked at
+// runtime like the dense kernels, other builds only have the scalar loop
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SWARM_GRID_DISPATCH 1
+#define SWARM_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// The points j .. last of scan_run, all of them without SIMD and the leftovers of the SIMD blocks
+template <typename Hit>
+static void scan_tail(const float* xs, const float* ys, std::size_t j, std::size_t last, float x, float y,
+					  const float& r2, Hit& hit)
+{
+	for (; j < last; j++)
+	{
+		const float dx = xs[j] - x;
+		const float dy = ys[j] - y;
+		const float d2 = dx * dx + dy * dy;
+		if (d2 <= r2)
+		{
+			hit(j, d2);
+		}
+	}
+}
+
+#ifdef SWARM_GRID_DISPATCH
+// Squared distances of 16 / 8 consecutive points to (x, y) into d2, returns the bit mask of those within r2
+SWARM_TARGET("avx512f")
+static std::uint32_t within_mask_avx512(const float* xs, const float* ys, float x, float y, float r2, float* d2)
+{
+	const __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(xs), _mm512_set1_ps(x));
+	const __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(ys), _mm512_set1_ps(y));
+	const __m512 d	= _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+	_mm512_storeu_ps(d2, d);
+	return _mm512_cmp_ps_mask(d, _mm512_set1_ps(r2), _CMP_LE_OQ);
+}
+
+SWARM_TARGET("avx2")
+static std::uint32_t within_mask_avx2(const float* xs, const float* ys, float x, float y, float r2, float* d2)
+{
+	const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs), _mm256_set1_ps(x));
+	const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys), _mm256_set1_ps(y));
+	const __m256 d	= _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+	_mm256_storeu_ps(d2, d);
+	return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_set1_ps(r2), _CMP_LE_OQ)));
+}
+
+template <typename Hit>
+SWARM_TARGET("avx512f")
+static void scan_run_avx512(const float* xs, const float* ys, std::size_t first, std::size_t last, float x, float y,
+							const float& r2, Hit& hit)
+{
+	std::size_t j = first;
+	float		d2[16];
+	for (; j + 16 <= last; j += 16)
+	{
+		for (std::uint32_t mask = within_mask_avx512(xs + j, ys + j, x, y, r2, d2); mask != 0; mask &= mask - 1)
+		{
+			const auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+			hit(j + lane, d2[lane]);
+		}
+	}
+	scan_tail(xs, ys, j, last, x, y, r2, hit);
+}
+
+template <typename Hit>
+SWARM_TARGET("avx2")
+static void scan_run_avx2(const float* xs, const float* ys, std::size_t first, std::size_t last, float x, float y,
+						  const float& r2, Hit& hit)
+{
+	std::size_t j = first;
+	float		d2[8];
+	for (; j + 8 <= last; j += 8)
+	{
+		for (std::uint32_t mask = within_mask_avx2(xs + j, ys + j, x, y, r2, d2); mask != 0; mask &= mask - 1)
+		{
+			const auto lane = static_cast<std::size_t>(std::countr_zero(mask));
+			hit(j + lane, d2[lane]);
+		}
+	}
+	scan_tail(xs, ys, j, last, x, y, r2, hit);
+}
+#endif
+
+enum class GridIsa
+{
+	Scalar,
+	Avx2,
+	Avx512,
+};
+
+static GridIsa grid_isa()
+{
+	static const GridIsa isa = [] {
+#ifdef SWARM_GRID_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return GridIsa::Avx512;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return GridIsa::Avx2;
+		}
+#endif
+		return GridIsa::Scalar;
+	}();
+	return isa;
+}
+
+// Calls hit(j, d2) for every point j in [first, last) within r2. r2 is re-read per block so a caller can shrink it.
+template <typename Hit>
+static void scan_run(const float* xs, const float* ys, std::size_t first, std::size_t last, float x, float y,
+					 const float& r2, Hit&& hit)
+{
+	switch (grid_isa())
+	{
+#ifdef SWARM_GRID_DISPATCH
+		case GridIsa::Avx512:
+			scan_run_avx512(xs, ys, first, last, x, y, r2, hit);
+			return;
+		case GridIsa::Avx2:
+			scan_run_avx2(xs, ys, first, last, x, y, r2, hit);
+			return;
+#endif
+		default:
+			scan_tail(xs, ys, first, last, x, y, r2, hit);
+	}
+}
+
+const char* SpatialHashGrid::simd_isa()
+{
+	switch (grid_isa())
+	{
+		case GridIsa::Avx512:
+			return "avx512";
+		case GridIsa::Avx2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
+
+SpatialHashGrid::SpatialHashGrid(float width, float height, float cell_size)
+	: m_cell_size(cell_size)
+	, m_inv_cell_size(1.0f / cell_size)
+{
+	if (!(width > 0.0f) || !(height > 0.0f) || !(cell_size > 0.0f))
+	{
+		throw std::invalid_argument(
+			std::format("SpatialHashGrid needs a positive size and cell size, got {}x{} / {}", width, height, cell_size));
+	}
+	m_cells_x = static_cast<std::size_t>(std::ceil(width / cell_size));
+	m_cells_y = static_cast<std::size_t>(std::ceil(height / cell_size));
+	m_cell_start.assign(m_cells_x * m_cells_y + 1, 0);
+}
+
+std::size_t SpatialHashGrid::cell_x(float x) const
+{
+	const float c = std::floor(x * m_inv_cell_size);
+	// Out of the world (or NaN) goes to the border cells
+	if (!(c > 0.0f))
+	{
+		return 0;
+	}
+	return std::min(static_cast<std::size_t>(std::min(c, 1e9f)), m_cells_x - 1);
+}
+
+std::size_t SpatialHashGrid::cell_y(float y) const
+{
+	const float c = std::floor(y * m_inv_cell_size);
+	if (!(c > 0.0f))
+	{
+		return 0;
+	}
+	return std::min(static_cast<std::size_t>(std::min(c, 1e9f)), m_cells_y - 1);
+}
+
+void SpatialHashGrid::rebuild(std::span<const float> x, std::span<const float> y)
+{
+	if (x.size() != y.size())
+	{
+		throw std::invalid_argument(std::format("Got {} x but {} y coordinates", x.size(), y.size()));
+	}
+	if (x.size() >= k_no_point)
+	{
+		throw std::invalid_argument(std::format("SpatialHashGrid holds at most {} points", k_no_point - 1));
+	}
+	const std::size_t n = x.size();
+	m_cell_of.resize(n);
+	m_x.resize(n);
+	m_y.resize(n);
+	m_index.resize(n);
+	std::fill(m_cell_start.begin(), m_cell_start.end(), 0);
+
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const auto cell = static_cast<std::uint32_t>(cell_y(y[i]) * m_cells_x + cell_x(x[i]));
+		m_cell_of[i]	= cell;
+		m_cell_start[cell + 1]++;
+	}
+	for (std::size_t c = 1; c < m_cell_start.size(); c++)
+	{
+		m_cell_start[c] += m_cell_start[c - 1];
+	}
+	// Scatter with m_cell_start[c] as the write cursor, afterwards it holds the end of c, i.e. the start of c + 1
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const std::uint32_t slot = m_cell_start[m_cell_of[i]]++;
+		m_x[slot]				 = x[i];
+		m_y[slot]				 = y[i];
+		m_index[slot]			 = static_cast<std::uint32_t>(i);
+	}
+	std::copy_backward(m_cell_start.begin(), m_cell_start.end() - 1, m_cell_start.end());
+	m_cell_start[0] = 0;
+}
+
+template <typename Visit>
+void SpatialHashGrid::for_each_run(float x, float y, float radius, Visit&& visit) const
+{
+	const std::size_t x0 = cell_x(x - radius);
+	const std::size_t x1 = cell_x(x + radius);
+	const std::size_t y0 = cell_y(y - radius);
+	const std::size_t y1 = cell_y(y + radius);
+	for (std::size_t cy = y0; cy <= y1; cy++)
+	{
+		visit(m_cell_start[cy * m_cells_x + x0], m_cell_start[cy * m_cells_x + x1 + 1]);
+	}
+}
+
+void SpatialHashGrid::query_radius(float x, float y, float radius, std::vector<std::uint32_t>& out,
+								   std::uint32_t exclude) const
+{
+	const float r2 = radius * radius;
+	for_each_run(x, y, radius, [&](std::size_t first, std::size_t last) {
+		scan_run(m_x.data(), m_y.data(), first, last, x, y, r2, [&](std::size_t j, float) {
+			if (m_index[j] != exclude)
+			{
+				out.push_back(m_index[j]);
+			}
+		});
+	});
+}
+
+std::size_t SpatialHashGrid::query_knn(float x, float y, float radius, std::span<std::uint32_t> index,
+									   std::span<float> dist2, std::uint32_t exclude) const
+{
+	const std::size_t k = std::min(index.size(), dist2.size());
+	if (k == 0)
+	{
+		return 0;
+	}
+	std::size_t found = 0;
+	// Once k points are found only closer ones can get in, the bound shrinks the SIMD test with it
+	float bound = radius * radius;
+	for_each_run(x, y, radius, [&](std::size_t first, std::size_t last) {
+		scan_run(m_x.data(), m_y.data(), first, last, x, y, bound, [&](std::size_t j, float d2) {
+			if (m_index[j] == exclude || (found == k && d2 >= dist2[k - 1]))
+			{
+				return;
+			}
+			std::size_t pos = found < k ? found++ : k - 1;
+			for (; pos > 0 && dist2[pos - 1] > d2; pos--)
+			{
+				dist2[pos] = dist2[pos - 1];
+				index[pos] = index[pos - 1];
+			}
+			dist2[pos] = d2;
+			index[pos] = m_index[j];
+			if (found == k)
+			{
+				bound = dist2[k - 1];
+			}
+		});
+	});
+	return found;
+}
+
+std::size_t SpatialHashGrid::get_num_points() const
+{
+	return m_index.size();
+}
+std::size_t SpatialHashGrid::get_num_cells() const
+{
+	return m_cells_x * m_cells_y;
+}
+float SpatialHashGrid::get_cell_size() const
+{
+	return m_cell_size;
+}
@@ -0,0 +1,135 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/StackedAgent.hpp>
+#include <array>
+#include <format>
+#include <stdexcept>
+
+// Linear layers sit at index 0, 2 and 4 of Agent's Sequentials
+static constexpr std::size_t k_num_layers = 3;
+static constexpr std::array	 k_networks{"actor", "critic"};
+
+StackedAgent::StackedAgent(const std::vector<Agent*>& agents)
+	: m_num_policies(agents.size())
+{
+	if (agents.empty())
+	{
+		throw std::invalid_argument("A StackedAgent needs at least one agent");
+	}
+	torch::NoGradGuard nograd;
+	for (const std::string network : k_networks)
+	{
+		auto& layers = network == "actor" ? m_actor : m_critic;
+		for (std::size_t layer = 0; layer < k_num_layers; layer++)
+		{
+			const auto				   prefix = std::format("{}.{}.", network, layer * 2);
+			std::vector<torch::Tensor> weights;
+			std::vector<torch::Tensor> biases;
+			for (auto* agent : agents)
+			{
+				auto params = agent->named_parameters();
+				weights.push_back(params[prefix + "weight"].detach().t());
+				biases.push_back(params[prefix + "bias"].detach().unsqueeze(0));
+			}
+			// Stacking throws when the agents' layer sizes differ
+			const auto name = std::format("{}_{}_", network, layer);
+			auto&	   weight = register_parameter(name + "weight", torch::stack(weights).contiguous());
+			auto&	   bias	  = register_parameter(name + "bias", torch::stack(biases).contiguous());
+			layers.push_back({weight, bias});
+		}
+	}
+}
+
+torch::Tensor StackedAgent::forward(const std::vector<Layer>& layers, torch::Tensor x)
+{
+	for (std::size_t i = 0; i < layers.size(); i++)
+	{
+		x = torch::baddbmm(layers[i].bias, x, layers[i].weight);
+		if (i + 1 < layers.size())
+		{
+			x = torch::tanh(x);
+		}
+	}
+	return x;
+}
+
+torch::Tensor StackedAgent::get_value(const torch::Tensor& observations)
+{
+	return forward(m_critic, observations);
+}
+
+torch::Tensor StackedAgent::actor_logits(const torch::Tensor& observations)
+{
+	return forward(m_actor, observations);
+}
+
+Agent::ActionDetails StackedAgent::get_action_and_value(const torch::Tensor& observations,
+														const torch::Tensor& actions)
+{
+	return details(observations, actor_logits(observations), actions);
+}
+
+Agent::ActionDetails StackedAgent::sample_action_and_value(const torch::Tensor& observations,
+														   const torch::Tensor& uniform)
+{
+	auto	   logits	 = actor_logits(observations);
+	auto	   cdf		 = torch::softmax(logits, -1).cumsum(-1);
+	const long last		 = cdf.size(-1) - 1;
+	auto	   threshold = uniform.unsqueeze(-1) * cdf.narrow(-1, last, 1);
+	auto	   action	 = (cdf <= threshold).sum(-1).clamp_max(last);
+	return details(observations, logits, action);
+}
+
+Agent::ActionDetails StackedAgent::details(const torch::Tensor& observations, const torch::Tensor& logits,
+										   const torch::Tensor& sampled_action)
+{
+	auto log_probs		 = torch::log_softmax(logits, -1);
+	auto action_log_prob = log_probs.gather(-1, sampled_action.unsqueeze(-1)).squeeze(-1);
+	auto entropy		 = -(log_probs.exp() * log_probs).sum(-1);
+	return {sampled_action, action_log_prob, entropy, get_value(observations)};
+}
+
+torch::Tensor StackedAgent::clip_grad_norm(double max_norm)
+{
+	torch::NoGradGuard		   nograd;
+	std::vector<torch::Tensor> squares;
+	for (const auto& p : parameters())
+	{
+		if (p.grad().defined())
+		{
+			squares.push_back(p.grad().pow(2).flatten(1).sum(1));
+		}
+	}
+	auto norms = torch::stack(squares).sum(0).sqrt();
+	auto scale = (max_norm / (norms + 1e-6)).clamp_max(1.0).view({-1, 1, 1});
+	for (const auto& p : parameters())
+	{
+		if (p.grad().defined())
+		{
+			p.grad().mul_(scale);
+		}
+	}
+	return norms;
+}
+
+void StackedAgent::unstack_into(std::size_t k, Agent& agent) const
+{
+	torch::NoGradGuard nograd;
+	auto			   params = agent.named_parameters();
+	for (const std::string network : k_networks)
+	{
+		const auto& layers = network == "actor" ? m_actor : m_critic;
+		for (std::size_t layer = 0; layer < k_num_layers; layer++)
+		{
+			const auto prefix = std::format("{}.{}.", network, layer * 2);
+			params[prefix + "weight"].copy_(layers[layer].weight[static_cast<long>(k)].t());
+			params[prefix + "bias"].copy_(layers[layer].bias[static_cast<long>(k)].squeeze(0));
+		}
+	}
+}
+
+std::size_t StackedAgent::num_policies() const
+{
+	return m_num_policies;
+}
@@ -0,0 +1,53 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/SwarmRenderer.hpp>
+
+void SwarmSnapshot::clear()
+{
+	agents.clear();
+	goals.clear();
+}
+
+// Two triangles covering [position, position + size]
+static sf::Vertex* write_quad(sf::Vertex* out, sf::Vector2f position, float size, sf::Color color)
+{
+	const sf::Vector2f top_right{position.x + size, position.y};
+	const sf::Vector2f bottom_left{position.x, position.y + size};
+	const sf::Vector2f bottom_right{position.x + size, position.y + size};
+	out[0] = {position, color};
+	out[1] = {top_right, color};
+	out[2] = {bottom_left, color};
+	out[3] = {bottom_left, color};
+	out[4] = {top_right, color};
+	out[5] = {bottom_right, color};
+	return out + 6;
+}
+
+void SwarmRenderer::update(const SwarmSnapshot& snapshot)
+{
+	m_vertices.resize(6 * (snapshot.agents.size() + snapshot.goals.size()));
+	if (m_vertices.getVertexCount() == 0)
+	{
+		return;
+	}
+	auto* out = &m_vertices[0];
+	for (auto position : snapshot.agents)
+	{
+		out = write_quad(out, position, k_agent_size, sf::Color::Green);
+	}
+	for (auto position : snapshot.goals)
+	{
+		out = write_quad(out, position, k_goal_size, sf::Color::Red);
+	}
+}
+
+std::size_t SwarmRenderer::get_vertex_count() const
+{
+	return m_vertices.getVertexCount();
+}
+
+void SwarmRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	target.draw(m_vertices, states);
+}
@@ -0,0 +1,503 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/Sweep.hpp>
+#include <swarm/Agent.hpp>
+#include <swarm/Philox.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <csignal>
+#include <deque>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// Not num_env_workers, a run's threads are sized from its cores, and not max_policy_lag, which is only 0 or 1
+static constexpr std::array<std::pair<std::string_view, long TrainingConfig::*>, 5> k_long_fields{{
+	{"num_steps", &TrainingConfig::num_steps},
+	{"num_envs", &TrainingConfig::num_envs},
+	{"total_timesteps", &TrainingConfig::total_timesteps},
+	{"num_minibatches", &TrainingConfig::num_minibatches},
+	{"update_epochs", &TrainingConfig::update_epochs},
+}};
+
+static constexpr std::array<std::pair<std::string_view, float TrainingConfig::*>, 7> k_float_fields{{
+	{"learning_rate", &TrainingConfig::learning_rate},
+	{"gamma", &TrainingConfig::gamma},
+	{"gae_lambda", &TrainingConfig::gae_lambda},
+	{"clip_coef", &TrainingConfig::clip_coef},
+	{"vf_coef", &TrainingConfig::vf_coef},
+	{"ent_coef", &TrainingConfig::ent_coef},
+	{"max_grad_norm", &TrainingConfig::max_grad_norm},
+}};
+
+void set_config_field(TrainingConfig& config, const std::string& name, double value)
+{
+	for (const auto& [field, member] : k_long_fields)
+	{
+		if (field == name)
+		{
+			config.*member = std::lround(value);
+			return;
+		}
+	}
+	for (const auto& [field, member] : k_float_fields)
+	{
+		if (field == name)
+		{
+			config.*member = static_cast<float>(value);
+			return;
+		}
+	}
+	throw std::invalid_argument(std::format("{} is not a sweepable TrainingConfig field", name));
+}
+
+std::vector<SweepTrial> make_sweep_trials(const SweepSpec& spec)
+{
+	// Fail on a typo before any run starts
+	TrainingConfig probe;
+	for (const auto& [name, values] : spec.grid)
+	{
+		if (values.empty())
+		{
+			throw std::invalid_argument(std::format("Grid field {} has no values", name));
+		}
+		set_config_field(probe, name, values.front());
+	}
+	for (const auto& range : spec.ranges)
+	{
+		if (range.min > range.max || (range.log_scale && range.min <= 0.0))
+		{
+			throw std::invalid_argument(
+				std::format("Range {} [{}, {}] is empty or not positive on a log scale", range.name, range.min,
+							range.max));
+		}
+		set_config_field(probe, range.name, range.min);
+	}
+
+	std::vector<SweepTrial> trials;
+	if (spec.num_samples == 0)
+	{
+		if (!spec.ranges.empty())
+		{
+			throw std::invalid_argument("Ranges need a random search, set num_samples");
+		}
+		// Odometer over the grid, the last field changes fastest
+		std::vector<std::size_t> index(spec.grid.size(), 0);
+		while (true)
+		{
+			SweepTrial trial;
+			for (std::size_t i = 0; i < spec.grid.size(); i++)
+			{
+				trial.emplace_back(spec.grid[i].first, spec.grid[i].second[index[i]]);
+			}
+			trials.push_back(std::move(trial));
+			std::size_t field = spec.grid.size();
+			while (field > 0 && ++index[field - 1] == spec.grid[field - 1].second.size())
+			{
+				index[--field] = 0;
+			}
+			if (field == 0)
+			{
+				return trials;
+			}
+		}
+	}
+
+	Philox rng{spec.seed};
+	for (std::size_t sample = 0; sample < spec.num_samples; sample++)
+	{
+		SweepTrial trial;
+		for (const auto& [name, values] : spec.grid)
+		{
+			const auto pick = static_cast<std::size_t>(rng.uniform(0.0f, 1.0f) * static_cast<float>(values.size()));
+			trial.emplace_back(name, values[std::min(pick, values.size() - 1)]);
+		}
+		for (const auto& range : spec.ranges)
+		{
+			const double u = rng.uniform(0.0f, 1.0f);
+			trial.emplace_back(range.name, range.log_scale
+											   ? std::exp(std::log(range.min)
+														  + u * (std::log(range.max) - std::log(range.min)))
+											   : range.min + u * (range.max - range.min));
+		}
+		trials.push_back(std::move(trial));
+	}
+	return trials;
+}
+
+MedianStoppingRule::MedianStoppingRule(std::size_t num_rungs, std::size_t min_peers)
+	: m_scores(num_rungs)
+	, m_min_peers(min_peers)
+{
+}
+
+bool MedianStoppingRule::report(std::size_t rung, double score)
+{
+	auto& peers = m_scores.at(rung);
+	bool  stop	= false;
+	if (!peers.empty() && peers.size() >= m_min_peers)
+	{
+		auto sorted = peers;
+		std::sort(sorted.begin(), sorted.end());
+		const std::size_t mid	 = sorted.size() / 2;
+		const double	  median = sorted.size() % 2 != 0 ? sorted[mid] : 0.5 * (sorted[mid - 1] + sorted[mid]);
+		stop					 = score < median;
+	}
+	peers.push_back(score);
+	return stop;
+}
+
+// Follows the CSV a run's MetricsWriter appends to, complete lines only
+class MetricsTail
+{
+	std::filesystem::path m_path;
+	std::streamoff		  m_offset = 0;
+	long				  m_global_step_column = -1;
+	long				  m_episodes_column	   = -1;
+	long				  m_return_column	   = -1;
+	long				  m_sps_column		   = -1;
+	long				  m_time_column		   = -1;
+	std::size_t			  m_window;
+	std::deque<double>	  m_returns;
+
+	static long column(const std::vector<std::string>& header, std::string_view name)
+	{
+		const auto it = std::find(header.begin(), header.end(), name);
+		return it == header.end() ? -1 : static_cast<long>(it - header.begin());
+	}
+
+	void parse(const std::string& line)
+	{
+		std::vector<std::string> cells;
+		std::stringstream		 stream(line);
+		for (std::string cell; std::getline(stream, cell, ',');)
+		{
+			cells.push_back(std::move(cell));
+		}
+		if (m_global_step_column < 0)
+		{
+			m_global_step_column = column(cells, "global_step");
+			m_episodes_column	 = column(cells, "episodes");
+			m_return_column		 = column(cells, "episode_return");
+			m_sps_column		 = column(cells, "sps");
+			m_time_column		 = column(cells, "time_s");
+			return;
+		}
+		const auto value = [&](long index) {
+			return index >= 0 && static_cast<std::size_t>(index) < cells.size() ? std::stod(cells[index]) : 0.0;
+		};
+		global_step = static_cast<long>(value(m_global_step_column));
+		sps			= value(m_sps_column);
+		time_s		= value(m_time_column);
+		if (value(m_episodes_column) > 0)
+		{
+			m_returns.push_back(value(m_return_column));
+			if (m_returns.size() > m_window)
+			{
+				m_returns.pop_front();
+			}
+		}
+	}
+
+ public:
+	long   global_step = 0;
+	double sps		   = 0.0;
+	double time_s	   = 0.0;
+
+	MetricsTail(std::filesystem::path path, std::size_t window)
+		: m_path(std::move(path))
+		, m_window(std::max<std::size_t>(window, 1))
+	{
+	}
+
+	void poll()
+	{
+		std::ifstream in(m_path, std::ios::binary);
+		if (!in || !in.seekg(m_offset))
+		{
+			return; // Not created yet
+		}
+		std::string line;
+		while (std::getline(in, line) && !in.eof())
+		{
+			m_offset += static_cast<std::streamoff>(line.size()) + 1;
+			parse(line);
+		}
+	}
+
+	double score() const
+	{
+		if (m_returns.empty())
+		{
+			return std::numeric_limits<double>::quiet_NaN();
+		}
+		double sum = 0.0;
+		for (const double r : m_returns)
+		{
+			sum += r;
+		}
+		return sum / static_cast<double>(m_returns.size());
+	}
+};
+
+static std::vector<int> allowed_cores()
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (::sched_getaffinity(0, sizeof(set), &set) != 0)
+	{
+		throw std::runtime_error("Could not read the CPU affinity of this process");
+	}
+	std::vector<int> cores;
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, &set))
+		{
+			cores.push_back(cpu);
+		}
+	}
+	return cores;
+}
+
+static std::string describe(const SweepTrial& trial)
+{
+	std::string text;
+	for (const auto& [name, value] : trial)
+	{
+		text += std::format("{}{}={}", text.empty() ? "" : " ", name, value);
+	}
+	return text;
+}
+
+// Body of the forked run, never returns
+[[noreturn]] static void run_trial(const TrainingConfig& base, const SweepTrial& trial, const EnvFactory& make_env,
+								   const std::vector<int>& cores, const std::filesystem::path& prefix)
+{
+	::prctl(PR_SET_PDEATHSIG, SIGKILL);
+	int status = 1;
+	try
+	{
+		const int log = ::open((prefix.string() + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (log < 0 || ::dup2(log, STDOUT_FILENO) < 0 || ::dup2(log, STDERR_FILENO) < 0)
+		{
+			throw std::runtime_error(std::format("Could not redirect the output to {}.log", prefix.string()));
+		}
+		::close(log);
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (const int core : cores)
+		{
+			CPU_SET(core, &set);
+		}
+		if (::sched_setaffinity(0, sizeof(set), &set) != 0)
+		{
+			throw std::runtime_error("Could not pin the run to its cores");
+		}
+
+		auto config = base;
+		for (const auto& [name, value] : trial)
+		{
+			set_config_field(config, name, value);
+		}
+		// The thread budget is the core set, env workers share it
+		config.intra_op_threads = static_cast<int>(cores.size());
+		config.inter_op_threads = 1;
+		config.metrics_path		= prefix.string() + ".csv";
+		config.checkpoint_path	= prefix.string() + ".pt";
+		if (!config.trace_path.empty())
+		{
+			config.trace_path = prefix.string() + ".trace.json";
+		}
+		if (!config.trajectory_path.empty())
+		{
+			config.trajectory_path = prefix.string() + ".traj";
+		}
+		std::cout << "Trial " << describe(trial) << " on " << cores.size() << " cores\n";
+		auto  env = make_env(config);
+		Agent agent{env.get()};
+		train(agent, std::move(env), config);
+		status = 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Trial failed: " << e.what() << '\n';
+	}
+	std::cout.flush();
+	std::cerr.flush();
+	::_exit(status);
+}
+
+static void write_results(const std::filesystem::path& path, const std::vector<SweepResult>& results)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		throw std::runtime_error(std::format("Could not open {} for writing", path.string()));
+	}
+	out << "trial";
+	if (!results.empty())
+	{
+		for (const auto& [name, _] : results.front().parameters)
+		{
+			out << ',' << name;
+		}
+	}
+	out << ",status,global_step,score,sps,time_s\n";
+	constexpr std::array k_status{"finished", "stopped", "failed"};
+	for (const auto& result : results)
+	{
+		out << result.trial;
+		for (const auto& [_, value] : result.parameters)
+		{
+			out << ',' << std::format("{}", value);
+		}
+		out << ',' << k_status[static_cast<std::size_t>(result.status)] << ',' << result.global_step << ','
+			<< std::format("{}", result.score) << ',' << std::format("{}", result.sps) << ','
+			<< std::format("{}", result.time_s) << '\n';
+	}
+}
+
+std::vector<SweepResult> run_sweep(const TrainingConfig& base, const SweepSpec& spec, const EnvFactory& make_env,
+								   const SweepOptions& options)
+{
+	const auto trials = make_sweep_trials(spec);
+	const auto cores  = options.cores.empty() ? allowed_cores() : options.cores;
+	const auto num_slots = options.cores_per_run > 0 ? cores.size() / options.cores_per_run : 0;
+	if (num_slots == 0)
+	{
+		throw std::invalid_argument(std::format("{} cores do not fit a run of {} cores", cores.size(),
+												options.cores_per_run));
+	}
+	std::filesystem::create_directories(options.out_dir);
+	std::cout << "Sweeping " << trials.size() << " trials, " << num_slots << " at a time on " << cores.size()
+			  << " cores\n";
+
+	struct Run
+	{
+		std::size_t trial;
+		std::size_t slot;
+		pid_t		pid;
+		long		total_timesteps;
+		MetricsTail metrics;
+		std::size_t next_rung = 0;
+		bool		stopped	  = false;
+	};
+	MedianStoppingRule		 rule(options.rungs.size(), options.min_peers);
+	std::vector<Run>		 running;
+	std::vector<std::size_t> free_slots;
+	for (std::size_t slot = num_slots; slot > 0; slot--)
+	{
+		free_slots.push_back(slot - 1);
+	}
+	std::vector<SweepResult> results(trials.size());
+	std::size_t				 next_trial = 0;
+
+	const auto kill_all = [&] {
+		for (const auto& run : running)
+		{
+			::kill(run.pid, SIGKILL);
+			::waitpid(run.pid, nullptr, 0);
+		}
+	};
+	try
+	{
+		while (next_trial < trials.size() || !running.empty())
+		{
+			while (next_trial < trials.size() && !free_slots.empty())
+			{
+				const auto slot = free_slots.back();
+				const auto prefix = options.out_dir / std::format("run_{}", next_trial);
+				const std::vector<int> run_cores(cores.begin() + static_cast<long>(slot * options.cores_per_run),
+												 cores.begin() + static_cast<long>((slot + 1) * options.cores_per_run));
+				auto config = base;
+				for (const auto& [name, value] : trials[next_trial])
+				{
+					set_config_field(config, name, value);
+				}
+				// Buffered output would be written once more by the child
+				std::cout.flush();
+				const pid_t pid = ::fork();
+				if (pid < 0)
+				{
+					throw std::runtime_error(std::format("Could not fork trial {}", next_trial));
+				}
+				if (pid == 0)
+				{
+					run_trial(base, trials[next_trial], make_env, run_cores, prefix);
+				}
+				free_slots.pop_back();
+				running.push_back({next_trial, slot, pid, config.total_timesteps,
+								   MetricsTail(prefix.string() + ".csv", options.score_window)});
+				std::cout << "Trial " << next_trial << ": " << describe(trials[next_trial]) << '\n';
+				next_trial++;
+			}
+
+			std::this_thread::sleep_for(options.poll_interval);
+			for (std::size_t i = 0; i < running.size();)
+			{
+				auto&	   run	  = running[i];
+				int		   status = 0;
+				const bool exited = ::waitpid(run.pid, &status, WNOHANG) == run.pid;
+				// Polled after the exit check, so a run that ended since the last poll still reports its last rungs
+				// to the rule before its slot is refilled
+				run.metrics.poll();
+				while (!run.stopped && run.next_rung < options.rungs.size()
+					   && static_cast<double>(run.metrics.global_step)
+							  >= options.rungs[run.next_rung] * static_cast<double>(run.total_timesteps))
+				{
+					// Without finished episodes there is nothing to compare, the run passes the rung
+					const double score = run.metrics.score();
+					if (!std::isnan(score) && rule.report(run.next_rung, score) && !exited)
+					{
+						::kill(run.pid, SIGKILL);
+						run.stopped = true;
+						std::cout << "Trial " << run.trial << " stopped at " << run.metrics.global_step
+								  << " steps, score " << score << '\n';
+					}
+					run.next_rung++;
+				}
+				if (!exited)
+				{
+					i++;
+					continue;
+				}
+				auto& result	   = results[run.trial];
+				result.trial	   = run.trial;
+				result.parameters  = trials[run.trial];
+				result.status	   = run.stopped ? SweepStatus::Stopped
+								   : WIFEXITED(status) && WEXITSTATUS(status) == 0 ? SweepStatus::Finished
+																				   : SweepStatus::Failed;
+				result.global_step = run.metrics.global_step;
+				result.score	   = run.metrics.score();
+				result.sps		   = run.metrics.sps;
+				result.time_s	   = run.metrics.time_s;
+				if (result.status == SweepStatus::Failed)
+				{
+					std::cout << "Trial " << run.trial << " failed, see run_" << run.trial << ".log\n";
+				}
+				free_slots.push_back(run.slot);
+				running.erase(running.begin() + static_cast<long>(i));
+			}
+		}
+	}
+	catch (...)
+	{
+		kill_all();
+		throw;
+	}
+
+	write_results(options.out_dir / "results.csv", results);
+	return results;
+}
@@ -7,6 +7,10 @@ TensorFactory& TensorFactory::instance()
 	static TensorFactory instance;
 	return instance;
 }
+torch::Device TensorFactory::device() const
+{
+	return m_device;
+}
 torch::nn::Linear TensorFactory::create_linear(std::size_t in, std::size_t out, float std) const
 {
 	torch::nn::Linear linear{in, out};
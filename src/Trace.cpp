@@ -0,0 +1,191 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/Trace.hpp>
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+// Keeps a runaway trace from eating the host's memory, later events of the thread are counted and dropped
+static constexpr std::size_t k_max_events_per_thread = 1 << 21;
+
+struct TraceEvent
+{
+	const char*	 name;
+	std::int64_t start_ns;
+	std::int64_t end_ns;
+};
+
+struct ThreadTraceBuffer
+{
+	// Only contended while a summary or export reads the buffer
+	std::mutex				mutex;
+	std::vector<TraceEvent> events;
+	std::size_t				dropped = 0;
+	std::uint32_t			tid		= 0;
+	std::string				name;
+};
+
+struct TraceRegistry
+{
+	std::mutex										mutex;
+	std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers; // Outlive their threads so the export sees them
+	std::int64_t									origin_ns = 0;
+};
+
+static TraceRegistry& registry()
+{
+	static TraceRegistry instance;
+	return instance;
+}
+
+static ThreadTraceBuffer& local_buffer()
+{
+	thread_local const auto buffer = [] {
+		auto  created = std::make_shared<ThreadTraceBuffer>();
+		auto& reg	  = registry();
+		std::lock_guard lock(reg.mutex);
+		created->tid = static_cast<std::uint32_t>(reg.buffers.size() + 1);
+		created->events.reserve(4096);
+		reg.buffers.push_back(created);
+		return created;
+	}();
+	return *buffer;
+}
+
+static void write_json_string(std::ostream& out, std::string_view text)
+{
+	out << '"';
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out << '\\';
+		}
+		out << c;
+	}
+	out << '"';
+}
+
+void record_trace_event(const char* name, std::int64_t start_ns, std::int64_t end_ns)
+{
+	auto&			buffer = local_buffer();
+	std::lock_guard lock(buffer.mutex);
+	if (buffer.events.size() >= k_max_events_per_thread)
+	{
+		buffer.dropped++;
+		return;
+	}
+	buffer.events.push_back({name, start_ns, end_ns});
+}
+
+void start_tracing()
+{
+	auto& reg = registry();
+	{
+		std::lock_guard lock(reg.mutex);
+		for (auto& buffer : reg.buffers)
+		{
+			std::lock_guard buffer_lock(buffer->mutex);
+			buffer->events.clear();
+			buffer->dropped = 0;
+		}
+		reg.origin_ns = trace_now_ns();
+	}
+	g_tracing_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop_tracing()
+{
+	g_tracing_enabled.store(false, std::memory_order_relaxed);
+}
+
+void set_trace_thread_name(std::string name)
+{
+	auto&			buffer = local_buffer();
+	std::lock_guard lock(buffer.mutex);
+	buffer.name = std::move(name);
+}
+
+std::vector<TracePhase> trace_summary(std::int64_t since_ns)
+{
+	std::unordered_map<std::string_view, TracePhase> phases;
+	auto&											 reg = registry();
+	std::lock_guard									 lock(reg.mutex);
+	for (auto& buffer : reg.buffers)
+	{
+		std::lock_guard buffer_lock(buffer->mutex);
+		for (const auto& event : buffer->events)
+		{
+			if (event.start_ns < since_ns)
+			{
+				continue;
+			}
+			auto [it, inserted] = phases.try_emplace(event.name, TracePhase{event.name, 0, 0});
+			it->second.total_ns += event.end_ns - event.start_ns;
+			it->second.count++;
+		}
+	}
+
+	std::vector<TracePhase> result;
+	result.reserve(phases.size());
+	for (auto& [_, phase] : phases)
+	{
+		result.push_back(std::move(phase));
+	}
+	std::ranges::sort(result, [](const TracePhase& a, const TracePhase& b) { return a.total_ns > b.total_ns; });
+	return result;
+}
+
+void write_chrome_trace(const std::filesystem::path& path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		throw std::runtime_error(std::format("Could not open {} for writing", path.string()));
+	}
+
+	auto&			reg = registry();
+	std::lock_guard lock(reg.mutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	auto next  = [&]() -> std::ostream& {
+		 out << (first ? "\n" : ",\n");
+		 first = false;
+		 return out;
+	};
+	for (auto& buffer : reg.buffers)
+	{
+		std::lock_guard buffer_lock(buffer->mutex);
+		if (!buffer->name.empty())
+		{
+			next() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+				   << ",\"args\":{\"name\":";
+			write_json_string(out, buffer->name);
+			out << "}}";
+		}
+		if (buffer->dropped > 0)
+		{
+			next() << "{\"ph\":\"i\",\"name\":\"dropped " << buffer->dropped
+				   << " events\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":0}";
+		}
+		for (const auto& event : buffer->events)
+		{
+			// Chrome expects microseconds
+			next() << "{\"ph\":\"X\",\"name\":";
+			write_json_string(out, event.name);
+			out << std::format(",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", buffer->tid,
+							   static_cast<double>(event.start_ns - reg.origin_ns) / 1e3,
+							   static_cast<double>(event.end_ns - event.start_ns) / 1e3);
+		}
+	}
+	out << "\n]}\n";
+	if (!out)
+	{
+		throw std::runtime_error(std::format("Failed writing trace {}", path.string()));
+	}
+}
@@ -2,166 +2,1646 @@
 // Created by chris on 11/12/25.
 //
 #include <swarm/Training.hpp>
+#include <ATen/autocast_mode.h>
+#include <swarm/Checkpoint.hpp>
+#include <swarm/Gae.hpp>
+#include <swarm/Metrics.hpp>
+#include <swarm/MinibatchIterator.hpp>
+#include <swarm/ParallelMultiEnv.hpp>
+#include <swarm/PpoLoss.hpp>
+#include <swarm/RolloutStorage.hpp>
+#include <swarm/SharedMemory.hpp>
+#include <swarm/StackedAgent.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/Trace.hpp>
+#include <swarm/Trajectory.hpp>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
 
-void train(Agent& agent, std::unique_ptr<Environment> env, const TrainingConfig& config)
+// One rollout of num_steps x num_envs transitions
+struct Rollout
 {
-    MultiEnv envs(std::move(env), config.num_envs);
-	auto device = torch::kCUDA;
-	agent.to(device);
-    torch::optim::Adam optimizer{agent.parameters(), torch::optim::AdamOptions(config.learning_rate).eps(1e-5)};
+    RolloutStorage storage;
+    // State after the last step, needed to bootstrap GAE
+    torch::Tensor next_done;
+    torch::Tensor next_value;
+    // Number of updates the collecting policy had seen
+    long policy_version = 0;
+    EpisodeStats episodes;
+};
+
+// Records every collected step, plus the agent and goal positions when the envs can draw one of each per env
+class TrajectoryTap
+{
+    TrajectoryRecorder m_recorder;
+    SwarmSnapshot m_snapshot;
+    std::vector<float> m_positions;
+
+    static bool drawable(const Environment& envs)
+    {
+        SwarmSnapshot probe;
+        envs.write_snapshot(probe);
+        return probe.agents.size() == envs.get_num_envs()
+            && (probe.goals.size() == 1 || probe.goals.size() == envs.get_num_envs());
+    }
+
+public:
+    TrajectoryTap(const std::filesystem::path& path, const Environment& envs)
+        : m_recorder(path, envs.get_num_envs(), envs.get_observation_size(), drawable(envs))
+        , m_positions(m_recorder.has_positions() ? 4 * envs.get_num_envs() : 0)
+    {
+    }
+
+    // Before the step, so the positions belong to the observation the action was taken on
+    void capture_positions(const Environment& envs)
+    {
+        if (!m_recorder.has_positions())
+        {
+            return;
+        }
+        m_snapshot.clear();
+        envs.write_snapshot(m_snapshot);
+        for (std::size_t i = 0; i < m_snapshot.agents.size(); i++)
+        {
+            // A shared world has a single goal for everyone
+            const auto goal = m_snapshot.goals[m_snapshot.goals.size() == 1 ? 0 : i];
+            m_positions[4 * i] = m_snapshot.agents[i].x;
+            m_positions[4 * i + 1] = m_snapshot.agents[i].y;
+            m_positions[4 * i + 2] = goal.x;
+            m_positions[4 * i + 3] = goal.y;
+        }
+    }
+
+    void record(const torch::Tensor& obs, const torch::Tensor& action, const torch::Tensor& logprob,
+                const torch::Tensor& value, const Environment::StepResult& res)
+    {
+        const auto host = [](const torch::Tensor& tensor, torch::ScalarType dtype) {
+            return tensor.to(torch::kCPU, dtype).contiguous();
+        };
+        const auto host_obs = host(obs, torch::kFloat32);
+        const auto host_action = host(action, torch::kLong);
+        const auto host_logprob = host(logprob, torch::kFloat32);
+        const auto host_value = host(value, torch::kFloat32);
+        const auto host_reward = host(res.reward, torch::kFloat32);
+        const auto host_done = host(res.done, torch::kFloat32);
+        m_recorder.record({host_obs.data_ptr<float>(), host_action.data_ptr<std::int64_t>(),
+                           host_logprob.data_ptr<float>(), host_value.data_ptr<float>(),
+                           host_reward.data_ptr<float>(), host_done.data_ptr<float>(),
+                           m_positions.empty() ? nullptr : m_positions.data()});
+    }
+
+    TrajectoryRecorder& recorder()
+    {
+        return m_recorder;
+    }
+};
+
+// Env state carried over from one rollout to the next, and the random streams of the run besides the envs'
+struct RolloutState
+{
+    torch::Tensor next_obs;
+    torch::Tensor next_done;
+    // Two float32 host buffers each that envs step into when the rollout cannot take the results in place,
+    // alternating so next_obs and next_done survive the following step
+    torch::Tensor step_obs; // [2, num_envs, obs_size]
+    torch::Tensor step_reward; // [2, num_envs]
+    torch::Tensor step_done; // [2, num_envs]
+    long parity = 0;
+    Philox sampler{0, k_sampling_stream}; // Action sampling, owned by the actor
+    Philox shuffler{0, k_shuffle_stream}; // Minibatch permutations, owned by the learner
+    TrajectoryTap* trajectory = nullptr; // Optional, fed by the actor
+};
+
+// Runs the forward passes of the current thread in bf16 autocast while alive, no-op when disabled
+class AutocastGuard
+{
+    bool m_enabled;
+    torch::DeviceType m_device;
+    bool m_prev_enabled = false;
+    at::ScalarType m_prev_dtype = at::kFloat;
+
+public:
+    AutocastGuard(bool enabled, torch::Device device)
+        : m_enabled(enabled)
+        , m_device(device.type())
+    {
+        if (!m_enabled)
+        {
+            return;
+        }
+        m_prev_enabled = at::autocast::is_autocast_enabled(m_device);
+        m_prev_dtype = at::autocast::get_autocast_dtype(m_device);
+        at::autocast::set_autocast_enabled(m_device, true);
+        at::autocast::set_autocast_dtype(m_device, at::kBFloat16);
+        at::autocast::increment_nesting();
+    }
+    ~AutocastGuard()
+    {
+        if (!m_enabled)
+        {
+            return;
+        }
+        if (at::autocast::decrement_nesting() == 0)
+        {
+            at::autocast::clear_cache();
+        }
+        at::autocast::set_autocast_enabled(m_device, m_prev_enabled);
+        at::autocast::set_autocast_dtype(m_device, m_prev_dtype);
+    }
+    AutocastGuard(const AutocastGuard&) = delete;
+    AutocastGuard& operator=(const AutocastGuard&) = delete;
+};
+
+static std::unique_ptr<Environment> make_envs(std::unique_ptr<Environment> env, const TrainingConfig& config)
+{
+    // Vectorized envs already step a whole batch, everything else gets cloned into a MultiEnv
+    if (env->get_num_envs() > 1)
+    {
+        if (static_cast<long>(env->get_num_envs()) != config.num_envs)
+        {
+            throw std::invalid_argument(std::format("Environment steps {} envs but config.num_envs={}",
+                                                    env->get_num_envs(), config.num_envs));
+        }
+        return env;
+    }
+    if (config.num_env_workers > 1)
+    {
+        return std::make_unique<ParallelMultiEnv>(std::move(env), config.num_envs, config.num_env_workers);
+    }
+    return std::make_unique<MultiEnv>(std::move(env), config.num_envs);
+}
+
+static Rollout make_rollout(const TrainingConfig& config, const Environment& envs, torch::Device device)
+{
+    return {RolloutStorage(config.num_steps, config.num_envs, static_cast<long>(envs.get_observation_size()),
+                           envs.get_action_space_size(), config.obs_dtype, config.value_dtype, device)};
+}
+
+static void copy_parameters(Agent& target, Agent& source)
+{
+    torch::NoGradGuard nograd;
+    auto target_params = target.parameters();
+    auto source_params = source.parameters();
+    for (std::size_t i = 0; i < target_params.size(); i++)
+    {
+        target_params[i].copy_(source_params[i]);
+    }
+}
+
+// Samples actions for a whole env batch with the fused CPU kernel instead of libtorch
+static void act_fused(FusedActorCritic& fused, const torch::Tensor& observations, torch::Tensor& action,
+                      torch::Tensor& logprob, torch::Tensor& value, torch::Device device)
+{
+    SWARM_TRACE_SCOPE("policy_inference");
+    auto obs = observations.to(torch::kCPU, torch::kFloat32).contiguous();
+    const long batch = obs.size(0);
+    action = torch::empty({batch}, torch::kLong);
+    logprob = torch::empty({batch}, torch::kFloat32);
+    value = torch::empty({batch}, torch::kFloat32);
+    fused.act(obs.data_ptr<float>(), static_cast<std::size_t>(batch), action.data_ptr<int64_t>(),
+              logprob.data_ptr<float>(), value.data_ptr<float>());
+    action = action.to(device);
+    logprob = logprob.to(device);
+    value = value.to(device);
+}
 
-    // Storage setup
-    const long obs_size = static_cast<long>(envs.get_observation_size());
+static void collect_rollout(Agent& agent, FusedActorCritic* fused, Environment& envs, RolloutState& state,
+                            Rollout& rollout, const TrainingConfig& config, torch::Device device)
+{
+    SWARM_TRACE_SCOPE("collect_rollout");
+    auto& storage = rollout.storage;
+    const long num_envs = storage.num_envs();
+    const long obs_size = storage.obs_size();
+    // Envs step straight into the rollout's rows when it keeps observations and rewards as float32 on the host.
+    // Dones are stored as bits, so they always go through the alternating buffers.
+    const bool in_place = !storage.observation_row(0).empty() && !storage.reward_row(0).empty();
+    if (!state.step_obs.defined())
+    {
+        state.step_obs = torch::empty({2, num_envs, obs_size}, torch::kFloat32);
+        state.step_reward = torch::empty({2, num_envs}, torch::kFloat32);
+        state.step_done = torch::empty({2, num_envs}, torch::kFloat32);
+    }
+    const auto half = [](torch::Tensor& buffers, long parity) {
+        const auto size = static_cast<std::size_t>(buffers.numel() / 2);
+        return std::span<float>(buffers.data_ptr<float>() + static_cast<std::size_t>(parity) * size, size);
+    };
+    for (long step = 0; step < config.num_steps; step++)
+    {
+        torch::Tensor action;
+        torch::Tensor logprob;
+        torch::Tensor value;
+        if (fused != nullptr)
+        {
+            act_fused(*fused, state.next_obs, action, logprob, value, device);
+        }
+        else
+        {
+            SWARM_TRACE_SCOPE("policy_inference");
+            torch::NoGradGuard nograd;
+            AutocastGuard autocast(config.bf16_autocast, device);
+            auto uniform = torch::empty({state.next_obs.size(0)}, torch::kFloat32);
+            state.sampler.fill_uniform(uniform.data_ptr<float>(), uniform.numel(), 0.0f, 1.0f);
+            auto res = agent.sample_action_and_value(state.next_obs, uniform.to(device));
+            value = res.value.flatten();
+            action = res.action;
+            logprob = res.log_prob;
+        }
+        torch::Tensor host_action;
+        {
+            SWARM_TRACE_SCOPE("device_to_host");
+            host_action = action.to(torch::kCPU, torch::kLong).contiguous();
+        }
+        if (state.trajectory != nullptr)
+        {
+            state.trajectory->capture_positions(envs);
+        }
+        state.parity ^= 1;
+        const auto obs_out = in_place && step + 1 < config.num_steps ? storage.observation_row(step + 1)
+                                                                     : half(state.step_obs, state.parity);
+        const auto reward_out = in_place ? storage.reward_row(step) : half(state.step_reward, state.parity);
+        const auto done_out = half(state.step_done, state.parity);
+        {
+            SWARM_TRACE_SCOPE("env_step");
+            envs.step_into({{host_action.data_ptr<std::int64_t>(), static_cast<std::size_t>(num_envs)}, obs_out,
+                            reward_out, done_out});
+        }
+        // Views of what the env wrote, nothing is copied
+        const auto next_obs = torch::from_blob(obs_out.data(), {num_envs, obs_size}, torch::kFloat32);
+        const auto reward = torch::from_blob(reward_out.data(), {num_envs}, torch::kFloat32);
+        const auto done = torch::from_blob(done_out.data(), {num_envs}, torch::kFloat32);
+        if (state.trajectory != nullptr)
+        {
+            SWARM_TRACE_SCOPE("record_trajectory");
+            state.trajectory->record(state.next_obs, host_action, logprob, value, {next_obs, reward, done});
+        }
+        SWARM_TRACE_SCOPE("store_and_host_to_device");
+        // In place the env already wrote this step's reward and, except for the first step, its observation
+        storage.store(step, in_place && step > 0 ? torch::Tensor{} : state.next_obs, action, logprob,
+                      in_place ? torch::Tensor{} : reward.to(device), state.next_done, value);
+        state.next_obs = next_obs.to(device);
+        state.next_done = done.to(device);
+    }
+
+    // Bootstrap value for GAE, taken with the same policy that collected the rollout
+    {
+        SWARM_TRACE_SCOPE("policy_inference");
+        torch::NoGradGuard nograd;
+        rollout.next_value = agent.get_value(state.next_obs).reshape({1, -1});
+    }
+    // On the host next_done is a view of a step buffer, which the next rollout overwrites while this one is trained on
+    rollout.next_done = state.next_done.clone();
+    rollout.episodes = envs.take_episode_stats();
+}
+
+// clip_grad_norm_ reads the total norm back to the host, this keeps it on the device
+static torch::Tensor clip_grad_norm(const std::vector<torch::Tensor>& parameters, double max_norm)
+{
+    torch::NoGradGuard nograd;
+    std::vector<torch::Tensor> norms;
+    for (const auto& p : parameters)
+    {
+        if (p.grad().defined())
+        {
+            norms.push_back(p.grad().norm(2));
+        }
+    }
+    auto total_norm = torch::stack(norms).norm(2);
+    auto scale = (max_norm / (total_norm + 1e-6)).clamp_max(1.0);
+    for (const auto& p : parameters)
+    {
+        if (p.grad().defined())
+        {
+            p.grad().mul_(scale);
+        }
+    }
+    return total_norm;
+}
+
+// Returns the means of [pg_loss, v_loss, entropy, approx_kl, clipfrac, grad_norm] over all minibatches as a
+// tensor on the device when collect_stats is set, so reading them is up to the caller
+static torch::Tensor ppo_update(Agent& agent, torch::optim::Adam& optimizer, const Rollout& rollout,
+                                const TrainingConfig& config, torch::Device device, Philox& shuffler,
+                                bool collect_stats)
+{
+    SWARM_TRACE_SCOPE("ppo_update");
+    const auto& storage = rollout.storage;
     const long batch_size = config.num_steps * config.num_envs;
     const long minibatch_size = batch_size / config.num_minibatches;
 
-    // Storage tensors
-    auto obs = torch::zeros({config.num_steps, config.num_envs, obs_size}).to(device);
-    auto actions = torch::zeros({config.num_steps, config.num_envs}, torch::kLong).to(device);
-    auto logprobs = torch::zeros({config.num_steps, config.num_envs}).to(device);
-    auto rewards = torch::zeros({config.num_steps, config.num_envs}).to(device);
-    auto dones = torch::zeros({config.num_steps, config.num_envs}).to(device);
-    auto values = torch::zeros({config.num_steps, config.num_envs}).to(device);
+    // Calculate GAE
+    auto values = storage.values();
+    GaeResult gae;
+    {
+        SWARM_TRACE_SCOPE("gae");
+        gae = compute_gae(storage.rewards(), values, storage.dones(), rollout.next_value, rollout.next_done,
+                          config.gamma, config.gae_lambda);
+    }
+    auto& [advantages, returns] = gae;
 
-    auto next_obs = envs.reset().to(device);
-    auto next_done = torch::zeros(config.num_envs).to(device);
+    // Lay the GAE fields and the stored rows out once per epoch as contiguous shuffled minibatches
+    SWARM_TRACE_SCOPE("minibatch_layout");
+    MinibatchIterator batches(
+        storage,
+        torch::arange(batch_size, torch::TensorOptions().dtype(torch::kLong).device(values.device())),
+        advantages.reshape({batch_size}),
+        returns.reshape({batch_size}),
+        values.reshape({batch_size}),
+        minibatch_size,
+        config.update_epochs,
+        shuffler
+    );
 
-    long num_updates = config.total_timesteps / batch_size;
+    torch::Tensor stats_sum;
+    long num_steps = 0;
 
-    for (long update = 0; update < num_updates; update++)
+    // PPO update
+    while (true)
     {
-        // Collect rollout
-        for (long step = 0; step < config.num_steps; step++)
         {
-            obs[step] = next_obs;
-            dones[step] = next_done;
+            SWARM_TRACE_SCOPE("minibatch_shuffle_wait");
+            if (!batches.next_epoch())
+            {
+                break;
+            }
+        }
+        for (long i = 0; i < batches.num_minibatches(); i++)
+        {
+            const auto mb = batches.minibatch(i);
 
-            torch::Tensor action;
-            torch::Tensor logprob;
-            torch::Tensor value;
+            Agent::ActionDetails res;
             {
-                torch::NoGradGuard nograd;
-                auto res = agent.get_action_and_value(next_obs);
-                value = res.value.flatten();
-                action = res.action;
-                logprob = res.log_prob;
+                SWARM_TRACE_SCOPE("forward");
+                // Only the forward pass runs in autocast, backward follows the dtypes it recorded
+                AutocastGuard autocast(config.bf16_autocast, device);
+                res = agent.get_action_and_value(mb.observations, mb.actions);
             }
-            values[step] = value;
-            actions[step] = action;
-            logprobs[step] = logprob;
+            auto newlogprob = res.log_prob.to(torch::kFloat32);
+            auto entropy = res.entropy.to(torch::kFloat32);
+            auto newvalue = res.value.to(torch::kFloat32);
 
-            auto res = envs.step(action.cpu());
-            rewards[step] = res.reward.to(device).view(-1);
-            next_obs = res.observations.to(device);
-            next_done = res.done.to(device).view(-1);
+            const PpoLossInputs inputs{
+                newlogprob,
+                entropy,
+                newvalue,
+                mb.logprobs,
+                mb.advantages,
+                mb.returns,
+                mb.values,
+            };
+            PpoLossResult loss;
+            {
+                SWARM_TRACE_SCOPE("loss");
+                loss = config.fused_ppo_loss
+                           ? fused_ppo_loss(inputs, config.clip_coef, config.vf_coef, config.ent_coef)
+                           : ppo_loss(inputs, config.clip_coef, config.vf_coef, config.ent_coef);
+            }
+
+            optimizer.zero_grad();
+            {
+                SWARM_TRACE_SCOPE("backward");
+                loss.loss.backward();
+            }
+            SWARM_TRACE_SCOPE("optimizer_step");
+            auto grad_norm = clip_grad_norm(agent.parameters(), config.max_grad_norm);
+            optimizer.step();
+
+            if (collect_stats)
+            {
+                auto stats = torch::stack({loss.pg_loss, loss.v_loss, loss.entropy_loss, loss.approx_kl,
+                                           loss.clipfrac, grad_norm}).detach().to(device, torch::kFloat32);
+                stats_sum = stats_sum.defined() ? stats_sum + stats : stats;
+            }
+            num_steps++;
+        }
+    }
+    return collect_stats ? stats_sum / static_cast<double>(std::max(num_steps, 1L)) : torch::Tensor();
+}
+
+static double steps_per_second(std::chrono::steady_clock::time_point start, long steps)
+{
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(steps) / std::max(elapsed.count(), 1e-9);
+}
+
+// Time per traced phase since window_start_ns, summed over all threads, so nested and concurrent phases overlap
+static void print_phase_breakdown(std::int64_t window_start_ns, long updates)
+{
+    const double window_ns = static_cast<double>(trace_now_ns() - window_start_ns);
+    for (const auto& phase : trace_summary(window_start_ns))
+    {
+        std::cout << std::format("    {:<26} {:9.2f} ms/update {:6.1f}%  ({} calls)\n", phase.name,
+                                 static_cast<double>(phase.total_ns) / 1e6 / static_cast<double>(std::max(updates, 1L)),
+                                 100.0 * static_cast<double>(phase.total_ns) / window_ns, phase.count);
+    }
+}
+
+static void log_update(long update, long num_updates, long first_update, const Rollout& rollout, long policy_lag,
+                       std::chrono::steady_clock::time_point start, std::int64_t& trace_window_start)
+{
+    SWARM_TRACE_SCOPE("log_update");
+    if (update % 10 == 0) {
+        // The only host sync of the log, once every 10 updates
+        auto mean_reward = rollout.storage.rewards().mean().item<float>();
+        const long steps = (update + 1 - first_update) * rollout.storage.num_steps() * rollout.storage.num_envs();
+        std::cout << "Update " << update
+                  << " / " << num_updates
+                  << "  mean reward: " << mean_reward
+                  << "  policy lag: " << policy_lag
+                  << "  SPS: " << static_cast<long>(steps_per_second(start, steps)) << '\n';
+        if (tracing_enabled())
+        {
+            print_phase_breakdown(trace_window_start, update == first_update ? 1 : 10);
+            trace_window_start = trace_now_ns();
+        }
+    }
+}
+
+// Hands one MetricsRecord per update to the background writer. The device-side values of an update are read when
+// the next one is recorded, by then they are long computed and reading them does not stall the device.
+class MetricsRecorder
+{
+    std::optional<MetricsWriter> m_writer;
+    std::chrono::steady_clock::time_point m_start;
+    long m_first_update;
+    MetricsRecord m_pending{};
+    torch::Tensor m_pending_values; // [mean_reward, pg_loss, v_loss, entropy, approx_kl, clipfrac, grad_norm]
+
+public:
+    MetricsRecorder(const TrainingConfig& config, std::chrono::steady_clock::time_point start, long first_update)
+        : m_start(start)
+        , m_first_update(first_update)
+    {
+        if (!config.metrics_path.empty())
+        {
+            m_writer.emplace(config.metrics_path);
+        }
+    }
+
+    bool enabled() const
+    {
+        return m_writer.has_value();
+    }
+
+    void record(long update, const Rollout& rollout, long policy_lag, const torch::Tensor& update_stats)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        SWARM_TRACE_SCOPE("metrics");
+        flush();
+        const long batch = rollout.storage.num_steps() * rollout.storage.num_envs();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_pending = {};
+        m_pending.update = update;
+        m_pending.global_step = (update + 1) * batch;
+        m_pending.time_s = elapsed.count();
+        m_pending.sps = steps_per_second(m_start, (update + 1 - m_first_update) * batch);
+        m_pending.policy_lag = policy_lag;
+        m_pending.episodes = rollout.episodes.episodes;
+        m_pending.episode_return = rollout.episodes.mean_return();
+        m_pending.episode_length = rollout.episodes.mean_length();
+        m_pending_values = torch::cat({rollout.storage.rewards().mean().view(1), update_stats});
+    }
+
+    // Pushes the record still waiting for its device values
+    void flush()
+    {
+        if (!m_pending_values.defined())
+        {
+            return;
+        }
+        auto values = std::exchange(m_pending_values, {}).to(torch::kCPU, torch::kDouble).contiguous();
+        const double* v = values.data_ptr<double>();
+        m_pending.mean_reward = v[0];
+        m_pending.pg_loss = v[1];
+        m_pending.v_loss = v[2];
+        m_pending.entropy = v[3];
+        m_pending.approx_kl = v[4];
+        m_pending.clipfrac = v[5];
+        m_pending.grad_norm = v[6];
+        m_writer->push(m_pending);
+    }
+
+    std::size_t dropped() const
+    {
+        return enabled() ? m_writer->dropped() : 0;
+    }
+};
+
+static constexpr std::int64_t k_checkpoint_version = 2;
+
+// Where a resumed run continues, restored from its checkpoint
+struct ResumePoint
+{
+    long first_update = 0;
+};
+
+static torch::Tensor generator_state(torch::Device device)
+{
+    auto generator = at::globalContext().defaultGenerator(device);
+    std::lock_guard lock(generator.mutex());
+    return generator.get_state();
+}
+
+static void set_generator_state(torch::Device device, const torch::Tensor& state)
+{
+    auto generator = at::globalContext().defaultGenerator(device);
+    std::lock_guard lock(generator.mutex());
+    generator.set_state(state);
+}
+
+// Deep copy of the Adam moments, keyed to the parameters of target. Agent has a single parameter group.
+static std::shared_ptr<torch::optim::Adam> snapshot_optimizer(const torch::optim::Adam& optimizer, Agent& target)
+{
+    const auto& options = static_cast<const torch::optim::AdamOptions&>(optimizer.defaults());
+    auto target_params = target.parameters();
+    auto copy = std::make_shared<torch::optim::Adam>(target_params, options);
+    const auto& source_params = optimizer.param_groups()[0].params();
+    for (std::size_t i = 0; i < source_params.size(); i++)
+    {
+        const auto it = optimizer.state().find(source_params[i].unsafeGetTensorImpl());
+        if (it == optimizer.state().end())
+        {
+            continue; // No step taken yet
+        }
+        const auto& source = static_cast<const torch::optim::AdamParamState&>(*it->second);
+        auto state = std::make_unique<torch::optim::AdamParamState>();
+        state->step(source.step());
+        state->exp_avg(source.exp_avg().to(torch::kCPU, false, true));
+        state->exp_avg_sq(source.exp_avg_sq().to(torch::kCPU, false, true));
+        if (source.max_exp_avg_sq().defined())
+        {
+            state->max_exp_avg_sq(source.max_exp_avg_sq().to(torch::kCPU, false, true));
+        }
+        copy->state()[target_params[i].unsafeGetTensorImpl()] = std::move(state);
+    }
+    return copy;
+}
+
+// Copies everything an exact resume needs on the training thread, the CheckpointWriter serializes it in the
+// background. Pipelined runs pass with_env_state=false, their actor keeps stepping the envs while the learner saves.
+static CheckpointWriter::Job snapshot_checkpoint(Agent& agent, const torch::optim::Adam& optimizer,
+                                                 const Environment& envs, const RolloutState& state,
+                                                 const FusedActorCritic* fused, long next_update, bool with_env_state,
+                                                 torch::Device device)
+{
+    SWARM_TRACE_SCOPE("checkpoint_snapshot");
+    torch::NoGradGuard nograd;
+    auto agent_copy = std::make_shared<Agent>(&envs);
+    agent_copy->to(torch::kCPU);
+    copy_parameters(*agent_copy, agent);
+    auto optimizer_copy = snapshot_optimizer(optimizer, *agent_copy);
+
+    auto training = std::make_shared<torch::serialize::OutputArchive>();
+    training->write("version", c10::IValue(k_checkpoint_version));
+    training->write("next_update", c10::IValue(static_cast<std::int64_t>(next_update)));
+    training->write("cpu_rng", generator_state(torch::kCPU));
+    if (device.is_cuda())
+    {
+        training->write("device_rng", generator_state(device));
+    }
+    torch::serialize::OutputArchive env_archive;
+    const bool has_env_state = with_env_state && envs.save_state(env_archive);
+    training->write("has_env_state", c10::IValue(has_env_state));
+    if (has_env_state)
+    {
+        training->write("envs", env_archive);
+        training->write("next_obs", state.next_obs.to(torch::kCPU, false, true));
+        training->write("next_done", state.next_done.to(torch::kCPU, false, true));
+    }
+    write_rng(*training, "shuffle_rng", state.shuffler);
+    if (has_env_state)
+    {
+        // The fused kernel samples from its own copy of the stream, it was seeded from state.sampler
+        Philox sampler;
+        sampler.set_state(fused != nullptr ? fused->get_rng_state() : state.sampler.get_state());
+        write_rng(*training, "sampling_rng", sampler);
+    }
+
+    return [agent_copy, optimizer_copy, training](torch::serialize::OutputArchive& archive) {
+        torch::serialize::OutputArchive agent_archive;
+        agent_copy->save(agent_archive);
+        archive.write("agent", agent_archive);
+        torch::serialize::OutputArchive optimizer_archive;
+        optimizer_copy->save(optimizer_archive);
+        archive.write("optimizer", optimizer_archive);
+        archive.write("training", *training);
+    };
+}
+
+static ResumePoint load_checkpoint(const std::filesystem::path& path, Agent& agent, torch::optim::Adam& optimizer,
+                                   Environment& envs, RolloutState& state, torch::Device device)
+{
+    torch::serialize::InputArchive archive;
+    archive.load_from(path.string());
+    torch::serialize::InputArchive training;
+    archive.read("training", training);
+    c10::IValue version;
+    training.read("version", version);
+    if (version.toInt() != k_checkpoint_version)
+    {
+        throw std::runtime_error(std::format("Checkpoint {} has version {}, expected {}", path.string(),
+                                             version.toInt(), k_checkpoint_version));
+    }
+
+    torch::serialize::InputArchive agent_archive;
+    archive.read("agent", agent_archive);
+    agent.load(agent_archive);
+    // Loading replaces the parameter data with the saved CPU tensors, the optimizer still holds the same parameters
+    agent.to(device);
+
+    torch::serialize::InputArchive optimizer_archive;
+    archive.read("optimizer", optimizer_archive);
+    optimizer.load(optimizer_archive);
+    for (auto& [_, param_state] : optimizer.state())
+    {
+        auto& adam = static_cast<torch::optim::AdamParamState&>(*param_state);
+        adam.exp_avg(adam.exp_avg().to(device));
+        adam.exp_avg_sq(adam.exp_avg_sq().to(device));
+        if (adam.max_exp_avg_sq().defined())
+        {
+            adam.max_exp_avg_sq(adam.max_exp_avg_sq().to(device));
+        }
+    }
+
+    torch::Tensor rng;
+    training.read("cpu_rng", rng);
+    set_generator_state(torch::kCPU, rng);
+    torch::Tensor device_rng;
+    if (device.is_cuda() && training.try_read("device_rng", device_rng))
+    {
+        set_generator_state(device, device_rng);
+    }
+
+    c10::IValue has_env_state;
+    training.read("has_env_state", has_env_state);
+    if (has_env_state.toBool())
+    {
+        torch::serialize::InputArchive env_archive;
+        training.read("envs", env_archive);
+        envs.load_state(env_archive);
+        torch::Tensor next_obs;
+        torch::Tensor next_done;
+        training.read("next_obs", next_obs);
+        training.read("next_done", next_done);
+        state.next_obs = next_obs.to(device);
+        state.next_done = next_done.to(device);
+    }
+
+    ResumePoint resume;
+    c10::IValue next_update;
+    training.read("next_update", next_update);
+    resume.first_update = next_update.toInt();
+    read_rng(training, "shuffle_rng", state.shuffler);
+    if (has_env_state.toBool())
+    {
+        read_rng(training, "sampling_rng", state.sampler);
+    }
+    return resume;
+}
+
+static bool checkpoint_due(const TrainingConfig& config, long update, long num_updates)
+{
+    return config.checkpoint_interval > 0
+           && ((update + 1) % config.checkpoint_interval == 0 || update + 1 == num_updates);
+}
+
+// The fused kernel continues the sampling stream, so switching fused_inference keeps the actions of a seeded run
+static std::optional<FusedActorCritic> make_fused(const Agent& agent, const TrainingConfig& config,
+                                                  const Philox& sampler)
+{
+    if (!config.fused_inference)
+    {
+        return std::nullopt;
+    }
+    auto fused = agent.make_fused();
+    fused.set_rng_state(sampler.get_state());
+    return fused;
+}
+
+static void train_synchronous(Agent& agent, torch::optim::Adam& optimizer, Environment& envs, RolloutState& state,
+                              const TrainingConfig& config, torch::Device device, long num_updates,
+                              std::chrono::steady_clock::time_point start, MetricsRecorder& metrics,
+                              const ResumePoint& resume, CheckpointWriter* checkpoints)
+{
+    auto rollout = make_rollout(config, envs, device);
+    auto fused = make_fused(agent, config, state.sampler);
+    std::cout << "Rollout storage: " << rollout.storage.bytes() / 1024 << " KiB\n";
+    std::int64_t trace_window_start = trace_now_ns();
+    for (long update = resume.first_update; update < num_updates; update++)
+    {
+        if (fused)
+        {
+            agent.pack_into(*fused);
+        }
+        collect_rollout(agent, fused ? &*fused : nullptr, envs, state, rollout, config, device);
+        rollout.policy_version = update;
+        log_update(update, num_updates, resume.first_update, rollout, 0, start, trace_window_start);
+        auto stats = ppo_update(agent, optimizer, rollout, config, device, state.shuffler, metrics.enabled());
+        metrics.record(update, rollout, 0, stats);
+        if (checkpoints != nullptr && checkpoint_due(config, update, num_updates))
+        {
+            checkpoints->submit(snapshot_checkpoint(agent, optimizer, envs, state, fused ? &*fused : nullptr,
+                                                    update + 1, true, device));
+        }
+    }
+}
+
+// Actor thread collects rollout k+1 with a snapshot of the policy while the learner optimizes on rollout k.
+// Rollouts are double buffered, so the policy lag can never exceed one update.
+static void train_pipelined(Agent& agent, torch::optim::Adam& optimizer, Environment& envs, RolloutState& state,
+                            const TrainingConfig& config, torch::Device device, long num_updates,
+                            std::chrono::steady_clock::time_point start, MetricsRecorder& metrics,
+                            const ResumePoint& resume, CheckpointWriter* checkpoints)
+{
+    const long max_lag = config.max_policy_lag;
+    std::array<Rollout, 2> buffers{make_rollout(config, envs, device), make_rollout(config, envs, device)};
+    std::array<bool, 2> full{};
+
+    // Latest learner weights, only touched while holding the mutex
+    Agent published{&envs};
+    published.to(device);
+    copy_parameters(published, agent);
+    long published_version = resume.first_update;
+
+    Agent snapshot{&envs};
+    snapshot.to(device);
+    auto fused = make_fused(agent, config, state.sampler);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+    std::exception_ptr actor_error;
+
+    std::jthread actor([&] {
+        set_trace_thread_name("actor");
+        try
+        {
+            for (long k = resume.first_update; k < num_updates; k++)
+            {
+                auto& rollout = buffers[k % 2];
+                {
+                    SWARM_TRACE_SCOPE("wait_for_policy");
+                    std::unique_lock lock(mutex);
+                    cv.wait(lock, [&] { return stop || (!full[k % 2] && published_version >= k - max_lag); });
+                    if (stop)
+                    {
+                        return;
+                    }
+                    copy_parameters(snapshot, published);
+                    rollout.policy_version = published_version;
+                }
+                if (fused)
+                {
+                    snapshot.pack_into(*fused);
+                }
+                collect_rollout(snapshot, fused ? &*fused : nullptr, envs, state, rollout, config, device);
+                {
+                    std::lock_guard lock(mutex);
+                    full[k % 2] = true;
+                }
+                cv.notify_all();
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard lock(mutex);
+            actor_error = std::current_exception();
+            cv.notify_all();
+        }
+    });
+
+    long max_seen_lag = 0;
+    std::int64_t trace_window_start = trace_now_ns();
+    try
+    {
+        for (long update = resume.first_update; update < num_updates; update++)
+        {
+            auto& rollout = buffers[update % 2];
+            {
+                SWARM_TRACE_SCOPE("wait_for_rollout");
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&] { return full[update % 2] || actor_error; });
+                if (actor_error)
+                {
+                    std::rethrow_exception(actor_error);
+                }
+            }
+            const long lag = update - rollout.policy_version;
+            max_seen_lag = std::max(max_seen_lag, lag);
+            log_update(update, num_updates, resume.first_update, rollout, lag, start, trace_window_start);
+            auto stats = ppo_update(agent, optimizer, rollout, config, device, state.shuffler, metrics.enabled());
+            metrics.record(update, rollout, lag, stats);
+            {
+                SWARM_TRACE_SCOPE("publish_policy");
+                std::lock_guard lock(mutex);
+                copy_parameters(published, agent);
+                published_version = update + 1;
+                full[update % 2] = false;
+            }
+            cv.notify_all();
+            if (checkpoints != nullptr && checkpoint_due(config, update, num_updates))
+            {
+                checkpoints->submit(snapshot_checkpoint(agent, optimizer, envs, state, nullptr, update + 1, false,
+                                                        device));
+            }
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        throw;
+    }
+    std::cout << "Max policy lag: " << max_seen_lag << '\n';
+}
+
+// Flat float32 copy of every parameter, in the order agent.parameters() returns them
+static torch::Tensor flatten_parameters(Agent& agent)
+{
+    torch::NoGradGuard nograd;
+    std::vector<torch::Tensor> flat;
+    for (const auto& p : agent.parameters())
+    {
+        flat.push_back(p.detach().reshape({-1}));
+    }
+    return torch::cat(flat).to(torch::kCPU, torch::kFloat32).contiguous();
+}
+
+static void load_flat_parameters(Agent& agent, const float* flat)
+{
+    torch::NoGradGuard nograd;
+    std::size_t offset = 0;
+    for (auto& p : agent.parameters())
+    {
+        p.copy_(torch::from_blob(const_cast<float*>(flat + offset), p.sizes(), torch::kFloat32));
+        offset += static_cast<std::size_t>(p.numel());
+    }
+}
+
+// Everything an actor process needs, set up by the learner before it forks
+struct ActorProcessSetup
+{
+    const Environment& prototype; // The env handed to train(), only cloned in the child after the fork
+    const TrainingConfig& config;
+    std::uint64_t seed;
+    long num_updates;
+    Agent& policy; // CPU copy, every actor overwrites its own with the published weights
+    SharedWeights& weights;
+    SharedRolloutRing& ring;
+};
+
+// Body of actor process `actor`. It steps its own envs_per_actor envs, samples with a FusedActorCritic refreshed from
+// the published weights before every rollout and writes straight into its env columns of ring slot k % 2.
+static void run_actor_process(std::size_t actor, const ActorProcessSetup& setup)
+{
+    // Inline ops only: the OpenMP pool did not survive fork(), and the learner and the other actors share the cores
+    torch::set_num_threads(1);
+    const auto& config = setup.config;
+    auto& ring = setup.ring;
+    const long num_envs = static_cast<long>(ring.num_envs());
+    const long obs_size = static_cast<long>(ring.obs_size());
+    const long envs_per_actor = static_cast<long>(ring.envs_per_actor());
+    const long first_env = static_cast<long>(actor) * envs_per_actor;
+
+    // Worker threads do not survive fork(), so the envs are only built here
+    auto actor_config = config;
+    actor_config.num_envs = envs_per_actor;
+    actor_config.num_env_workers = 1;
+    auto envs = make_envs(setup.prototype.clone(), actor_config);
+    envs->seed(setup.seed, k_env_streams + static_cast<std::uint64_t>(first_env));
+    // Observations and dones after the last step of a rollout, the rows before that live in the ring
+    std::vector<float> obs(static_cast<std::size_t>(envs_per_actor * obs_size));
+    std::vector<float> done(static_cast<std::size_t>(envs_per_actor));
+    envs->reset_into(obs);
+
+    auto fused = setup.policy.make_fused();
+    fused.seed(setup.seed, k_sampling_stream + actor);
+    std::vector<float> weights(setup.weights.size());
+    const long max_lag = config.max_policy_lag;
+
+    // Forked before the learner loaded its checkpoint, the first update comes with the start signal
+    std::uint32_t start = 0;
+    while ((start = ring.start().load(std::memory_order_acquire)) == 0)
+    {
+        if (ring.stop().load(std::memory_order_acquire) != 0)
+        {
+            return;
+        }
+        shared_wait(ring.start(), 0, std::chrono::milliseconds{100});
+    }
+
+    for (long k = static_cast<long>(start) - 1; k < setup.num_updates; k++)
+    {
+        // The learner publishes update k - 1 only after it released slot (k - 2) % 2 == k % 2
+        const auto wanted = static_cast<std::uint32_t>(std::max(k - max_lag, 0L));
+        while (true)
+        {
+            if (ring.stop().load(std::memory_order_acquire) != 0)
+            {
+                return;
+            }
+            const auto version = setup.weights.version();
+            if (version >= wanted)
+            {
+                break;
+            }
+            shared_wait(setup.weights.version_word(), version, std::chrono::milliseconds{100});
+        }
+        const auto version = setup.weights.read(weights.data());
+        load_flat_parameters(setup.policy, weights.data());
+        setup.policy.pack_into(fused);
+
+        const auto slot = static_cast<std::size_t>(k) % SharedRolloutRing::k_num_slots;
+        // Every step reads its observation from the ring and the env writes the next one into the ring's next row
+        const auto rows = static_cast<std::size_t>(envs_per_actor);
+        for (long step = 0; step < config.num_steps; step++)
+        {
+            const long row = step * num_envs + first_env;
+            float* obs_row = ring.observations(slot) + row * obs_size;
+            if (step == 0)
+            {
+                std::memcpy(obs_row, obs.data(), obs.size() * sizeof(float));
+                std::memcpy(ring.dones(slot) + row, done.data(), done.size() * sizeof(float));
+            }
+            fused.act(obs_row, rows, ring.actions(slot) + row, ring.logprobs(slot) + row, ring.values(slot) + row);
+            const bool last = step + 1 == config.num_steps;
+            const long next_row = row + num_envs;
+            envs->step_into({{ring.actions(slot) + row, rows},
+                             {last ? obs.data() : ring.observations(slot) + next_row * obs_size, obs.size()},
+                             {ring.rewards(slot) + row, rows},
+                             {last ? done.data() : ring.dones(slot) + next_row, rows}});
         }
-    	auto mean_reward = rewards.mean().item<float>();
-    	if (update % 10 == 0) {
-    		std::cout << "Update " << update
-					  << " / " << num_updates
-					  << "  mean reward: " << mean_reward << '\n';
-    	}
 
-        // Bootstrap value for GAE
-        torch::Tensor next_value;
         {
             torch::NoGradGuard nograd;
-            next_value = agent.get_value(next_obs).reshape({1, -1});
+            const auto value = setup.policy.get_value(torch::from_blob(obs.data(), {envs_per_actor, obs_size}))
+                                   .to(torch::kFloat32)
+                                   .reshape({-1})
+                                   .contiguous();
+            std::memcpy(ring.next_values(slot) + first_env, value.data_ptr<float>(), rows * sizeof(float));
         }
+        std::memcpy(ring.next_dones(slot) + first_env, done.data(), rows * sizeof(float));
+        ring.report(slot, actor) = {static_cast<std::int64_t>(version), envs->take_episode_stats()};
+        ring.ready(slot).fetch_add(1, std::memory_order_acq_rel);
+        shared_wake_all(ring.ready(slot));
+    }
+}
 
+// Waits until every actor finished its part of the slot. Rethrows actor errors and notices actors that died.
+static void wait_for_actors(const SharedRolloutRing& ring, std::size_t slot, std::vector<pid_t>& actors)
+{
+    while (true)
+    {
+        const auto ready = ring.ready(slot).load(std::memory_order_acquire);
+        if (ready == ring.num_actors())
+        {
+            return;
+        }
+        if (ring.failed())
+        {
+            throw std::runtime_error(ring.error());
+        }
+        for (auto& pid : actors)
+        {
+            int status = 0;
+            if (pid > 0 && ::waitpid(pid, &status, WNOHANG) == pid)
+            {
+                // An actor that wrote its last rollout leaves before the learner consumed it
+                pid = 0;
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                {
+                    throw std::runtime_error(std::format("Actor process died with status {}", status));
+                }
+            }
+        }
+        shared_wait(ring.ready(slot), ready, std::chrono::milliseconds{100});
+    }
+}
 
+static void stop_actor_processes(SharedRolloutRing& ring, SharedWeights& weights, std::vector<pid_t>& actors,
+                                 bool kill)
+{
+    ring.stop().store(1, std::memory_order_release);
+    shared_wake_all(weights.version_word());
+    for (auto& pid : actors)
+    {
+        if (pid <= 0)
+        {
+            continue;
+        }
+        if (kill)
+        {
+            ::kill(pid, SIGKILL);
+        }
+        ::waitpid(pid, nullptr, 0);
+        pid = 0;
+    }
+}
+
+// The learner's view of a finished slot, without a copy when training on the CPU
+static Rollout wrap_rollout(const SharedRolloutRing& ring, std::size_t slot, const Environment& envs,
+                            torch::Device device)
+{
+    const auto steps = static_cast<long>(ring.num_steps());
+    const auto num_envs = static_cast<long>(ring.num_envs());
+    const auto column = [&](float* data) {
+        return torch::from_blob(data, {steps, num_envs}, torch::kFloat32).to(device);
+    };
+    Rollout rollout{RolloutStorage::wrap(
+        torch::from_blob(ring.observations(slot), {steps, num_envs, static_cast<long>(ring.obs_size())},
+                         torch::kFloat32).to(device),
+        torch::from_blob(ring.actions(slot), {steps, num_envs}, torch::kLong).to(device),
+        column(ring.logprobs(slot)), column(ring.rewards(slot)), column(ring.dones(slot)), column(ring.values(slot)),
+        envs.get_action_space_size())};
+    rollout.next_value = torch::from_blob(ring.next_values(slot), {1, num_envs}, torch::kFloat32).to(device);
+    rollout.next_done = torch::from_blob(ring.next_dones(slot), {num_envs}, torch::kFloat32).to(device);
+    rollout.policy_version = std::numeric_limits<long>::max();
+    for (std::size_t actor = 0; actor < ring.num_actors(); actor++)
+    {
+        const auto& report = ring.report(slot, actor);
+        rollout.policy_version = std::min(rollout.policy_version, static_cast<long>(report.policy_version));
+        rollout.episodes += report.episodes;
+    }
+    return rollout;
+}
+
+static std::size_t num_parameters(Agent& agent)
+{
+    std::size_t count = 0;
+    for (const auto& p : agent.parameters())
+    {
+        count += static_cast<std::size_t>(p.numel());
+    }
+    return count;
+}
+
+// The actor processes and the shared memory they write to. They are forked in the constructor, before train() starts
+// any thread of its own (env workers, checkpoint and metrics writers, the inter-op pool): a child only keeps the
+// forking thread and would inherit whatever locks the others held. Nothing here clones the env before the fork, the
+// children clone it themselves, and train() only takes single envs, which own no threads. What the caller ran before
+// train(), e.g. libtorch in its Agent, is not covered. The actors idle until start() tells them where to begin.
+class ActorProcesses
+{
+    Agent m_policy;
+    SharedRolloutRing m_ring;
+    SharedWeights m_weights;
+    std::vector<pid_t> m_pids;
+
+public:
+    ActorProcesses(const Environment& env, const TrainingConfig& config, std::uint64_t seed, long num_updates)
+        : m_policy(&env)
+        , m_ring(static_cast<std::size_t>(config.num_steps), static_cast<std::size_t>(config.num_envs),
+                 env.get_observation_size(), static_cast<std::size_t>(config.num_actor_processes))
+        , m_weights(num_parameters(m_policy))
+    {
+        const auto num_actors = static_cast<std::size_t>(config.num_actor_processes);
+        std::cout << "Collecting with " << num_actors << " actor processes of " << m_ring.envs_per_actor()
+                  << " envs\n";
+        const ActorProcessSetup setup{env, config, seed, num_updates, m_policy, m_weights, m_ring};
+        // Buffered output would be written once more by every child
+        std::cout.flush();
+        const pid_t learner = ::getpid();
+        for (std::size_t actor = 0; actor < num_actors; actor++)
+        {
+            const pid_t pid = ::fork();
+            if (pid < 0)
+            {
+                stop(true);
+                throw std::runtime_error(std::format("Could not fork actor process {}", actor));
+            }
+            if (pid == 0)
+            {
+                // Never returns into the learner's stack. Dies with the learner, also when it is killed.
+                ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+                int status = 0;
+                if (::getppid() == learner)
+                {
+                    try
+                    {
+                        run_actor_process(actor, setup);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        m_ring.set_error(std::format("Actor process {}: {}", actor, e.what()));
+                        status = 1;
+                    }
+                }
+                ::_exit(status);
+            }
+            m_pids.push_back(pid);
+        }
+    }
+
+    // Kills actors still running, e.g. when the learner failed before or while training
+    ~ActorProcesses()
+    {
+        stop(true);
+    }
+
+    ActorProcesses(const ActorProcesses&) = delete;
+    ActorProcesses& operator=(const ActorProcesses&) = delete;
 
-        // Calculate GAE
-        auto advantages = torch::zeros_like(rewards).to(device);
-        torch::Tensor lastgaelam = torch::zeros({config.num_envs}).to(device); // Fix: use tensor not float
+    // Publishes the learner's weights as version first_update and lets the actors collect from there
+    void start(Agent& agent, long first_update)
+    {
+        const auto flat = flatten_parameters(agent);
+        m_weights.publish(static_cast<std::uint32_t>(first_update), flat.data_ptr<float>());
+        m_ring.start().store(static_cast<std::uint32_t>(first_update) + 1, std::memory_order_release);
+        shared_wake_all(m_ring.start());
+    }
+
+    // Waits for the actors to exit after their last rollout, or kills them
+    void stop(bool kill)
+    {
+        stop_actor_processes(m_ring, m_weights, m_pids, kill);
+    }
+
+    SharedRolloutRing& ring()
+    {
+        return m_ring;
+    }
+    SharedWeights& weights()
+    {
+        return m_weights;
+    }
+    std::vector<pid_t>& pids()
+    {
+        return m_pids;
+    }
+};
+
+// Like train_pipelined, but the actors are forked processes, so stepping and sampling share neither the learner's
+// allocator nor its thread pools. Each one steps a contiguous range of the envs and writes its part of rollout k into
+// slot k % 2 of a SharedRolloutRing, the learner publishes its weights through SharedWeights after every update.
+// The policy lag is at most one update. Env state lives in the actors, so checkpoints resume with fresh envs.
+static void train_actor_processes(Agent& agent, torch::optim::Adam& optimizer, Environment& envs,
+                                  ActorProcesses& actors, RolloutState& state, const TrainingConfig& config,
+                                  torch::Device device, long num_updates,
+                                  std::chrono::steady_clock::time_point start, MetricsRecorder& metrics,
+                                  const ResumePoint& resume, CheckpointWriter* checkpoints)
+{
+    auto& ring = actors.ring();
+    auto& weights = actors.weights();
+    actors.start(agent, resume.first_update);
 
-        for (long t = config.num_steps - 1; t >= 0; t--)
+    long max_seen_lag = 0;
+    std::int64_t trace_window_start = trace_now_ns();
+    try
+    {
+        for (long update = resume.first_update; update < num_updates; update++)
         {
-            torch::Tensor nextnonterminal;
-            torch::Tensor nextvalues;
+            const auto slot = static_cast<std::size_t>(update) % SharedRolloutRing::k_num_slots;
+            {
+                SWARM_TRACE_SCOPE("wait_for_rollout");
+                wait_for_actors(ring, slot, actors.pids());
+            }
+            {
+                auto rollout = wrap_rollout(ring, slot, envs, device);
+                const long lag = update - rollout.policy_version;
+                max_seen_lag = std::max(max_seen_lag, lag);
+                log_update(update, num_updates, resume.first_update, rollout, lag, start, trace_window_start);
+                auto stats = ppo_update(agent, optimizer, rollout, config, device, state.shuffler,
+                                        metrics.enabled());
+                metrics.record(update, rollout, lag, stats);
+            }
+            {
+                SWARM_TRACE_SCOPE("publish_policy");
+                ring.ready(slot).store(0, std::memory_order_release);
+                const auto flat = flatten_parameters(agent);
+                weights.publish(static_cast<std::uint32_t>(update + 1), flat.data_ptr<float>());
+            }
+            if (checkpoints != nullptr && checkpoint_due(config, update, num_updates))
+            {
+                checkpoints->submit(snapshot_checkpoint(agent, optimizer, envs, state, nullptr, update + 1, false,
+                                                        device));
+            }
+        }
+    }
+    catch (...)
+    {
+        actors.stop(true);
+        throw;
+    }
+    actors.stop(false);
+    std::cout << "Max policy lag: " << max_seen_lag << '\n';
+}
 
-            if (t == config.num_steps - 1)
+static void configure_threads(const TrainingConfig& config)
+{
+    // Thread pools are process wide. The intra-op size can change any time, libtorch only accepts the inter-op size
+    // once and before its first inter-op task, so later training runs in the same process keep the first size.
+    if (config.intra_op_threads > 0)
+    {
+        torch::set_num_threads(config.intra_op_threads);
+    }
+    if (config.inter_op_threads > 0 && config.inter_op_threads != torch::get_num_interop_threads())
+    {
+        static std::once_flag inter_op_once;
+        bool applied = false;
+        std::call_once(inter_op_once, [&] {
+            try
             {
-                nextnonterminal = 1.0 - next_done;
-                nextvalues = next_value.squeeze(0);
+                torch::set_num_interop_threads(config.inter_op_threads);
+                applied = true;
             }
-            else
+            catch (const c10::Error&)
             {
-                nextnonterminal = 1.0 - dones[t + 1];
-                nextvalues = values[t + 1];
+                // The pool was already started, by an earlier run or by the caller
             }
+        });
+        if (!applied)
+        {
+            std::cout << "The inter-op pool already has " << torch::get_num_interop_threads()
+                      << " threads, libtorch cannot resize it, ignoring inter_op_threads=" << config.inter_op_threads
+                      << '\n';
+        }
+    }
+}
 
-            auto delta = rewards[t] + config.gamma * nextvalues * nextnonterminal - values[t];
-            advantages[t] = lastgaelam = delta + config.gamma * config.gae_lambda * nextnonterminal * lastgaelam;
+void train(Agent& agent, std::unique_ptr<Environment> env, const TrainingConfig& config)
+{
+    // Two rollout buffers bound the lag, the actor cannot run further ahead
+    if (config.max_policy_lag < 0 || config.max_policy_lag > 1)
+    {
+        throw std::invalid_argument(std::format("max_policy_lag must be 0 or 1, got {}", config.max_policy_lag));
+    }
+    if (config.num_actor_processes > 0)
+    {
+        if (env->get_num_envs() > 1)
+        {
+            // Also keeps out every env that owns worker threads, fork() would leave them behind
+            throw std::invalid_argument("Actor processes clone single envs, vectorized envs are not supported");
+        }
+        if (config.pipelined || !config.trajectory_path.empty())
+        {
+            throw std::invalid_argument("num_actor_processes cannot be combined with pipelined or trajectory_path");
+        }
+        if (config.obs_dtype != torch::kFloat32 || config.value_dtype != torch::kFloat32)
+        {
+            throw std::invalid_argument(
+                std::format("Actor processes write float32 rollouts, got obs_dtype {} and value_dtype {}",
+                            c10::toString(config.obs_dtype), c10::toString(config.value_dtype)));
         }
+    }
+    // Unseeded runs draw a seed and print it, so any run can be repeated bit for bit
+    const std::uint64_t seed = config.seed ? *config.seed : std::random_device{}();
+    std::cout << "Seed: " << seed << '\n';
+    const long batch_size = config.num_steps * config.num_envs;
+    long num_updates = config.total_timesteps / batch_size;
+    // Forked first, everything below may start threads
+    std::optional<ActorProcesses> actors;
+    if (config.num_actor_processes > 0)
+    {
+        actors.emplace(*env, config, seed, num_updates);
+    }
 
-        auto returns = advantages + values;
+    configure_threads(config);
+    auto envs = make_envs(std::move(env), config);
+    torch::manual_seed(seed);
+    envs->seed(seed);
+    const torch::Device device = config.device.value_or(TensorFactory::instance().device());
+    std::cout << "Training on " << device << " with " << torch::get_num_threads() << " intra-op / "
+              << torch::get_num_interop_threads() << " inter-op threads"
+              << (config.bf16_autocast ? ", bf16 autocast" : "") << '\n';
+	agent.to(device);
+    torch::optim::Adam optimizer{agent.parameters(), torch::optim::AdamOptions(config.learning_rate).eps(1e-5)};
 
-        // Flatten the batch
-        auto b_obs = obs.reshape({batch_size, obs_size});
-        auto b_logprobs = logprobs.reshape({batch_size});
-        auto b_actions = actions.reshape({batch_size});
-        auto b_advantages = advantages.reshape({batch_size});
-        auto b_returns = returns.reshape({batch_size});
-        auto b_values = values.reshape({batch_size});
+    RolloutState state{envs->reset().to(device), torch::zeros(config.num_envs).to(device)};
+    state.sampler.seed(seed, k_sampling_stream);
+    state.shuffler.seed(seed, k_shuffle_stream);
 
-        // PPO update
-        for (long epoch = 0; epoch < config.update_epochs; epoch++)
+    ResumePoint resume;
+    if (config.resume && std::filesystem::exists(config.checkpoint_path))
+    {
+        resume = load_checkpoint(config.checkpoint_path, agent, optimizer, *envs, state, device);
+        std::cout << "Resuming " << config.checkpoint_path << " at update " << resume.first_update << '\n';
+    }
+    std::optional<CheckpointWriter> checkpoints;
+    if (config.checkpoint_interval > 0)
+    {
+        checkpoints.emplace(config.checkpoint_path);
+    }
+    CheckpointWriter* checkpoint_writer = checkpoints ? &*checkpoints : nullptr;
+    std::optional<TrajectoryTap> trajectory;
+    if (!config.trajectory_path.empty())
+    {
+        trajectory.emplace(config.trajectory_path, *envs);
+        state.trajectory = &*trajectory;
+    }
+
+    const bool trace = !config.trace_path.empty();
+    if (trace && !k_tracing_compiled)
+    {
+        std::cout << "Tracing was compiled out (ENABLE_TRACING=OFF), not writing " << config.trace_path << '\n';
+    }
+    else if (trace)
+    {
+        set_trace_thread_name("learner");
+        start_tracing();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto trace_start = trace_now_ns();
+    MetricsRecorder metrics(config, start, resume.first_update);
+    try
+    {
+        if (config.num_actor_processes > 0)
+        {
+            train_actor_processes(agent, optimizer, *envs, *actors, state, config, device, num_updates, start,
+                                  metrics, resume, checkpoint_writer);
+        }
+        else if (config.pipelined)
         {
-            // Generate random permutation of indices
-            auto perm = torch::randperm(batch_size, torch::kLong);
+            train_pipelined(agent, optimizer, *envs, state, config, device, num_updates, start, metrics, resume,
+                            checkpoint_writer);
+        }
+        else
+        {
+            train_synchronous(agent, optimizer, *envs, state, config, device, num_updates, start, metrics, resume,
+                              checkpoint_writer);
+        }
+    }
+    catch (...)
+    {
+        stop_tracing();
+        throw;
+    }
+    const long trained_steps = std::max(num_updates - resume.first_update, 0L) * batch_size;
+    std::cout << "SPS: " << static_cast<long>(steps_per_second(start, trained_steps)) << '\n';
+    if (checkpoints)
+    {
+        checkpoints->wait();
+        std::cout << "Checkpoint written to " << checkpoints->path() << '\n';
+    }
+    if (trajectory)
+    {
+        auto& recorder = trajectory->recorder();
+        recorder.close();
+        std::cout << "Recorded " << recorder.get_num_steps() << " steps to " << config.trajectory_path << " ("
+                  << recorder.get_num_stalls() << " waits on the disk)\n";
+    }
+    metrics.flush();
+    if (metrics.dropped() > 0)
+    {
+        std::cout << "Metrics writer fell behind, dropped " << metrics.dropped() << " records\n";
+    }
+
+    if (tracing_enabled())
+    {
+        stop_tracing();
+        std::cout << "Phases over the whole run:\n";
+        print_phase_breakdown(trace_start, num_updates);
+        write_chrome_trace(config.trace_path);
+        std::cout << "Trace written to " << config.trace_path << '\n';
+    }
+}
 
-            for (long start = 0; start < batch_size; start += minibatch_size)
+// ppo_update for a StackedAgent. Policy k owns the env columns [k * num_envs, (k + 1) * num_envs) of the rollout and
+// gets its own minibatch permutations, the K minibatches of a step are stacked into one [K, M] batch.
+static void ppo_update_population(StackedAgent& stacked, torch::optim::Adam& optimizer, const RolloutStorage& storage,
+                                  const torch::Tensor& next_value, const torch::Tensor& next_done,
+                                  const TrainingConfig& config, torch::Device device, std::vector<Philox>& shufflers)
+{
+    SWARM_TRACE_SCOPE("ppo_update");
+    using Minibatch = MinibatchIterator::Minibatch;
+    const long num_envs = config.num_envs;
+    const long policy_batch = config.num_steps * num_envs;
+    auto values = storage.values();
+    GaeResult gae;
+    {
+        SWARM_TRACE_SCOPE("gae");
+        gae = compute_gae(storage.rewards(), values, storage.dones(), next_value, next_done, config.gamma,
+                          config.gae_lambda);
+    }
+    auto& [advantages, returns] = gae;
+
+    SWARM_TRACE_SCOPE("minibatch_layout");
+    // Storage row of every transition, [num_steps, K * num_envs] like the rollout
+    const auto storage_rows = torch::arange(storage.num_steps() * storage.num_envs(),
+                                            torch::TensorOptions().dtype(torch::kLong).device(values.device()))
+                                  .view({storage.num_steps(), storage.num_envs()});
+    std::vector<std::unique_ptr<MinibatchIterator>> policies;
+    for (std::size_t k = 0; k < stacked.num_policies(); k++)
+    {
+        const auto rows = [&](const torch::Tensor& column) {
+            return column.narrow(1, static_cast<long>(k) * num_envs, num_envs).reshape({policy_batch});
+        };
+        policies.push_back(std::make_unique<MinibatchIterator>(
+            storage, rows(storage_rows), rows(advantages), rows(returns), rows(values),
+            policy_batch / config.num_minibatches, config.update_epochs, shufflers[k]));
+    }
+
+    while (true)
+    {
+        bool more = true;
+        {
+            SWARM_TRACE_SCOPE("minibatch_shuffle_wait");
+            for (auto& policy : policies)
+            {
+                more &= policy->next_epoch();
+            }
+        }
+        if (!more)
+        {
+            break;
+        }
+        for (long i = 0; i < policies.front()->num_minibatches(); i++)
+        {
+            std::vector<Minibatch> minibatches;
+            for (const auto& policy : policies)
             {
-                long end = std::min(start + minibatch_size, batch_size);
-                auto mb_inds = perm.slice(0, start, end).to(device);
+                minibatches.push_back(policy->minibatch(i));
+            }
+            const auto stack = [&](torch::Tensor Minibatch::*field) {
+                std::vector<torch::Tensor> parts;
+                for (const auto& minibatch : minibatches)
+                {
+                    parts.push_back(minibatch.*field);
+                }
+                return torch::stack(parts);
+            };
 
-                // Use index_select instead of index for tensor indexing
-                auto res = agent.get_action_and_value(
-                    b_obs.index_select(0, mb_inds),
-                    b_actions.index_select(0, mb_inds)
-                );
-                auto newlogprob = res.log_prob;
-                auto entropy = res.entropy;
-                auto newvalue = res.value;
+            Agent::ActionDetails res;
+            {
+                SWARM_TRACE_SCOPE("forward");
+                AutocastGuard autocast(config.bf16_autocast, device);
+                res = stacked.get_action_and_value(stack(&Minibatch::observations), stack(&Minibatch::actions));
+            }
+            const PpoLossInputs inputs{
+                res.log_prob.to(torch::kFloat32),
+                res.entropy.to(torch::kFloat32),
+                res.value.to(torch::kFloat32),
+                stack(&Minibatch::logprobs),
+                stack(&Minibatch::advantages),
+                stack(&Minibatch::returns),
+                stack(&Minibatch::values),
+            };
+            PpoLossResult loss;
+            {
+                SWARM_TRACE_SCOPE("loss");
+                loss = ppo_loss(inputs, config.clip_coef, config.vf_coef, config.ent_coef);
+            }
 
-                auto logratio = newlogprob - b_logprobs.index_select(0, mb_inds);
-                auto ratio = logratio.exp();
+            optimizer.zero_grad();
+            {
+                SWARM_TRACE_SCOPE("backward");
+                // The policies share no parameters, so each slice only gets the gradient of its own loss
+                loss.loss.sum().backward();
+            }
+            SWARM_TRACE_SCOPE("optimizer_step");
+            stacked.clip_grad_norm(config.max_grad_norm);
+            optimizer.step();
+        }
+    }
+}
 
-                auto mb_advantages = b_advantages.index_select(0, mb_inds);
-                // Normalize advantages
-                mb_advantages = (mb_advantages - mb_advantages.mean()) /
-                               (mb_advantages.std() + 1e-8);
+void train_population(const std::vector<Agent*>& agents, std::vector<std::unique_ptr<Environment>> envs,
+                      const TrainingConfig& config)
+{
+    if (agents.empty() || agents.size() != envs.size())
+    {
+        throw std::invalid_argument(
+            std::format("Population training needs one env per agent, got {} agents and {} envs", agents.size(),
+                        envs.size()));
+    }
+    if (config.pipelined || config.num_actor_processes > 0 || config.checkpoint_interval > 0 || config.resume
+        || !config.metrics_path.empty() || !config.trajectory_path.empty())
+    {
+        throw std::invalid_argument("Population training is synchronous, without checkpoints, metrics or "
+                                    "trajectories");
+    }
+    configure_threads(config);
 
-                // Policy loss
-                auto pg_loss1 = -mb_advantages * ratio;
-                auto pg_loss2 = -mb_advantages * torch::clamp(ratio,
-                                                              1 - config.clip_coef,
-                                                              1 + config.clip_coef);
-                auto pg_loss = torch::max(pg_loss1, pg_loss2).mean();
+    const long num_policies = static_cast<long>(agents.size());
+    const long num_envs = config.num_envs;
+    const long total_envs = num_policies * num_envs;
+    std::vector<std::unique_ptr<Environment>> batches;
+    for (auto& env : envs)
+    {
+        batches.push_back(make_envs(std::move(env), config));
+        if (batches.back()->get_observation_size() != batches.front()->get_observation_size()
+            || batches.back()->get_action_space_size() != batches.front()->get_action_space_size())
+        {
+            throw std::invalid_argument("Every env of a population needs the same observation and action sizes");
+        }
+    }
 
-                // Value loss
-                newvalue = newvalue.view(-1);
-                auto mb_returns = b_returns.index_select(0, mb_inds);
-                auto mb_values = b_values.index_select(0, mb_inds);
+    const std::uint64_t seed = config.seed ? *config.seed : std::random_device{}();
+    std::cout << "Seed: " << seed << '\n';
+    torch::manual_seed(seed);
+    for (long k = 0; k < num_policies; k++)
+    {
+        // Policy k's envs continue the env streams where those of policy k - 1 end
+        batches[k]->seed(seed, k_env_streams + static_cast<std::uint64_t>(k * num_envs));
+    }
+    Philox sampler{seed, k_sampling_stream};
+    std::vector<Philox> shufflers;
+    for (long k = 0; k < num_policies; k++)
+    {
+        shufflers.emplace_back(seed, k_shuffle_stream + static_cast<std::uint64_t>(k));
+    }
 
-                auto v_loss_unclipped = (newvalue - mb_returns).pow(2);
-                auto v_clipped = mb_values +
-                                torch::clamp(newvalue - mb_values,
-                                           -config.clip_coef,
-                                           config.clip_coef);
-                auto v_loss_clipped = (v_clipped - mb_returns).pow(2);
-                auto v_loss_max = torch::max(v_loss_unclipped, v_loss_clipped);
-                auto v_loss = 0.5 * v_loss_max.mean();
+    const torch::Device device = config.device.value_or(TensorFactory::instance().device());
+    StackedAgent stacked(agents);
+    stacked.to(device);
+    torch::optim::Adam optimizer{stacked.parameters(), torch::optim::AdamOptions(config.learning_rate).eps(1e-5)};
+    std::cout << "Training " << num_policies << " stacked policies on " << device << '\n';
 
-                auto entropy_loss = entropy.mean();
-                auto loss = pg_loss - config.ent_coef * entropy_loss + v_loss * config.vf_coef;
+    const auto obs_size = static_cast<long>(batches.front()->get_observation_size());
+    RolloutStorage storage(config.num_steps, total_envs, obs_size, batches.front()->get_action_space_size(),
+                           config.obs_dtype, config.value_dtype, device);
+    const auto gather = [&](auto&& field) {
+        std::vector<torch::Tensor> parts;
+        for (long k = 0; k < num_policies; k++)
+        {
+            parts.push_back(field(k));
+        }
+        return torch::cat(parts).to(device);
+    };
+    auto next_obs = gather([&](long k) { return batches[k]->reset().to(torch::kFloat32); });
+    auto next_done = torch::zeros({total_envs}).to(device);
 
-                optimizer.zero_grad();
-                loss.backward();
-                torch::nn::utils::clip_grad_norm_(agent.parameters(), config.max_grad_norm);
-                optimizer.step();
+    // total_timesteps is every policy's budget, as train() gives it to one agent, so populations compare to single runs
+    const long num_updates = config.total_timesteps / (config.num_steps * num_envs);
+    const auto start = std::chrono::steady_clock::now();
+    for (long update = 0; update < num_updates; update++)
+    {
+        {
+            SWARM_TRACE_SCOPE("collect_rollout");
+            for (long step = 0; step < config.num_steps; step++)
+            {
+                Agent::ActionDetails res;
+                {
+                    SWARM_TRACE_SCOPE("policy_inference");
+                    torch::NoGradGuard nograd;
+                    AutocastGuard autocast(config.bf16_autocast, device);
+                    auto uniform = torch::empty({num_policies, num_envs}, torch::kFloat32);
+                    sampler.fill_uniform(uniform.data_ptr<float>(), uniform.numel(), 0.0f, 1.0f);
+                    res = stacked.sample_action_and_value(next_obs.view({num_policies, num_envs, obs_size}),
+                                                          uniform.to(device));
+                }
+                const auto action = res.action.reshape({total_envs});
+                const auto host_action = action.cpu();
+                std::vector<Environment::StepResult> results;
+                {
+                    SWARM_TRACE_SCOPE("env_step");
+                    for (long k = 0; k < num_policies; k++)
+                    {
+                        results.push_back(batches[k]->step(host_action.narrow(0, k * num_envs, num_envs)));
+                    }
+                }
+                SWARM_TRACE_SCOPE("store_and_host_to_device");
+                storage.store(step, next_obs, action, res.log_prob.reshape({total_envs}),
+                              gather([&](long k) { return results[k].reward.reshape({-1}); }), next_done,
+                              res.value.reshape({total_envs}));
+                next_obs = gather([&](long k) { return results[k].observations.to(torch::kFloat32); });
+                next_done = gather([&](long k) { return results[k].done.to(torch::kFloat32).reshape({-1}); });
             }
         }
+        torch::Tensor next_value;
+        {
+            torch::NoGradGuard nograd;
+            next_value = stacked.get_value(next_obs.view({num_policies, num_envs, obs_size})).reshape({1, -1});
+        }
+        std::vector<EpisodeStats> episodes;
+        for (const auto& batch : batches)
+        {
+            episodes.push_back(batch->take_episode_stats());
+        }
+        if (update % 10 == 0)
+        {
+            std::cout << "Update " << update << " / " << num_updates << "  episode return:";
+            for (const auto& stats : episodes)
+            {
+                std::cout << ' ' << stats.mean_return();
+            }
+            // Steps of all policies together, every one of them takes num_steps * num_envs per update
+            std::cout << "  SPS: "
+                      << static_cast<long>(steps_per_second(start, (update + 1) * config.num_steps * total_envs))
+                      << '\n';
+        }
+        ppo_update_population(stacked, optimizer, storage, next_value, next_done, config, device, shufflers);
+    }
+    const long total_steps = num_updates * config.num_steps * total_envs;
+    std::cout << "SPS: " << static_cast<long>(steps_per_second(start, total_steps)) << " over " << num_policies
+              << " policies, " << total_steps / num_policies << " steps each\n";
+    for (long k = 0; k < num_policies; k++)
+    {
+        stacked.unstack_into(static_cast<std::size_t>(k), *agents[k]);
     }
-}
\ No newline at end of file
+}
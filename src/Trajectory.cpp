@@ -0,0 +1,525 @@
+//
+// Created by chris on 10/18/26.
+//
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/Trajectory.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+static_assert(std::endian::native == std::endian::little, "Trajectories are stored little endian");
+
+static constexpr char		 k_magic[8]		  = {'S', 'W', 'R', 'M', 'T', 'R', 'A', 'J'};
+static constexpr std::size_t k_column_alignment = 64;
+// Chunk offsets must be page aligned to map them one by one, 64 KiB covers every page size we run on
+static constexpr std::size_t k_page_bytes	  = 64 * 1024;
+static constexpr std::size_t k_header_bytes	  = k_page_bytes;
+static constexpr std::uint32_t k_flag_positions = 1;
+
+struct TrajectoryHeader
+{
+	char		  magic[8];
+	std::uint32_t version;
+	std::uint32_t flags;
+	std::uint32_t num_envs;
+	std::uint32_t obs_size;
+	std::uint32_t steps_per_chunk;
+	std::uint32_t reserved0;
+	std::uint64_t chunk_bytes;
+	std::uint64_t num_steps; // Steps in flushed chunks, advanced by the flusher
+	std::uint8_t  reserved[16];
+};
+static_assert(sizeof(TrajectoryHeader) == 64);
+
+static std::size_t align_up(std::size_t offset, std::size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+TrajectoryLayout::TrajectoryLayout(std::size_t num_envs, std::size_t obs_size, std::size_t steps_per_chunk,
+								   bool has_positions)
+	: obs_size(obs_size)
+	, num_envs(num_envs)
+	, steps_per_chunk(steps_per_chunk)
+	, has_positions(has_positions)
+{
+	const std::size_t rows	 = steps_per_chunk * num_envs;
+	std::size_t		  offset = 0;
+	const auto column = [&](std::size_t bytes) {
+		const auto start = offset;
+		offset			 = align_up(offset + bytes, k_column_alignment);
+		return start;
+	};
+	observations = column(rows * obs_size * sizeof(float));
+	actions		 = column(rows * sizeof(std::int32_t));
+	logprobs	 = column(rows * sizeof(float));
+	values		 = column(rows * sizeof(float));
+	rewards		 = column(rows * sizeof(float));
+	dones		 = column(rows * sizeof(std::uint8_t));
+	positions	 = column(has_positions ? rows * 4 * sizeof(float) : 0);
+	chunk_bytes	 = align_up(offset, k_page_bytes);
+}
+
+TrajectorySlice TrajectoryLayout::slice(const std::byte* chunk, std::size_t first_step, std::size_t row,
+										std::size_t count) const
+{
+	const std::size_t first = row * num_envs;
+	const std::size_t rows	= count * num_envs;
+	const auto floats = [&](std::size_t column, std::size_t width) {
+		return std::span<const float>(reinterpret_cast<const float*>(chunk + column) + first * width, rows * width);
+	};
+	TrajectorySlice slice;
+	slice.first_step   = first_step;
+	slice.num_steps	   = count;
+	slice.observations = floats(observations, obs_size);
+	slice.actions = std::span<const std::int32_t>(reinterpret_cast<const std::int32_t*>(chunk + actions) + first, rows);
+	slice.logprobs = floats(logprobs, 1);
+	slice.values   = floats(values, 1);
+	slice.rewards  = floats(rewards, 1);
+	slice.dones	   = std::span<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(chunk + dones) + first, rows);
+	if (has_positions)
+	{
+		slice.positions = floats(positions, 4);
+	}
+	return slice;
+}
+
+TrajectoryRecorder::TrajectoryRecorder(const std::filesystem::path& path, std::size_t num_envs, std::size_t obs_size,
+									   bool with_positions, std::size_t steps_per_chunk)
+	: m_layout(num_envs, obs_size, steps_per_chunk, with_positions)
+{
+	if (num_envs == 0 || obs_size == 0 || steps_per_chunk == 0)
+	{
+		throw std::invalid_argument(std::format("Trajectory needs envs, observations and steps per chunk, got {}, {}, {}",
+												num_envs, obs_size, steps_per_chunk));
+	}
+	m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (m_fd < 0)
+	{
+		throw std::runtime_error(std::format("Could not create trajectory {}", path.string()));
+	}
+	void* header = MAP_FAILED;
+	if (::ftruncate(m_fd, k_header_bytes) == 0)
+	{
+		header = ::mmap(nullptr, k_header_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	}
+	if (header == MAP_FAILED)
+	{
+		::close(m_fd);
+		throw std::runtime_error(std::format("Could not map the header of trajectory {}", path.string()));
+	}
+	m_header = static_cast<std::byte*>(header);
+
+	TrajectoryHeader values{};
+	std::memcpy(values.magic, k_magic, sizeof(k_magic));
+	values.version		   = k_version;
+	values.flags		   = with_positions ? k_flag_positions : 0;
+	values.num_envs		   = static_cast<std::uint32_t>(num_envs);
+	values.obs_size		   = static_cast<std::uint32_t>(obs_size);
+	values.steps_per_chunk = static_cast<std::uint32_t>(steps_per_chunk);
+	values.chunk_bytes	   = m_layout.chunk_bytes;
+	std::memcpy(m_header, &values, sizeof(values));
+
+	m_thread = std::jthread([this] { run(); });
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TrajectoryRecorder::run()
+{
+	while (true)
+	{
+		Chunk full;
+		bool  have_full = false;
+		{
+			std::unique_lock lock(m_mutex);
+			m_cv.wait(lock, [&] {
+				return !m_full.empty() || m_closing || (m_ready.size() < k_chunks_ahead && !m_error);
+			});
+			if (!m_full.empty())
+			{
+				full = m_full.front();
+				m_full.pop_front();
+				have_full = true;
+			}
+			else if (m_closing)
+			{
+				return;
+			}
+		}
+		try
+		{
+			if (have_full)
+			{
+				flush(full);
+			}
+			else
+			{
+				map_next_chunk();
+			}
+		}
+		catch (...)
+		{
+			m_failed = true;
+			std::lock_guard lock(m_mutex);
+			m_error = std::current_exception();
+		}
+		m_cv.notify_all();
+	}
+}
+
+void TrajectoryRecorder::map_next_chunk()
+{
+	const std::size_t index	 = m_next_chunk;
+	const auto		  offset = static_cast<off_t>(k_header_bytes + index * m_layout.chunk_bytes);
+	// Reserving the blocks up front turns a full disk into an error here instead of a SIGBUS in record()
+	if (::posix_fallocate(m_fd, offset, static_cast<off_t>(m_layout.chunk_bytes)) != 0)
+	{
+		throw std::runtime_error(std::format("Could not preallocate trajectory chunk {}", index));
+	}
+	void* data = ::mmap(nullptr, m_layout.chunk_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error(std::format("Could not map trajectory chunk {}", index));
+	}
+	m_next_chunk++;
+	std::lock_guard lock(m_mutex);
+	m_ready.push_back({static_cast<std::byte*>(data), index, 0});
+}
+
+void TrajectoryRecorder::flush(const Chunk& chunk)
+{
+	// After a failed chunk the header keeps the prefix before it, later chunks would leave a gap in the count
+	if (m_failed)
+	{
+		::munmap(chunk.data, m_layout.chunk_bytes);
+		return;
+	}
+	const bool synced = ::msync(chunk.data, m_layout.chunk_bytes, MS_SYNC) == 0;
+	::munmap(chunk.data, m_layout.chunk_bytes);
+	if (!synced)
+	{
+		throw std::runtime_error(std::format("Could not write trajectory chunk {}", chunk.index));
+	}
+	// Chunks are flushed in order, so the header only ever counts complete prefixes
+	m_flushed_steps += chunk.steps;
+	auto* header = reinterpret_cast<TrajectoryHeader*>(m_header);
+	std::atomic_ref(header->num_steps).store(m_flushed_steps, std::memory_order_release);
+	if (::msync(m_header, k_header_bytes, MS_SYNC) != 0)
+	{
+		throw std::runtime_error("Could not write the trajectory header");
+	}
+}
+
+void TrajectoryRecorder::acquire_chunk()
+{
+	{
+		std::unique_lock lock(m_mutex);
+		if (m_ready.empty())
+		{
+			m_num_stalls++;
+			m_cv.wait(lock, [&] { return !m_ready.empty() || m_error; });
+		}
+		rethrow_error();
+		m_current = m_ready.front();
+		m_ready.pop_front();
+	}
+	m_cv.notify_all();
+}
+
+void TrajectoryRecorder::record(const TrajectoryRow& row)
+{
+	if (m_closed)
+	{
+		throw std::runtime_error("Trajectory recording is already closed");
+	}
+	if (m_current.data == nullptr)
+	{
+		acquire_chunk();
+	}
+	const std::size_t envs	= m_layout.num_envs;
+	const std::size_t first = m_current.steps * envs;
+	auto*			  chunk = m_current.data;
+	const auto column = [&](std::size_t offset, std::size_t width) {
+		return reinterpret_cast<float*>(chunk + offset) + first * width;
+	};
+	std::memcpy(column(m_layout.observations, m_layout.obs_size), row.observations,
+				envs * m_layout.obs_size * sizeof(float));
+	std::memcpy(column(m_layout.logprobs, 1), row.logprobs, envs * sizeof(float));
+	std::memcpy(column(m_layout.values, 1), row.values, envs * sizeof(float));
+	std::memcpy(column(m_layout.rewards, 1), row.rewards, envs * sizeof(float));
+	auto* actions = reinterpret_cast<std::int32_t*>(chunk + m_layout.actions) + first;
+	auto* dones	  = reinterpret_cast<std::uint8_t*>(chunk + m_layout.dones) + first;
+	for (std::size_t i = 0; i < envs; i++)
+	{
+		actions[i] = static_cast<std::int32_t>(row.actions[i]);
+		dones[i]   = row.dones[i] != 0.0f;
+	}
+	if (m_layout.has_positions)
+	{
+		std::memcpy(column(m_layout.positions, 4), row.positions, envs * 4 * sizeof(float));
+	}
+	m_current.steps++;
+	m_num_steps++;
+
+	if (m_current.steps == m_layout.steps_per_chunk)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_full.push_back(std::exchange(m_current, {}));
+			rethrow_error();
+		}
+		m_cv.notify_all();
+	}
+}
+
+void TrajectoryRecorder::close()
+{
+	if (m_closed)
+	{
+		return;
+	}
+	m_closed = true;
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_current.data != nullptr)
+		{
+			m_full.push_back(std::exchange(m_current, {}));
+		}
+		m_closing = true;
+	}
+	m_cv.notify_all();
+	m_thread.join();
+	finish();
+	std::lock_guard lock(m_mutex);
+	rethrow_error();
+}
+
+void TrajectoryRecorder::finish()
+{
+	for (const auto& chunk : m_ready)
+	{
+		::munmap(chunk.data, m_layout.chunk_bytes);
+	}
+	m_ready.clear();
+	// Drop the chunks that were preallocated but never written
+	const std::size_t used_chunks = (m_flushed_steps + m_layout.steps_per_chunk - 1) / m_layout.steps_per_chunk;
+	const auto		  used_bytes  = static_cast<off_t>(k_header_bytes + used_chunks * m_layout.chunk_bytes);
+	const bool		  trimmed	  = ::ftruncate(m_fd, used_bytes) == 0;
+	const bool		  synced	  = ::fsync(m_fd) == 0;
+	::munmap(m_header, k_header_bytes);
+	::close(m_fd);
+	m_fd = -1;
+	if ((!trimmed || !synced) && !m_error)
+	{
+		m_error = std::make_exception_ptr(std::runtime_error("Could not finish the trajectory file"));
+	}
+}
+
+void TrajectoryRecorder::rethrow_error()
+{
+	if (m_error)
+	{
+		std::rethrow_exception(std::exchange(m_error, nullptr));
+	}
+}
+
+std::size_t TrajectoryRecorder::get_num_steps() const
+{
+	return m_num_steps;
+}
+
+std::size_t TrajectoryRecorder::get_num_envs() const
+{
+	return m_layout.num_envs;
+}
+
+std::size_t TrajectoryRecorder::get_observation_size() const
+{
+	return m_layout.obs_size;
+}
+
+bool TrajectoryRecorder::has_positions() const
+{
+	return m_layout.has_positions;
+}
+
+std::size_t TrajectoryRecorder::get_num_stalls() const
+{
+	return m_num_stalls;
+}
+
+TrajectoryReader::TrajectoryReader(const std::filesystem::path& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		throw std::runtime_error(std::format("Could not open trajectory {}", path.string()));
+	}
+	struct stat st{};
+	if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < k_header_bytes)
+	{
+		::close(fd);
+		throw std::runtime_error(std::format("{} is not a trajectory", path.string()));
+	}
+	m_size	   = static_cast<std::size_t>(st.st_size);
+	void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error(std::format("Could not map trajectory {}", path.string()));
+	}
+	m_mapping = static_cast<const std::byte*>(data);
+
+	const auto fail = [&](std::string_view reason) {
+		::munmap(const_cast<std::byte*>(m_mapping), m_size);
+		throw std::runtime_error(std::format("Invalid trajectory {}: {}", path.string(), reason));
+	};
+
+	TrajectoryHeader header{};
+	std::memcpy(&header, m_mapping, sizeof(header));
+	if (std::memcmp(header.magic, k_magic, sizeof(k_magic)) != 0)
+	{
+		fail("bad magic");
+	}
+	if (header.version != TrajectoryRecorder::k_version)
+	{
+		fail(std::format("version {} but this build reads version {}", header.version, TrajectoryRecorder::k_version));
+	}
+	if (header.num_envs == 0 || header.obs_size == 0 || header.steps_per_chunk == 0)
+	{
+		fail("empty dimensions");
+	}
+	m_layout = TrajectoryLayout(header.num_envs, header.obs_size, header.steps_per_chunk,
+								(header.flags & k_flag_positions) != 0);
+	if (m_layout.chunk_bytes != header.chunk_bytes)
+	{
+		fail(std::format("chunks of {} bytes but the layout needs {}", header.chunk_bytes, m_layout.chunk_bytes));
+	}
+	m_num_steps = header.num_steps;
+	if (k_header_bytes + get_num_chunks() * m_layout.chunk_bytes > m_size)
+	{
+		fail("truncated");
+	}
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+	::munmap(const_cast<std::byte*>(m_mapping), m_size);
+}
+
+const std::byte* TrajectoryReader::chunk_data(std::size_t index) const
+{
+	return m_mapping + k_header_bytes + index * m_layout.chunk_bytes;
+}
+
+TrajectorySlice TrajectoryReader::step(std::size_t step) const
+{
+	if (step >= m_num_steps)
+	{
+		throw std::invalid_argument(std::format("Step {} of a trajectory with {} steps", step, m_num_steps));
+	}
+	const auto chunk = step / m_layout.steps_per_chunk;
+	return m_layout.slice(chunk_data(chunk), step, step % m_layout.steps_per_chunk, 1);
+}
+
+std::vector<TrajectorySlice> TrajectoryReader::slice(std::size_t first_step, std::size_t count) const
+{
+	if (first_step + count > m_num_steps)
+	{
+		throw std::invalid_argument(std::format("Steps [{}, {}) of a trajectory with {} steps", first_step,
+												first_step + count, m_num_steps));
+	}
+	std::vector<TrajectorySlice> slices;
+	for (std::size_t step = first_step; step < first_step + count;)
+	{
+		const auto chunk = step / m_layout.steps_per_chunk;
+		const auto row	 = step % m_layout.steps_per_chunk;
+		const auto steps = std::min(m_layout.steps_per_chunk - row, first_step + count - step);
+		slices.push_back(m_layout.slice(chunk_data(chunk), step, row, steps));
+		step += steps;
+	}
+	return slices;
+}
+
+TrajectorySlice TrajectoryReader::chunk(std::size_t index) const
+{
+	if (index >= get_num_chunks())
+	{
+		throw std::invalid_argument(std::format("Chunk {} of a trajectory with {} chunks", index, get_num_chunks()));
+	}
+	const auto first_step = index * m_layout.steps_per_chunk;
+	const auto steps	  = std::min(m_layout.steps_per_chunk, m_num_steps - first_step);
+	return m_layout.slice(chunk_data(index), first_step, 0, steps);
+}
+
+void TrajectoryReader::prefetch(std::size_t first_step, std::size_t count) const
+{
+	if (count == 0 || first_step >= m_num_steps)
+	{
+		return;
+	}
+	const auto first_chunk = first_step / m_layout.steps_per_chunk;
+	const auto last_chunk  = (std::min(first_step + count, m_num_steps) - 1) / m_layout.steps_per_chunk;
+	::madvise(const_cast<std::byte*>(chunk_data(first_chunk)), (last_chunk - first_chunk + 1) * m_layout.chunk_bytes,
+			  MADV_WILLNEED);
+}
+
+void TrajectoryReader::write_snapshot(std::size_t step, SwarmSnapshot& snapshot) const
+{
+	if (!m_layout.has_positions)
+	{
+		throw std::invalid_argument("The trajectory was recorded without positions");
+	}
+	const auto positions = this->step(step).positions;
+	snapshot.agents.reserve(snapshot.agents.size() + m_layout.num_envs);
+	snapshot.goals.reserve(snapshot.goals.size() + m_layout.num_envs);
+	for (std::size_t i = 0; i < m_layout.num_envs; i++)
+	{
+		snapshot.agents.push_back({positions[4 * i], positions[4 * i + 1]});
+		snapshot.goals.push_back({positions[4 * i + 2], positions[4 * i + 3]});
+	}
+	snapshot.tick = step;
+}
+
+std::size_t TrajectoryReader::get_num_steps() const
+{
+	return m_num_steps;
+}
+
+std::size_t TrajectoryReader::get_num_chunks() const
+{
+	return (m_num_steps + m_layout.steps_per_chunk - 1) / m_layout.steps_per_chunk;
+}
+
+std::size_t TrajectoryReader::get_num_envs() const
+{
+	return m_layout.num_envs;
+}
+
+std::size_t TrajectoryReader::get_observation_size() const
+{
+	return m_layout.obs_size;
+}
+
+bool TrajectoryReader::has_positions() const
+{
+	return m_layout.has_positions;
+}
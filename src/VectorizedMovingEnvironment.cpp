@@ -0,0 +1,243 @@
+//
+// Created by chris on 10/17/26.
+//
+#include <swarm/VectorizedMovingEnvironment.hpp>
+#include <swarm/Checkpoint.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <algorithm>
+#include <array>
+
+// Same world as SimpleMovingEnvironment
+static constexpr float k_world_width	= 1920.0f;
+static constexpr float k_world_height	= 1080.0f;
+static constexpr float k_speed			= 30.0f;
+static constexpr float k_goal_radius	= 10.0f;
+static constexpr float k_terminal_bonus = 10.0f;
+
+VectorizedMovingEnvironment::VectorizedMovingEnvironment(std::size_t num_envs)
+	: position_x(num_envs)
+	, position_y(num_envs)
+	, velocity_x(num_envs)
+	, velocity_y(num_envs)
+	, goal_x(num_envs)
+	, goal_y(num_envs)
+	, last_distance(num_envs)
+	, episodes(num_envs)
+	, rng_counter(num_envs)
+{
+	if (num_envs == 0)
+	{
+		throw std::invalid_argument("VectorizedMovingEnvironment needs at least one env");
+	}
+}
+
+void VectorizedMovingEnvironment::write_observations(float* out) const
+{
+	// Divisions like SimpleMovingEnvironment, a reciprocal would round differently and break the bit for bit match
+	const float		  max_dist = std::sqrt(k_world_width * k_world_width + k_world_height * k_world_height);
+	const std::size_t n		   = get_num_envs();
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const float dx	  = goal_x[i] - position_x[i];
+		const float dy	  = goal_y[i] - position_y[i];
+		const float dist  = std::sqrt(dx * dx + dy * dy);
+		// Position basically at goal, define a safe direction
+		const bool	valid = dist > 1e-6f;
+		const float safe  = valid ? dist : 1.0f;
+
+		float* row = out + i * 5;
+		row[0]	   = velocity_x[i];
+		row[1]	   = velocity_y[i];
+		row[2]	   = valid ? dx / safe : 0.0f;
+		row[3]	   = valid ? dy / safe : 0.0f;
+		row[4]	   = valid ? dist / max_dist : 0.0f;
+	}
+}
+
+torch::Tensor VectorizedMovingEnvironment::get_current_observation() const
+{
+	auto observations = torch::empty({static_cast<long>(get_num_envs()), 5}, torch::kFloat32);
+	write_observations(observations.data_ptr<float>());
+	return observations;
+}
+
+Environment::StepResult VectorizedMovingEnvironment::step(const torch::Tensor& action)
+{
+	return step_buffered(action);
+}
+
+void VectorizedMovingEnvironment::step_into(const StepBuffers& buffers)
+{
+	check_buffers(buffers);
+	const std::size_t n	  = get_num_envs();
+	const auto*		  act = buffers.actions.data();
+	for (std::size_t i = 0; i < n; i++)
+	{
+		if (act[i] < 0 || act[i] > 3)
+		{
+			throw std::invalid_argument(std::format("Unexpected action_val={}", act[i]));
+		}
+	}
+	float* reward_out = buffers.rewards.data();
+	float* done_out	  = buffers.dones.data();
+
+	// 0: Right, 1: Left, 2: Down, 3: Up. Selects instead of a switch keep the loop branch free.
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const auto a	 = act[i];
+		velocity_x[i]	 = k_speed * (static_cast<float>(a == 0) - static_cast<float>(a == 1));
+		velocity_y[i]	 = k_speed * (static_cast<float>(a == 2) - static_cast<float>(a == 3));
+		position_x[i]	+= velocity_x[i];
+		position_y[i]	+= velocity_y[i];
+
+		const float dx		 = goal_x[i] - position_x[i];
+		const float dy		 = goal_y[i] - position_y[i];
+		const float new_dist = std::sqrt(dx * dx + dy * dy);
+		const float done	 = static_cast<float>(new_dist < k_goal_radius);
+
+		reward_out[i]	 = last_distance[i] - new_dist + done * k_terminal_bonus;
+		done_out[i]		 = done;
+		last_distance[i] = new_dist;
+	}
+
+	// Episodes end rarely, keep the resets out of the hot loop
+	for (std::size_t i = 0; i < n; i++)
+	{
+		episodes.step(i, reward_out[i], done_out[i] != 0.0f);
+		if (done_out[i] != 0.0f)
+		{
+			reset_env(i);
+		}
+	}
+
+	write_observations(buffers.observations.data());
+}
+
+std::size_t VectorizedMovingEnvironment::get_observation_size() const
+{
+	return 5; // Vel, Direction, Dist
+}
+std::size_t VectorizedMovingEnvironment::get_action_space_size() const
+{
+	return 4; // Right Left Up Down
+}
+std::size_t VectorizedMovingEnvironment::get_num_envs() const
+{
+	return position_x.size();
+}
+
+void VectorizedMovingEnvironment::reset_env(std::size_t i)
+{
+	// Six consecutive words of env i's stream, the ones SimpleMovingEnvironment's Philox hands out in the same order.
+	// rng_counter counts words, a reset can start in the middle of a block.
+	std::array<std::uint32_t, 6> words{};
+	std::uint64_t				 word  = rng_counter[i];
+	auto						 block = philox4x32(word / 4, rng_stream + i, rng_key);
+	for (auto& out : words)
+	{
+		if (word % 4 == 0 && word != rng_counter[i])
+		{
+			block = philox4x32(word / 4, rng_stream + i, rng_key);
+		}
+		out = block[word % 4];
+		word++;
+	}
+	rng_counter[i] = word;
+
+	// Same expressions as Philox::uniform(low, high)
+	position_x[i] = 0.0f + k_world_width * philox_uniform(words[0]);
+	position_y[i] = 0.0f + k_world_height * philox_uniform(words[1]);
+	velocity_x[i] = -k_speed + 2.0f * k_speed * philox_uniform(words[2]);
+	velocity_y[i] = -k_speed + 2.0f * k_speed * philox_uniform(words[3]);
+	goal_x[i]	  = 0.0f + k_world_width * philox_uniform(words[4]);
+	goal_y[i]	  = 0.0f + k_world_height * philox_uniform(words[5]);
+
+	const float dx	 = goal_x[i] - position_x[i];
+	const float dy	 = goal_y[i] - position_y[i];
+	last_distance[i] = std::sqrt(dx * dx + dy * dy);
+}
+
+void VectorizedMovingEnvironment::reset_all()
+{
+	for (std::size_t i = 0; i < get_num_envs(); i++)
+	{
+		episodes.reset_env(i);
+		reset_env(i);
+	}
+}
+
+torch::Tensor VectorizedMovingEnvironment::reset()
+{
+	reset_all();
+	return get_current_observation();
+}
+
+void VectorizedMovingEnvironment::reset_into(std::span<float> observations)
+{
+	check_observations(observations);
+	reset_all();
+	write_observations(observations.data());
+}
+
+void VectorizedMovingEnvironment::seed(std::uint64_t seed, std::uint64_t first_stream)
+{
+	rng_key	   = seed;
+	rng_stream = first_stream;
+	std::fill(rng_counter.begin(), rng_counter.end(), 0);
+}
+EpisodeStats VectorizedMovingEnvironment::take_episode_stats()
+{
+	return episodes.take();
+}
+bool VectorizedMovingEnvironment::save_state(torch::serialize::OutputArchive& archive) const
+{
+	write_floats(archive, "position_x", position_x);
+	write_floats(archive, "position_y", position_y);
+	write_floats(archive, "velocity_x", velocity_x);
+	write_floats(archive, "velocity_y", velocity_y);
+	write_floats(archive, "goal_x", goal_x);
+	write_floats(archive, "goal_y", goal_y);
+	write_floats(archive, "last_distance", last_distance);
+	write_counters(archive, "rng_counter", rng_counter);
+	write_counters(archive, "rng", {rng_key, rng_stream});
+	return true;
+}
+void VectorizedMovingEnvironment::load_state(torch::serialize::InputArchive& archive)
+{
+	read_floats(archive, "position_x", position_x);
+	read_floats(archive, "position_y", position_y);
+	read_floats(archive, "velocity_x", velocity_x);
+	read_floats(archive, "velocity_y", velocity_y);
+	read_floats(archive, "goal_x", goal_x);
+	read_floats(archive, "goal_y", goal_y);
+	read_floats(archive, "last_distance", last_distance);
+	read_counters(archive, "rng_counter", rng_counter);
+	std::vector<std::uint64_t> rng(2);
+	read_counters(archive, "rng", rng);
+	rng_key	   = rng[0];
+	rng_stream = rng[1];
+}
+
+void VectorizedMovingEnvironment::write_snapshot(SwarmSnapshot& snapshot) const
+{
+	snapshot.agents.reserve(snapshot.agents.size() + position_x.size());
+	snapshot.goals.reserve(snapshot.goals.size() + goal_x.size());
+	for (std::size_t i = 0; i < position_x.size(); i++)
+	{
+		snapshot.agents.push_back({position_x[i], position_y[i]});
+		snapshot.goals.push_back({goal_x[i], goal_y[i]});
+	}
+}
+
+void VectorizedMovingEnvironment::set_goal(sf::Vector2f goal)
+{
+	std::ranges::fill(goal_x, goal.x);
+	std::ranges::fill(goal_y, goal.y);
+}
+
+std::unique_ptr<Environment> VectorizedMovingEnvironment::clone() const
+{
+	auto copy = std::make_unique<VectorizedMovingEnvironment>(*this);
+	copy->rng_key = std::random_device{}(); // Clones must not replay our episodes
+	return copy;
+}
@@ -4,7 +4,13 @@
 #include <swarm/common.hpp>
 #include <swarm/Agent.hpp>
 #include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/SimulationThread.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/Sweep.hpp>
+#include <swarm/Trajectory.hpp>
+#include <string_view>
 #include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
 
 template<class T>
 std::ostream& operator<<(std::ostream& os, sf::Vector2<T> vec)
@@ -12,21 +18,99 @@ std::ostream& operator<<(std::ostream& os, sf::Vector2<T> vec)
 	return os << '{' << vec.x << ", " << vec.y << '}';
 }
 
-int main()
+// Plays a recording back at steps_per_second, Up and Down double and halve the speed. Returns the exit code.
+static int replay(const std::filesystem::path& path, double steps_per_second)
 {
-	auto env = std::make_unique<SimpleMovingEnvironment>();
+	TrajectoryReader trajectory{path};
+	if (!trajectory.has_positions())
+	{
+		std::cerr << path << " was recorded without positions, there is nothing to replay\n";
+		return 1;
+	}
+	std::cout << "Replaying " << trajectory.get_num_steps() << " steps of " << trajectory.get_num_envs()
+			  << " envs from " << path << '\n';
+	SwarmRenderer	 renderer;
+	SwarmSnapshot	 snapshot;
+	double			 position = 0.0;
+	std::size_t		 shown	  = trajectory.get_num_steps();
+	sf::Clock		 clock;
+	sf::RenderWindow window{sf::VideoMode::getDesktopMode(), "Replay", sf::Style::Default, sf::State::Fullscreen};
+	window.setVerticalSyncEnabled(true);
+	while (window.isOpen() && trajectory.get_num_steps() > 0)
+	{
+		while (auto event = window.pollEvent())
+		{
+			if (event->is<sf::Event::Closed>()) window.close();
+			if (auto key = event->getIf<sf::Event::KeyPressed>())
+			{
+				if (key->code == sf::Keyboard::Key::Up) steps_per_second *= 2.0;
+				if (key->code == sf::Keyboard::Key::Down) steps_per_second /= 2.0;
+			}
+		}
+		position += clock.restart().asSeconds() * steps_per_second;
+		const auto step = static_cast<std::size_t>(position) % trajectory.get_num_steps();
+		if (step != shown)
+		{
+			shown = step;
+			snapshot.clear();
+			trajectory.write_snapshot(step, snapshot);
+			renderer.update(snapshot);
+			trajectory.prefetch(step + 1, static_cast<std::size_t>(steps_per_second) + 1);
+		}
+		window.clear();
+		window.draw(renderer);
+		window.display();
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	// swarm --replay <trajectory> [steps per second]
+	if (argc >= 3 && std::string_view(argv[1]) == "--replay")
+	{
+		return replay(argv[2], argc >= 4 ? std::stod(argv[3]) : 10.0);
+	}
+
+	// swarm --sweep <out dir> [cores per run], before anything touches libtorch's thread pools
+	if (argc >= 3 && std::string_view(argv[1]) == "--sweep")
+	{
+		SweepSpec spec;
+		spec.grid = {{"learning_rate", {1e-4, 2.5e-4, 1e-3}}, {"clip_coef", {0.1, 0.2, 0.3}}};
+		SweepOptions options;
+		options.out_dir		  = argv[2];
+		options.cores_per_run = argc >= 4 ? std::stoul(argv[3]) : 2;
+		run_sweep(TrainingConfig{}, spec,
+				  [](const TrainingConfig& config) {
+					  return std::make_unique<VectorizedMovingEnvironment>(static_cast<std::size_t>(config.num_envs));
+				  },
+				  options);
+		std::cout << "Results written to " << options.out_dir / "results.csv" << '\n';
+		return 0;
+	}
+
+	TrainingConfig config{};
+	auto env = std::make_unique<VectorizedMovingEnvironment>(config.num_envs);
 	Agent agent{env.get()};
-	train(agent, std::move(env));
+	train(agent, std::move(env), config);
 	std::cout << "Done Training\n";
+	agent.export_frozen("agent.policy");
+	std::cout << "Exported policy to agent.policy\n";
 
 
 	agent.to(torch::kCPU);
 	auto render_env = std::make_unique<SimpleMovingEnvironment>();
-	render_env->reset();
+	auto observation = render_env->reset();
 	render_env->toggle_log();
 	std::cout << "Reset Environment\nGoal: " << render_env->goal << "\nStarting Pos: " << render_env->position
 	<< "\nStarting Vel: " << render_env->velocity << '\n';
+	SimulationThread simulation{std::move(render_env), observation,
+								[&agent](const torch::Tensor& observation) { return agent.act_greedy(observation); },
+								std::chrono::milliseconds{500}};
+	SwarmRenderer	 renderer;
+
 	sf::RenderWindow window{sf::VideoMode::getDesktopMode(), "Agent", sf::Style::Default, sf::State::Fullscreen};
+	window.setVerticalSyncEnabled(true);
 	while (window.isOpen())
 	{
 		while (auto event = window.pollEvent())
@@ -36,15 +120,18 @@ int main()
 			{
 				auto press_i = press->position;
 				sf::Vector2f new_pos(press_i.x, press_i.y);
-				render_env->set_goal(new_pos);
-				std::cout << "Set Goal to: " << new_pos << '\n';
+				if (simulation.set_goal(new_pos))
+				{
+					std::cout << "Set Goal to: " << new_pos << '\n';
+				}
 			}
 		}
+		if (simulation.poll_snapshot())
+		{
+			renderer.update(simulation.snapshot());
+		}
 		window.clear();
-		window.draw(*render_env);
+		window.draw(renderer);
 		window.display();
-		auto action = agent.act_greedy(render_env->get_current_observation());
-		render_env->step(action);
-		std::this_thread::sleep_for(std::chrono::milliseconds{500});
 	}
 }
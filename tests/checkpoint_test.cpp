@@ -0,0 +1,198 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Checkpoint.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+
+static torch::Tensor rollout_observations(Environment& env, int steps)
+{
+	torch::manual_seed(0);
+	std::vector<torch::Tensor> observations;
+	for (int step = 0; step < steps; step++)
+	{
+		auto action = torch::randint(0, 4, {static_cast<long>(env.get_num_envs())}, torch::kLong);
+		observations.push_back(env.step(action).observations);
+	}
+	return torch::stack(observations);
+}
+
+static void round_trip(const Environment& source, Environment& target)
+{
+	torch::serialize::OutputArchive output;
+	REQUIRE(source.save_state(output));
+	std::stringstream stream;
+	output.save_to(stream);
+	torch::serialize::InputArchive input;
+	input.load_from(stream);
+	target.load_state(input);
+}
+
+SCENARIO("Environments continue identically after a state round trip", "[checkpoint]")
+{
+	GIVEN("A MultiEnv and a VectorizedMovingEnvironment stepped for a while")
+	{
+		MultiEnv					multi(std::make_unique<SimpleMovingEnvironment>(), 7);
+		VectorizedMovingEnvironment vectorized(7);
+		multi.seed(3);
+		vectorized.seed(3);
+		multi.reset();
+		vectorized.reset();
+		rollout_observations(multi, 50);
+		rollout_observations(vectorized, 50);
+
+		WHEN("their state is loaded into freshly seeded copies")
+		{
+			MultiEnv					multi_copy(std::make_unique<SimpleMovingEnvironment>(), 7);
+			VectorizedMovingEnvironment vectorized_copy(7);
+			multi_copy.seed(99);
+			vectorized_copy.seed(99);
+			multi_copy.reset();
+			vectorized_copy.reset();
+			round_trip(multi, multi_copy);
+			round_trip(vectorized, vectorized_copy);
+
+			THEN("the copies produce the same trajectories, resets included")
+			{
+				REQUIRE(torch::equal(rollout_observations(multi, 300), rollout_observations(multi_copy, 300)));
+				REQUIRE(torch::equal(rollout_observations(vectorized, 300),
+									 rollout_observations(vectorized_copy, 300)));
+			}
+		}
+	}
+}
+
+SCENARIO("CheckpointWriter replaces the checkpoint atomically", "[checkpoint]")
+{
+	GIVEN("A writer and a few submitted snapshots")
+	{
+		const auto path = std::filesystem::temp_directory_path() / "swarm_checkpoint_test.pt";
+		std::filesystem::remove(path);
+		CheckpointWriter writer(path);
+		for (long i = 1; i <= 5; i++)
+		{
+			auto snapshot = torch::full({3}, static_cast<float>(i));
+			writer.submit([snapshot](torch::serialize::OutputArchive& archive) { archive.write("value", snapshot); });
+		}
+
+		WHEN("the writer is drained")
+		{
+			writer.wait();
+
+			THEN("the last snapshot is on disk and no temporary file is left")
+			{
+				REQUIRE(writer.get_num_written() >= 1);
+				torch::serialize::InputArchive archive;
+				archive.load_from(path.string());
+				torch::Tensor value;
+				archive.read("value", value);
+				REQUIRE(torch::equal(value, torch::full({3}, 5.0f)));
+				for (const auto& entry : std::filesystem::directory_iterator(path.parent_path()))
+				{
+					REQUIRE(entry.path().filename().string().find("swarm_checkpoint_test.pt.") == std::string::npos);
+				}
+			}
+		}
+
+		WHEN("a job fails")
+		{
+			writer.submit([](torch::serialize::OutputArchive&) { throw std::runtime_error("disk full"); });
+
+			THEN("the error surfaces on the training thread")
+			{
+				REQUIRE_THROWS_AS(writer.wait(), std::runtime_error);
+			}
+		}
+		std::filesystem::remove(path);
+	}
+}
+
+// Trains a fresh agent on 4 vectorized envs for num_updates updates of 4 x 16 steps, checkpointing at the end
+static void train_to_checkpoint(Agent& agent, long num_updates, long checkpoint_interval,
+								const std::filesystem::path& checkpoint_path, bool resume)
+{
+	TrainingConfig config;
+	config.num_steps		   = 16;
+	config.num_envs			   = 4;
+	config.total_timesteps	   = num_updates * config.num_steps * config.num_envs;
+	config.num_minibatches	   = 2;
+	config.update_epochs	   = 2;
+	config.seed				   = 5;
+	config.device			   = torch::kCPU;
+	config.checkpoint_interval = checkpoint_interval;
+	config.checkpoint_path	   = checkpoint_path;
+	config.resume			   = resume;
+	train(agent, std::make_unique<VectorizedMovingEnvironment>(4), config);
+}
+
+// The Adam state of a checkpoint as [step, exp_avg, exp_avg_sq] per parameter
+static std::vector<torch::Tensor> optimizer_state(const std::filesystem::path& checkpoint_path)
+{
+	VectorizedMovingEnvironment env(4);
+	Agent						agent{&env};
+	torch::optim::Adam			optimizer(agent.parameters(), torch::optim::AdamOptions(1e-3));
+	torch::serialize::InputArchive archive;
+	archive.load_from(checkpoint_path.string());
+	torch::serialize::InputArchive optimizer_archive;
+	archive.read("optimizer", optimizer_archive);
+	optimizer.load(optimizer_archive);
+
+	std::vector<torch::Tensor> state;
+	for (const auto& param : agent.parameters())
+	{
+		const auto& adam =
+			static_cast<const torch::optim::AdamParamState&>(*optimizer.state().at(param.unsafeGetTensorImpl()));
+		state.push_back(torch::tensor(adam.step(), torch::kInt64));
+		state.push_back(adam.exp_avg());
+		state.push_back(adam.exp_avg_sq());
+	}
+	return state;
+}
+
+SCENARIO("A resumed run ends where the uninterrupted run ends", "[checkpoint]")
+{
+	GIVEN("One run of 4 updates and one of 2 updates, checkpointed and resumed for the other 2")
+	{
+		const auto straight_path = std::filesystem::temp_directory_path() / "swarm_resume_test_straight.pt";
+		const auto resumed_path	 = std::filesystem::temp_directory_path() / "swarm_resume_test_resumed.pt";
+		std::filesystem::remove(resumed_path);
+
+		// Both runs start from the same initial parameters, the resumed one takes them from the checkpoint
+		VectorizedMovingEnvironment env(4);
+		torch::manual_seed(1);
+		Agent straight{&env};
+		train_to_checkpoint(straight, 4, 4, straight_path, false);
+		torch::manual_seed(1);
+		Agent first_half{&env};
+		train_to_checkpoint(first_half, 2, 2, resumed_path, false);
+		Agent second_half{&env};
+		train_to_checkpoint(second_half, 4, 2, resumed_path, true);
+
+		THEN("the parameters are identical")
+		{
+			const auto expected = straight.parameters();
+			const auto actual	= second_half.parameters();
+			REQUIRE(expected.size() == actual.size());
+			for (std::size_t i = 0; i < expected.size(); i++)
+			{
+				REQUIRE(torch::equal(expected[i], actual[i]));
+			}
+		}
+
+		THEN("the optimizer state is identical")
+		{
+			const auto expected = optimizer_state(straight_path);
+			const auto actual	= optimizer_state(resumed_path);
+			REQUIRE(expected.size() == actual.size());
+			for (std::size_t i = 0; i < expected.size(); i++)
+			{
+				REQUIRE(torch::equal(expected[i], actual[i]));
+			}
+		}
+		std::filesystem::remove(straight_path);
+		std::filesystem::remove(resumed_path);
+	}
+}
@@ -0,0 +1,140 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/RolloutStorage.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+
+// Only implements the tensor API, so step_into() and reset_into() go through Environment's adapter
+struct TensorOnlyEnvironment : Environment
+{
+	SimpleMovingEnvironment inner;
+
+	StepResult	  step(const torch::Tensor& action) override { return inner.step(action); }
+	std::size_t	  get_observation_size() const override { return inner.get_observation_size(); }
+	std::size_t	  get_action_space_size() const override { return inner.get_action_space_size(); }
+	torch::Tensor reset() override { return inner.reset(); }
+	void		  seed(std::uint64_t seed, std::uint64_t first_stream) override { inner.seed(seed, first_stream); }
+	std::unique_ptr<Environment> clone() const override { return std::make_unique<TensorOnlyEnvironment>(*this); }
+};
+
+// Mostly greedy moves towards the goal (dx, dy are observation columns 2 and 3), so episodes end and envs reset
+static torch::Tensor towards_goal(const torch::Tensor& observations)
+{
+	const auto dx		  = observations.select(1, 2);
+	const auto dy		  = observations.select(1, 3);
+	const auto horizontal = torch::where(dx > 0, torch::zeros_like(dx), torch::ones_like(dx));
+	const auto vertical	  = torch::where(dy > 0, torch::full_like(dy, 2), torch::full_like(dy, 3));
+	const auto greedy	  = torch::where(dx.abs() >= dy.abs(), horizontal, vertical).to(torch::kLong);
+	const auto explore	  = torch::rand({dx.size(0)}) < 0.25;
+	return torch::where(explore, torch::randint(0, 4, {dx.size(0)}, torch::kLong), greedy);
+}
+
+// Steps env with the same actions through step() and its twin through step_into(), true when all results match
+static bool step_and_step_into_agree(Environment& env, Environment& twin, int steps)
+{
+	const auto n   = static_cast<long>(env.get_num_envs());
+	const auto obs = static_cast<long>(env.get_observation_size());
+	auto	   observations = torch::empty({n, obs});
+	auto	   rewards		= torch::empty({n});
+	auto	   dones		= torch::empty({n});
+	auto	   last			= env.reset().reshape({n, obs});
+	bool	   identical	= torch::equal(last, twin.reset().reshape({n, obs}));
+	torch::manual_seed(0);
+	for (int step = 0; step < steps; step++)
+	{
+		auto action	  = towards_goal(last).contiguous();
+		auto expected = env.step(action);
+		twin.step_into({{action.data_ptr<int64_t>(), static_cast<std::size_t>(n)},
+						{observations.data_ptr<float>(), static_cast<std::size_t>(n * obs)},
+						{rewards.data_ptr<float>(), static_cast<std::size_t>(n)},
+						{dones.data_ptr<float>(), static_cast<std::size_t>(n)}});
+		last	  = expected.observations.reshape({n, obs});
+		identical = identical && torch::equal(last, observations) && torch::equal(expected.reward.reshape({n}), rewards)
+				 && torch::equal(expected.done.reshape({n}), dones);
+	}
+	return identical;
+}
+
+SCENARIO("step_into writes what step returns", "[env]")
+{
+	GIVEN("A MultiEnv of SimpleMovingEnvironments and a VectorizedMovingEnvironment seeded identically")
+	{
+		// VectorizedMovingEnvironment::step() goes through its own step_into(), the scalar envs are the reference
+		MultiEnv					reference(std::make_unique<SimpleMovingEnvironment>(), 17);
+		VectorizedMovingEnvironment vectorized(17);
+		reference.seed(5);
+		vectorized.seed(5);
+
+		THEN("the vectorized step_into reproduces the scalar envs step for step, resets included")
+		{
+			REQUIRE(step_and_step_into_agree(reference, vectorized, 2000));
+			const auto episodes = reference.take_episode_stats().episodes;
+			REQUIRE(episodes > 0);
+			REQUIRE(vectorized.take_episode_stats().episodes == episodes);
+		}
+	}
+
+	GIVEN("A MultiEnv of native envs and one of envs that only implement step()")
+	{
+		MultiEnv native(std::make_unique<SimpleMovingEnvironment>(), 9);
+		MultiEnv adapted(std::make_unique<TensorOnlyEnvironment>(), 9);
+		native.seed(8);
+		adapted.seed(8);
+
+		THEN("the adapter gives the same results as the native step_into")
+		{
+			REQUIRE(step_and_step_into_agree(native, adapted, 500));
+		}
+	}
+
+	GIVEN("Buffers of the wrong size")
+	{
+		VectorizedMovingEnvironment env(4);
+		env.reset();
+		std::vector<std::int64_t>	actions(4);
+		std::vector<float>			observations(4 * 5);
+		std::vector<float>			rewards(3);
+		std::vector<float>			dones(4);
+
+		THEN("step_into throws")
+		{
+			REQUIRE_THROWS_AS(env.step_into({actions, observations, rewards, dones}), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("RolloutStorage hands out rows to step into", "[rollout]")
+{
+	GIVEN("A float32 and a bf16 storage on the CPU")
+	{
+		RolloutStorage full(4, 3, 5, 4, torch::kFloat32, torch::kFloat32, torch::kCPU);
+		RolloutStorage narrow(4, 3, 5, 4, torch::kBFloat16, torch::kFloat32, torch::kCPU);
+
+		WHEN("an env writes into the rows of step 2")
+		{
+			auto row = full.observation_row(2);
+			for (std::size_t i = 0; i < row.size(); i++)
+			{
+				row[i] = static_cast<float>(i);
+			}
+			full.reward_row(2)[1] = 7.0f;
+
+			THEN("the storage reads back what was written")
+			{
+				REQUIRE(row.size() == 15);
+				REQUIRE(torch::equal(full.observations()[2], torch::arange(15, torch::kFloat32).view({3, 5})));
+				REQUIRE(full.rewards()[2][1].item<float>() == 7.0f);
+			}
+		}
+
+		THEN("the bf16 storage has no observation rows, only reward rows")
+		{
+			REQUIRE(narrow.observation_row(0).empty());
+			REQUIRE(narrow.reward_row(0).size() == 3);
+		}
+	}
+}
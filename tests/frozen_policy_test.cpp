@@ -0,0 +1,98 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Agent.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <fstream>
+
+// The little endian word at offset of a policy file
+static std::uint64_t read_u64(const std::filesystem::path& path, std::streamoff offset)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::uint64_t value = 0;
+	file.seekg(offset);
+	file.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+static void write_u64(const std::filesystem::path& path, std::streamoff offset, std::uint64_t value)
+{
+	std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+	file.seekp(offset);
+	file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+SCENARIO("Frozen policies reproduce Agent::act_greedy", "[inference]")
+{
+	GIVEN("An agent exported to a frozen policy file")
+	{
+		torch::manual_seed(5);
+		SimpleMovingEnvironment env;
+		Agent					agent{&env};
+		const auto				path = std::filesystem::temp_directory_path() / "swarm_frozen_policy_test.policy";
+		agent.export_frozen(path);
+
+		WHEN("it is loaded")
+		{
+			FrozenPolicy policy(path);
+
+			THEN("its shapes match the agent")
+			{
+				REQUIRE(policy.get_observation_size() == env.get_observation_size());
+				REQUIRE(policy.get_action_space_size() == env.get_action_space_size());
+				REQUIRE(policy.get_num_layers() == 3);
+			}
+
+			THEN("greedy actions match the torch path")
+			{
+				torch::NoGradGuard nograd;
+				constexpr long	   batch = 512;
+				auto			   obs	 = torch::randn({batch, 5});
+				auto			   actions = torch::empty({batch}, torch::kLong);
+				policy.act_greedy(obs.data_ptr<float>(), batch, actions.data_ptr<int64_t>());
+				REQUIRE(torch::equal(actions, agent.act_greedy(obs)));
+			}
+		}
+
+		WHEN("the file is corrupted")
+		{
+			{
+				std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+				file.put('X');
+			}
+
+			THEN("loading it throws")
+			{
+				REQUIRE_THROWS_AS(FrozenPolicy(path), std::runtime_error);
+			}
+		}
+
+		WHEN("an offset in it wraps around when the size of what it points at is added")
+		{
+			// The layer table offset is at byte 32 of the header, the first layer's weight offset at byte 16 of its
+			// record. Both are kept aligned so only the bounds checks can catch them.
+			const auto table_offset = static_cast<std::streamoff>(read_u64(path, 32));
+
+			THEN("loading it throws instead of reading through the wrapped pointer")
+			{
+				write_u64(path, table_offset + 16, ~std::uint64_t{63});
+				REQUIRE_THROWS_AS(FrozenPolicy(path), std::runtime_error);
+				write_u64(path, 32, ~std::uint64_t{31});
+				REQUIRE_THROWS_AS(FrozenPolicy(path), std::runtime_error);
+			}
+		}
+
+		WHEN("the layer table offset is inside the file but misaligned")
+		{
+			write_u64(path, 32, read_u64(path, 32) + 4);
+
+			THEN("loading it throws")
+			{
+				REQUIRE_THROWS_AS(FrozenPolicy(path), std::runtime_error);
+			}
+		}
+		std::filesystem::remove(path);
+	}
+}
@@ -0,0 +1,115 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Agent.hpp>
+#include <swarm/DenseKernels.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+
+SCENARIO("FusedActorCritic matches the torch Agent", "[inference]")
+{
+	GIVEN("An agent, its fused kernel and a batch of observations")
+	{
+		torch::manual_seed(7);
+		SimpleMovingEnvironment env;
+		Agent					agent{&env};
+		auto					fused = agent.make_fused();
+		constexpr long			batch = 257;
+		auto					obs	  = torch::randn({batch, 5});
+
+		torch::NoGradGuard		nograd;
+
+		WHEN("actions are sampled")
+		{
+			auto actions  = torch::empty({batch}, torch::kLong);
+			auto log_prob = torch::empty({batch});
+			auto value	  = torch::empty({batch});
+			fused.act(obs.data_ptr<float>(), batch, actions.data_ptr<int64_t>(), log_prob.data_ptr<float>(),
+					  value.data_ptr<float>());
+			auto expected = agent.get_action_and_value(obs, actions);
+
+			THEN("values and log-probs agree with the torch path")
+			{
+				INFO(dense_kernel_isa());
+				REQUIRE(torch::allclose(value, expected.value.view(-1), 1e-4, 1e-5));
+				REQUIRE(torch::allclose(log_prob, expected.log_prob, 1e-4, 1e-5));
+			}
+		}
+
+		WHEN("actions are picked greedily")
+		{
+			auto actions = torch::empty({batch}, torch::kLong);
+			fused.act_greedy(obs.data_ptr<float>(), batch, actions.data_ptr<int64_t>());
+
+			THEN("they are the argmax of the torch policy")
+			{
+				REQUIRE(torch::equal(actions, agent.act_greedy(obs)));
+			}
+		}
+
+		WHEN("the agent is updated and the kernel refreshed")
+		{
+			for (auto& param : agent.parameters())
+			{
+				param.add_(torch::randn_like(param) * 0.1);
+			}
+			agent.pack_into(fused);
+			auto value = torch::empty({batch});
+			auto dummy = torch::empty({batch});
+			auto acts  = torch::empty({batch}, torch::kLong);
+			fused.act(obs.data_ptr<float>(), batch, acts.data_ptr<int64_t>(), dummy.data_ptr<float>(),
+					  value.data_ptr<float>());
+
+			THEN("it follows the new parameters")
+			{
+				REQUIRE(torch::allclose(value, agent.get_value(obs).view(-1), 1e-4, 1e-5));
+			}
+		}
+	}
+
+	GIVEN("A fixed seed")
+	{
+		SimpleMovingEnvironment env;
+		Agent					agent{&env};
+		auto					first  = agent.make_fused();
+		auto					second = agent.make_fused();
+		first.seed(11);
+		second.seed(11);
+		auto obs = torch::randn({64, 5});
+		auto a	 = torch::empty({64}, torch::kLong);
+		auto b	 = torch::empty({64}, torch::kLong);
+		auto lp	 = torch::empty({64});
+		auto v	 = torch::empty({64});
+		first.act(obs.data_ptr<float>(), 64, a.data_ptr<int64_t>(), lp.data_ptr<float>(), v.data_ptr<float>());
+		second.act(obs.data_ptr<float>(), 64, b.data_ptr<int64_t>(), lp.data_ptr<float>(), v.data_ptr<float>());
+
+		THEN("sampling is reproducible")
+		{
+			REQUIRE(torch::equal(a, b));
+		}
+	}
+
+	GIVEN("The kernel and the agent on the same sampling stream")
+	{
+		SimpleMovingEnvironment env;
+		Agent					agent{&env};
+		auto					fused = agent.make_fused();
+		fused.seed(21);
+		Philox sampler(21, k_sampling_stream);
+		auto   obs	   = torch::randn({256, 5});
+		auto   actions = torch::empty({256}, torch::kLong);
+		auto   lp	   = torch::empty({256});
+		auto   v	   = torch::empty({256});
+		fused.act(obs.data_ptr<float>(), 256, actions.data_ptr<int64_t>(), lp.data_ptr<float>(), v.data_ptr<float>());
+		auto uniform = torch::empty({256});
+		sampler.fill_uniform(uniform.data_ptr<float>(), 256, 0.0f, 1.0f);
+		torch::NoGradGuard nograd;
+		auto			   res = agent.sample_action_and_value(obs, uniform);
+
+		THEN("they sample the same actions up to rounding at the CDF boundaries")
+		{
+			REQUIRE((res.action != actions).sum().item<long>() <= 2);
+		}
+	}
+}
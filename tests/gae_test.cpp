@@ -0,0 +1,69 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Gae.hpp>
+
+// Per-timestep tensor loop train() used before compute_gae
+static torch::Tensor reference_advantages(const torch::Tensor& rewards, const torch::Tensor& values,
+										  const torch::Tensor& dones, const torch::Tensor& next_value,
+										  const torch::Tensor& next_done, float gamma, float gae_lambda)
+{
+	const long num_steps  = rewards.size(0);
+	auto	   advantages = torch::zeros_like(rewards);
+	auto	   lastgaelam = torch::zeros({rewards.size(1)});
+	for (long t = num_steps - 1; t >= 0; t--)
+	{
+		auto nextnonterminal = t == num_steps - 1 ? 1.0 - next_done : 1.0 - dones[t + 1];
+		auto nextvalues		 = t == num_steps - 1 ? next_value.squeeze(0) : values[t + 1];
+		auto delta			 = rewards[t] + gamma * nextvalues * nextnonterminal - values[t];
+		advantages[t] = lastgaelam = delta + gamma * gae_lambda * nextnonterminal * lastgaelam;
+	}
+	return advantages;
+}
+
+SCENARIO("compute_gae matches the per-timestep tensor loop", "[gae]")
+{
+	GIVEN("A rollout with episode ends in the middle and at the bootstrap step")
+	{
+		torch::manual_seed(3);
+		constexpr long num_steps  = 64;
+		constexpr long num_envs	  = 9;
+		auto		   rewards	  = torch::randn({num_steps, num_envs});
+		auto		   values	  = torch::randn({num_steps, num_envs});
+		auto		   dones	  = (torch::rand({num_steps, num_envs}) < 0.1).to(torch::kFloat32);
+		auto		   next_value = torch::randn({1, num_envs});
+		auto		   next_done  = (torch::rand({num_envs}) < 0.5).to(torch::kFloat32);
+
+		WHEN("advantages and returns are computed")
+		{
+			auto res	  = compute_gae(rewards, values, dones, next_value, next_done, 0.99f, 0.95f);
+			auto expected = reference_advantages(rewards, values, dones, next_value, next_done, 0.99f, 0.95f);
+
+			THEN("they agree with the reference")
+			{
+				REQUIRE(torch::allclose(res.advantages, expected, 1e-5, 1e-5));
+				REQUIRE(torch::allclose(res.returns, expected + values, 1e-5, 1e-5));
+			}
+		}
+
+		WHEN("an input does not match the rewards")
+		{
+			THEN("compute_gae throws instead of reading past its buffers")
+			{
+				const auto short_values = values.narrow(0, 0, num_steps - 1);
+				const auto short_bootstrap = next_value.narrow(1, 0, num_envs - 1);
+				const auto integer_dones = dones.to(torch::kLong);
+				REQUIRE_THROWS_AS(compute_gae(rewards, short_values, dones, next_value, next_done, 0.99f, 0.95f),
+								  std::invalid_argument);
+				REQUIRE_THROWS_AS(compute_gae(rewards, values, dones.t(), next_value, next_done, 0.99f, 0.95f),
+								  std::invalid_argument);
+				REQUIRE_THROWS_AS(compute_gae(rewards, values, dones, short_bootstrap, next_done, 0.99f, 0.95f),
+								  std::invalid_argument);
+				REQUIRE_THROWS_AS(compute_gae(rewards, values, integer_dones, next_value, next_done, 0.99f, 0.95f),
+								  std::invalid_argument);
+			}
+		}
+	}
+}
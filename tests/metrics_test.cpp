@@ -0,0 +1,99 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Metrics.hpp>
+#include <fstream>
+#include <string>
+
+SCENARIO("SpscRing hands values from one thread to another in order", "[metrics]")
+{
+	GIVEN("A small ring and a producer pushing more values than it holds")
+	{
+		SpscRing<long> ring(5);
+		REQUIRE(ring.capacity() == 8);
+		constexpr long count = 100000;
+
+		WHEN("a consumer drains it concurrently")
+		{
+			std::jthread producer([&] {
+				for (long i = 0; i < count; i++)
+				{
+					while (!ring.try_push(i))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+			long expected = 0;
+			long value	  = 0;
+			while (expected < count)
+			{
+				if (ring.try_pop(value))
+				{
+					REQUIRE(value == expected);
+					expected++;
+				}
+			}
+
+			THEN("every value arrived once and the ring is empty")
+			{
+				REQUIRE_FALSE(ring.try_pop(value));
+			}
+		}
+	}
+}
+
+SCENARIO("MetricsWriter writes every pushed record before it is destroyed", "[metrics]")
+{
+	GIVEN("A CSV and a JSON lines writer")
+	{
+		const auto dir	 = std::filesystem::temp_directory_path();
+		const auto csv	 = dir / "swarm_metrics_test.csv";
+		const auto jsonl = dir / "swarm_metrics_test.jsonl";
+
+		WHEN("records are pushed")
+		{
+			{
+				MetricsWriter csv_writer(csv);
+				MetricsWriter json_writer(jsonl);
+				for (long update = 0; update < 20; update++)
+				{
+					MetricsRecord record;
+					record.update  = update;
+					record.pg_loss = 0.5;
+					REQUIRE(csv_writer.push(record));
+					REQUIRE(json_writer.push(record));
+				}
+			}
+
+			THEN("the files hold a header plus one row per record")
+			{
+				std::ifstream csv_in(csv);
+				std::string	  line;
+				std::getline(csv_in, line);
+				REQUIRE(line.starts_with("update,global_step,"));
+				long rows = 0;
+				while (std::getline(csv_in, line))
+				{
+					REQUIRE(line.starts_with(std::to_string(rows) + ","));
+					rows++;
+				}
+				REQUIRE(rows == 20);
+
+				std::ifstream json_in(jsonl);
+				rows = 0;
+				while (std::getline(json_in, line))
+				{
+					REQUIRE(line.starts_with("{\"update\":" + std::to_string(rows) + ","));
+					REQUIRE(line.find("\"pg_loss\":0.5") != std::string::npos);
+					rows++;
+				}
+				REQUIRE(rows == 20);
+			}
+			std::filesystem::remove(csv);
+			std::filesystem::remove(jsonl);
+		}
+	}
+}
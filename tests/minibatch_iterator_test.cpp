@@ -0,0 +1,164 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/MinibatchIterator.hpp>
+
+SCENARIO("MinibatchIterator serves every transition once per epoch with its fields aligned", "[minibatch]")
+{
+	GIVEN("A bf16 rollout storage whose fields all encode the transition index")
+	{
+		Philox		   rng(11, k_shuffle_stream);
+		constexpr long num_steps = 10;
+		constexpr long num_envs	 = 10;
+		constexpr long batch	 = num_steps * num_envs;
+		constexpr long obs_size	 = 5;
+		constexpr long epochs	 = 3;
+		RolloutStorage storage(num_steps, num_envs, obs_size, batch, torch::kBFloat16, torch::kBFloat16, torch::kCPU);
+		auto		   index = torch::arange(batch, torch::kFloat32).view({num_steps, num_envs});
+		for (long step = 0; step < num_steps; step++)
+		{
+			storage.store(step, index[step].unsqueeze(1).repeat({1, obs_size}), index[step].to(torch::kLong),
+						  index[step] + 0.25, torch::zeros({num_envs}), torch::zeros({num_envs}), index[step]);
+		}
+		const auto flat = index.view({batch});
+		MinibatchIterator batches(storage, torch::arange(batch, torch::kLong), flat + 0.5, flat + 0.75, -flat, 32,
+								  epochs, rng);
+
+		WHEN("all epochs are iterated")
+		{
+			long served_epochs = 0;
+			while (batches.next_epoch())
+			{
+				std::vector<torch::Tensor> seen;
+				for (long i = 0; i < batches.num_minibatches(); i++)
+				{
+					auto mb = batches.minibatch(i);
+					auto id = mb.actions.to(torch::kFloat32);
+					REQUIRE(torch::equal(mb.observations, id.unsqueeze(1).repeat({1, obs_size})));
+					REQUIRE(torch::equal(mb.logprobs, id + 0.25));
+					REQUIRE(torch::equal(mb.advantages, id + 0.5));
+					REQUIRE(torch::equal(mb.returns, id + 0.75));
+					REQUIRE(torch::equal(mb.values, -id));
+					seen.push_back(mb.actions);
+				}
+				auto [sorted, _] = torch::cat(seen).sort();
+				REQUIRE(torch::equal(sorted, torch::arange(batch, torch::kLong)));
+				served_epochs++;
+			}
+
+			THEN("the iterator stops after the configured number of epochs")
+			{
+				REQUIRE(served_epochs == epochs);
+				REQUIRE(batches.num_minibatches() == 4);
+				REQUIRE_FALSE(batches.next_epoch());
+			}
+		}
+	}
+}
+
+SCENARIO("MinibatchIterator shuffles reproducibly from its Philox stream", "[minibatch]")
+{
+	GIVEN("Two iterators over the same batch with equally seeded streams")
+	{
+		RolloutStorage storage(8, 8, 3, 64, torch::kFloat32, torch::kFloat32, torch::kCPU);
+		for (long step = 0; step < 8; step++)
+		{
+			storage.store(step, torch::randn({8, 3}), torch::arange(step * 8, step * 8 + 8, torch::kLong),
+						  torch::randn({8}), torch::randn({8}), torch::zeros({8}), torch::randn({8}));
+		}
+		auto			  rows = torch::arange(64, torch::kLong);
+		auto			  col  = rows.to(torch::kFloat32);
+		Philox			  first_rng(3, k_shuffle_stream);
+		Philox			  second_rng(3, k_shuffle_stream);
+		MinibatchIterator first(storage, rows, col, col, col, 16, 2, first_rng);
+		MinibatchIterator second(storage, rows, col, col, col, 16, 2, second_rng);
+
+		WHEN("both serve their epochs")
+		{
+			bool identical = true;
+			while (first.next_epoch() && second.next_epoch())
+			{
+				for (long i = 0; i < first.num_minibatches(); i++)
+				{
+					identical = identical && torch::equal(first.minibatch(i).actions, second.minibatch(i).actions);
+				}
+			}
+
+			THEN("the permutations are identical")
+			{
+				REQUIRE(identical);
+			}
+		}
+	}
+}
+
+SCENARIO("MinibatchIterator serves only the storage rows it was given", "[minibatch]")
+{
+	GIVEN("The second half of the env columns of a storage, as one policy of a population owns them")
+	{
+		Philox		   rng(5, k_shuffle_stream);
+		RolloutStorage storage(4, 8, 2, 32, torch::kHalf, torch::kFloat32, torch::kCPU);
+		for (long step = 0; step < 4; step++)
+		{
+			const auto id = torch::arange(step * 8, step * 8 + 8, torch::kLong);
+			storage.store(step, id.to(torch::kFloat32).unsqueeze(1).repeat({1, 2}), id, torch::zeros({8}),
+						  torch::zeros({8}), torch::zeros({8}), torch::zeros({8}));
+		}
+		const auto rows = torch::arange(32, torch::kLong).view({4, 8}).narrow(1, 4, 4).reshape({16});
+		const auto col	= rows.to(torch::kFloat32);
+		MinibatchIterator batches(storage, rows, col, col, col, 4, 1, rng);
+
+		WHEN("its epoch is iterated")
+		{
+			REQUIRE(batches.next_epoch());
+			std::vector<torch::Tensor> seen;
+			for (long i = 0; i < batches.num_minibatches(); i++)
+			{
+				auto mb = batches.minibatch(i);
+				REQUIRE(torch::equal(mb.advantages, mb.actions.to(torch::kFloat32)));
+				REQUIRE(torch::equal(mb.observations.select(1, 0), mb.actions.to(torch::kFloat32)));
+				seen.push_back(mb.actions);
+			}
+
+			THEN("exactly those rows were gathered from the storage")
+			{
+				auto [sorted, _] = torch::cat(seen).sort();
+				REQUIRE(torch::equal(sorted, rows));
+			}
+		}
+	}
+}
+
+SCENARIO("MinibatchIterator slices its epoch instead of gathering per minibatch", "[minibatch]")
+{
+	GIVEN("A float32 storage, whose columns need no widening")
+	{
+		Philox		   rng(7, k_shuffle_stream);
+		RolloutStorage storage(4, 8, 3, 4, torch::kFloat32, torch::kFloat32, torch::kCPU);
+		for (long step = 0; step < 4; step++)
+		{
+			storage.store(step, torch::randn({8, 3}), torch::zeros({8}, torch::kLong), torch::randn({8}),
+						  torch::zeros({8}), torch::zeros({8}), torch::zeros({8}));
+		}
+		const auto		  col = torch::zeros({32});
+		MinibatchIterator batches(storage, torch::arange(32, torch::kLong), col, col, col, 8, 1, rng);
+		REQUIRE(batches.next_epoch());
+
+		WHEN("two minibatches of the epoch are taken")
+		{
+			const auto first  = batches.minibatch(0);
+			const auto second = batches.minibatch(1);
+
+			THEN("they are adjacent views of one shuffled buffer")
+			{
+				REQUIRE(first.observations.is_alias_of(second.observations));
+				REQUIRE(first.logprobs.is_alias_of(second.logprobs));
+				REQUIRE(second.observations.data_ptr<float>() == first.observations.data_ptr<float>() + 8 * 3);
+				REQUIRE(second.logprobs.data_ptr<float>() == first.logprobs.data_ptr<float>() + 8);
+				REQUIRE_FALSE(first.observations.is_alias_of(storage.observations()));
+			}
+		}
+	}
+}
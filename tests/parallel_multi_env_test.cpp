@@ -0,0 +1,68 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/ParallelMultiEnv.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+
+SCENARIO("ParallelMultiEnv matches the serial MultiEnv", "[env]")
+{
+	GIVEN("A serial and a parallel MultiEnv seeded identically")
+	{
+		constexpr std::size_t num_envs = 13;
+		MultiEnv			  serial(std::make_unique<SimpleMovingEnvironment>(), num_envs);
+		ParallelMultiEnv	  parallel(std::make_unique<SimpleMovingEnvironment>(), num_envs, 4);
+		serial.seed(42);
+		parallel.seed(42);
+
+		WHEN("they are reset")
+		{
+			THEN("the observations are identical")
+			{
+				REQUIRE(torch::equal(serial.reset(), parallel.reset()));
+			}
+		}
+
+		WHEN("they are stepped with the same actions")
+		{
+			serial.reset();
+			parallel.reset();
+			torch::manual_seed(0);
+			bool identical = true;
+			for (int step = 0; step < 500; step++)
+			{
+				auto action	  = torch::randint(0, 4, {static_cast<long>(num_envs)}, torch::kLong);
+				auto expected = serial.step(action);
+				auto actual	  = parallel.step(action);
+				identical	  = identical && torch::equal(expected.observations, actual.observations)
+						  && torch::equal(expected.reward, actual.reward) && torch::equal(expected.done, actual.done);
+			}
+			THEN("observations, rewards and dones are identical")
+			{
+				REQUIRE(identical);
+			}
+		}
+	}
+
+	GIVEN("More workers than envs")
+	{
+		ParallelMultiEnv parallel(std::make_unique<SimpleMovingEnvironment>(), 3, 16);
+
+		THEN("the pool is clamped to one worker per env")
+		{
+			REQUIRE(parallel.get_num_workers() == 3);
+		}
+	}
+
+	GIVEN("An invalid action")
+	{
+		ParallelMultiEnv parallel(std::make_unique<SimpleMovingEnvironment>(), 4, 2);
+		parallel.reset();
+
+		THEN("the worker's exception reaches the caller")
+		{
+			REQUIRE_THROWS_AS(parallel.step(torch::full({4}, 7, torch::kLong)), std::invalid_argument);
+		}
+	}
+}
@@ -0,0 +1,150 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Philox.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+
+SCENARIO("Philox4x32-10 matches the Random123 known answers", "[rng]")
+{
+	GIVEN("The reference counters and keys")
+	{
+		THEN("the blocks are the published ones")
+		{
+			REQUIRE(philox4x32(0, 0, 0) == std::array<std::uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+			REQUIRE(philox4x32(~0ULL, ~0ULL, ~0ULL)
+					== std::array<std::uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+			REQUIRE(philox4x32(0x85a308d3243f6a88ULL, 0x0370734413198a2eULL, 0x299f31d0a4093822ULL)
+					== std::array<std::uint32_t, 4>{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+		}
+	}
+}
+
+SCENARIO("Philox streams are reproducible and resumable", "[rng]")
+{
+	GIVEN("Two generators on the same key and stream")
+	{
+		Philox first(42, 7);
+		Philox second(42, 7);
+		first();
+
+		WHEN("one fills a batch and the other draws one by one")
+		{
+			second();
+			std::vector<float> batch(13);
+			first.fill_uniform(batch.data(), batch.size(), -2.0f, 2.0f);
+			bool identical = true;
+			for (float value : batch)
+			{
+				identical = identical && value == second.uniform(-2.0f, 2.0f) && value >= -2.0f && value < 2.0f;
+			}
+
+			THEN("they produce the same numbers")
+			{
+				REQUIRE(identical);
+			}
+		}
+
+		WHEN("the state is saved mid block and restored into a fresh generator")
+		{
+			const auto state = first.get_state();
+			Philox	   restored;
+			restored.set_state(state);
+
+			THEN("it continues the stream")
+			{
+				for (int i = 0; i < 9; i++)
+				{
+					REQUIRE(restored() == first());
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Seeded envs reset from independent per-env streams", "[rng]")
+{
+	GIVEN("A MultiEnv and a VectorizedMovingEnvironment seeded twice with the same seed")
+	{
+		MultiEnv					multi(std::make_unique<SimpleMovingEnvironment>(), 4);
+		VectorizedMovingEnvironment vectorized(4);
+		multi.seed(9);
+		vectorized.seed(9);
+		auto multi_first	  = multi.reset();
+		auto vectorized_first = vectorized.reset();
+		multi.seed(9);
+		vectorized.seed(9);
+
+		THEN("resets repeat bit for bit and every env starts somewhere else")
+		{
+			REQUIRE(torch::equal(multi.reset(), multi_first));
+			REQUIRE(torch::equal(vectorized.reset(), vectorized_first));
+			REQUIRE_FALSE(torch::equal(vectorized_first[0], vectorized_first[1]));
+		}
+	}
+
+	GIVEN("A single env seeded on the stream of env 2")
+	{
+		SimpleMovingEnvironment env;
+		env.seed(9, 2);
+		MultiEnv multi(std::make_unique<SimpleMovingEnvironment>(), 4);
+		multi.seed(9);
+
+		THEN("it resets exactly like env 2 of the batch")
+		{
+			REQUIRE(torch::equal(env.reset(), multi.reset()[2]));
+		}
+	}
+}
+
+// Heads for the goal along the axis it is farthest from, a quarter of the moves random so no env gets stuck circling
+// its goal. Episodes end and envs reset mid-run.
+static torch::Tensor head_for_goal(const torch::Tensor& observations)
+{
+	const auto dx		  = observations.select(1, 2);
+	const auto dy		  = observations.select(1, 3);
+	const auto horizontal = torch::where(dx > 0, torch::zeros_like(dx), torch::ones_like(dx));
+	const auto vertical	  = torch::where(dy > 0, torch::full_like(dy, 2), torch::full_like(dy, 3));
+	const auto greedy	  = torch::where(dx.abs() >= dy.abs(), horizontal, vertical).to(torch::kLong);
+	const auto explore	  = torch::rand({dx.size(0)}) < 0.25;
+	return torch::where(explore, torch::randint(0, 4, {dx.size(0)}, torch::kLong), greedy);
+}
+
+SCENARIO("A VectorizedMovingEnvironment replays a MultiEnv of SimpleMovingEnvironments", "[rng]")
+{
+	GIVEN("Both seeded with the same seed")
+	{
+		constexpr std::size_t		num_envs = 16;
+		MultiEnv					multi(std::make_unique<SimpleMovingEnvironment>(), num_envs);
+		VectorizedMovingEnvironment vectorized(num_envs);
+		multi.seed(21);
+		vectorized.seed(21);
+		torch::manual_seed(4);
+
+		WHEN("they are reset and driven with the same actions")
+		{
+			auto observations = multi.reset();
+			bool identical	  = torch::equal(vectorized.reset(), observations);
+			for (int step = 0; step < 2000 && identical; step++)
+			{
+				const auto action	= head_for_goal(observations);
+				const auto expected = multi.step(action);
+				const auto result	= vectorized.step(action);
+				identical			= torch::equal(result.observations, expected.observations)
+						 && torch::equal(result.reward, expected.reward) && torch::equal(result.done, expected.done);
+				observations = expected.observations;
+			}
+
+			THEN("every observation, reward and done matches, resets included")
+			{
+				REQUIRE(identical);
+				const auto multi_stats = multi.take_episode_stats();
+				REQUIRE(multi_stats.episodes > 0);
+				REQUIRE(vectorized.take_episode_stats().episodes == multi_stats.episodes);
+			}
+		}
+	}
+}
@@ -0,0 +1,184 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/PolicyServer.hpp>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+// Action = index of the largest of three observation values, counts the rows it was called on
+static PolicyServer::BatchPolicy argmax_policy(std::atomic<std::size_t>& rows)
+{
+	return [&rows](const float* observations, std::size_t batch, std::int64_t* actions) {
+		for (std::size_t i = 0; i < batch; i++)
+		{
+			const float* row = observations + i * 3;
+			actions[i]		 = std::max_element(row, row + 3) - row;
+		}
+		rows += batch;
+	};
+}
+
+SCENARIO("A PolicyServer answers every client with its own action", "[inference]")
+{
+	GIVEN("A server and eight client threads submitting observations")
+	{
+		std::atomic<std::size_t> rows{0};
+		PolicyServer			 server(argmax_policy(rows), 3, {.max_batch_size = 16});
+		std::atomic<bool>		 correct{true};
+
+		WHEN("every client submits 200 requests one after the other")
+		{
+			{
+				std::vector<std::jthread> clients;
+				for (int client = 0; client < 8; client++)
+				{
+					clients.emplace_back([&, client] {
+						for (int i = 0; i < 200; i++)
+						{
+							const auto expected	   = static_cast<std::int64_t>((client + i) % 3);
+							float	   observation[3] = {0.0f, 0.0f, 0.0f};
+							observation[expected]	  = 1.0f;
+							if (server.submit(observation).get() != expected)
+							{
+								correct = false;
+							}
+						}
+					});
+				}
+			}
+			const auto stats = server.take_stats();
+
+			THEN("each got the action of its observation and the stats count every request")
+			{
+				REQUIRE(correct);
+				REQUIRE(rows == 1600);
+				REQUIRE(stats.requests == 1600);
+				std::uint64_t histogram_requests = 0;
+				for (std::size_t size = 0; size < stats.batch_sizes.size(); size++)
+				{
+					histogram_requests += size * stats.batch_sizes[size];
+				}
+				REQUIRE(histogram_requests == 1600);
+				REQUIRE(stats.p50_latency_us <= stats.p99_latency_us);
+				REQUIRE(stats.p99_latency_us <= stats.max_latency_us);
+				REQUIRE(server.take_stats().requests == 0);
+			}
+		}
+	}
+}
+
+SCENARIO("A PolicyServer batches queued requests", "[inference]")
+{
+	GIVEN("A server that waits up to a second for a batch of four")
+	{
+		std::atomic<std::size_t> rows{0};
+		PolicyServer server(argmax_policy(rows), 3, {.max_batch_size = 4, .max_delay = std::chrono::seconds{1}});
+
+		WHEN("four requests are submitted")
+		{
+			const float observation[3] = {0.0f, 1.0f, 0.0f};
+			std::vector<std::future<std::int64_t>> futures;
+			for (int i = 0; i < 4; i++)
+			{
+				futures.push_back(server.submit(observation));
+			}
+			for (auto& future : futures)
+			{
+				future.get();
+			}
+
+			THEN("they are served as one batch long before the delay ran out")
+			{
+				const auto stats = server.take_stats();
+				REQUIRE(stats.batches == 1);
+				REQUIRE(stats.batch_sizes[4] == 1);
+				REQUIRE(stats.max_latency_us < 500000.0);
+			}
+		}
+	}
+
+	GIVEN("A server with a short delay")
+	{
+		std::atomic<std::size_t> rows{0};
+		PolicyServer server(argmax_policy(rows), 3, {.max_batch_size = 64, .max_delay = std::chrono::milliseconds{2}});
+
+		WHEN("a single request is submitted")
+		{
+			const float observation[3] = {0.0f, 0.0f, 1.0f};
+			const auto	action		   = server.submit(observation).get();
+
+			THEN("it is served alone once the delay ran out")
+			{
+				const auto stats = server.take_stats();
+				REQUIRE(action == 2);
+				REQUIRE(stats.batch_sizes[1] == 1);
+				REQUIRE(stats.p50_latency_us >= 2000.0);
+			}
+		}
+	}
+}
+
+SCENARIO("A PolicyServer reports errors to the clients", "[inference]")
+{
+	GIVEN("A server whose policy throws")
+	{
+		PolicyServer server([](const float*, std::size_t, std::int64_t*) { throw std::runtime_error("policy failed"); },
+							3, {.max_batch_size = 8, .max_delay = std::chrono::microseconds{100}});
+		const float observation[3] = {};
+
+		THEN("the future rethrows the policy's exception")
+		{
+			REQUIRE_THROWS_AS(server.submit(observation).get(), std::runtime_error);
+		}
+		THEN("observations of the wrong size are rejected right away")
+		{
+			const float wrong[2] = {};
+			REQUIRE_THROWS_AS(server.submit(wrong), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("LatencyHistogram estimates percentiles in fixed memory", "[inference]")
+{
+	GIVEN("A million latencies from 0.5 us to 10 s")
+	{
+		LatencyHistogram histogram;
+		for (int i = 0; i < 1000000; i++)
+		{
+			histogram.record(0.5 + 10.0 * i);
+		}
+
+		THEN("every percentile is at most one sub-bucket above the exact one")
+		{
+			REQUIRE(histogram.count() == 1000000);
+			REQUIRE(histogram.max() == 0.5 + 10.0 * 999999);
+			for (const double p : {0.01, 0.5, 0.9, 0.99, 0.999})
+			{
+				const double exact	   = 0.5 + 10.0 * (std::ceil(p * 1000000) - 1);
+				const double estimated = histogram.percentile(p);
+				INFO(p);
+				REQUIRE(estimated >= exact);
+				REQUIRE(estimated <= exact * (1.0 + 1.0 / LatencyHistogram::k_sub_buckets));
+			}
+			REQUIRE(histogram.percentile(1.0) == histogram.max());
+		}
+	}
+
+	GIVEN("An empty histogram and one with a single sub-microsecond latency")
+	{
+		LatencyHistogram empty;
+		LatencyHistogram single;
+		single.record(0.3);
+
+		THEN("the empty one reports zeros and the single latency is its own percentile")
+		{
+			REQUIRE(empty.count() == 0);
+			REQUIRE(empty.percentile(0.5) == 0.0);
+			REQUIRE(single.percentile(0.5) == 0.3);
+			REQUIRE(single.percentile(0.99) == 0.3);
+		}
+	}
+}
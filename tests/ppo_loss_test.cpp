@@ -0,0 +1,66 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/PpoLoss.hpp>
+
+struct LossGradients
+{
+	PpoLossResult result;
+	torch::Tensor newlogprob;
+	torch::Tensor entropy;
+	torch::Tensor newvalue;
+};
+
+template <typename LossFn>
+static LossGradients run_loss(LossFn loss_fn, const PpoLossInputs& base)
+{
+	PpoLossInputs in = base;
+	in.newlogprob	 = base.newlogprob.clone().requires_grad_(true);
+	in.entropy		 = base.entropy.clone().requires_grad_(true);
+	in.newvalue		 = base.newvalue.clone().requires_grad_(true);
+	auto result		 = loss_fn(in, 0.2f, 0.5f, 0.01f);
+	result.loss.backward();
+	return {result, in.newlogprob.grad(), in.entropy.grad(), in.newvalue.grad()};
+}
+
+SCENARIO("fused_ppo_loss matches the composed PPO loss", "[ppo_loss]")
+{
+	GIVEN("A minibatch where some ratios and values are clipped")
+	{
+		torch::manual_seed(5);
+		constexpr long batch = 257;
+		PpoLossInputs  base{
+			 torch::randn({batch}) * 0.2 - 1.0,
+			 torch::rand({batch}),
+			 torch::randn({batch}),
+			 torch::randn({batch}) * 0.2 - 1.0,
+			 torch::randn({batch}) * 3.0 + 1.0,
+			 torch::randn({batch}),
+			 torch::randn({batch}),
+		 };
+
+		WHEN("both losses are evaluated and back-propagated")
+		{
+			auto composed = run_loss(ppo_loss, base);
+			auto fused	  = run_loss(fused_ppo_loss, base);
+
+			THEN("the losses and diagnostics agree")
+			{
+				REQUIRE(torch::allclose(fused.result.loss, composed.result.loss, 1e-4, 1e-5));
+				REQUIRE(torch::allclose(fused.result.pg_loss, composed.result.pg_loss, 1e-4, 1e-5));
+				REQUIRE(torch::allclose(fused.result.v_loss, composed.result.v_loss, 1e-4, 1e-5));
+				REQUIRE(torch::allclose(fused.result.entropy_loss, composed.result.entropy_loss, 1e-4, 1e-5));
+				REQUIRE(torch::allclose(fused.result.approx_kl, composed.result.approx_kl, 1e-4, 1e-5));
+				REQUIRE(torch::allclose(fused.result.clipfrac, composed.result.clipfrac));
+			}
+			THEN("the gradients agree")
+			{
+				REQUIRE(torch::allclose(fused.newlogprob, composed.newlogprob, 1e-4, 1e-6));
+				REQUIRE(torch::allclose(fused.entropy, composed.entropy, 1e-4, 1e-6));
+				REQUIRE(torch::allclose(fused.newvalue, composed.newvalue, 1e-4, 1e-6));
+			}
+		}
+	}
+}
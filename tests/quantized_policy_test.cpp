@@ -0,0 +1,158 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Agent.hpp>
+#include <swarm/DenseKernels.hpp>
+#include <swarm/QuantizedPolicy.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <random>
+
+SCENARIO("The int8 kernel computes exact dot products", "[inference]")
+{
+	GIVEN("Random unsigned inputs and packed signed weights of awkward widths")
+	{
+		std::mt19937 rng(3);
+		bool		 exact = true;
+		for (const std::size_t in : {4, 8, 68})
+		{
+			for (const std::size_t cols : {1, 7, 16, 24, 80, 100})
+			{
+				std::vector<std::uint8_t> x(in);
+				std::vector<std::int8_t>  w(in * cols);
+				std::vector<std::int32_t> acc(cols);
+				for (auto& value : x)
+				{
+					value = static_cast<std::uint8_t>(rng() % 256);
+				}
+				for (auto& value : w)
+				{
+					value = static_cast<std::int8_t>(static_cast<int>(rng() % 255) - 127);
+				}
+				dense_forward_u8s8(x.data(), in, w.data(), cols, acc.data());
+				for (std::size_t j = 0; j < cols; j++)
+				{
+					std::int32_t expected = 0;
+					for (std::size_t k = 0; k < in; k++)
+					{
+						expected += x[k] * w[((k / k_int8_group) * cols + j) * k_int8_group + k % k_int8_group];
+					}
+					exact = exact && acc[j] == expected;
+				}
+			}
+		}
+
+		THEN("the kernel this build runs matches the naive loop")
+		{
+			INFO(int8_kernel_name());
+			REQUIRE(exact);
+		}
+	}
+}
+
+SCENARIO("A QuantizedPolicy follows the float policy it was made from", "[inference]")
+{
+	GIVEN("A random tanh MLP written as a frozen policy and quantized on observations like the ones it is run on")
+	{
+		std::mt19937					rng(7);
+		std::normal_distribution<float> normal;
+		const std::size_t				widths[] = {6, 48, 48, 5};
+		std::vector<std::vector<float>> weights;
+		std::vector<std::vector<float>> biases;
+		std::vector<FrozenLayerSpec>	layers;
+		for (std::size_t i = 0; i < 3; i++)
+		{
+			const float scale = 1.0f / std::sqrt(static_cast<float>(widths[i]));
+			weights.emplace_back(widths[i] * widths[i + 1]);
+			biases.emplace_back(widths[i + 1]);
+			for (auto& value : weights.back())
+			{
+				value = scale * normal(rng);
+			}
+			for (auto& value : biases.back())
+			{
+				value = 0.1f * normal(rng);
+			}
+			layers.push_back({widths[i], widths[i + 1], i < 2 ? Activation::Tanh : Activation::None,
+							  weights.back().data(), biases.back().data()});
+		}
+		const auto path = std::filesystem::temp_directory_path() / "swarm_quantized_policy_test.policy";
+		write_frozen_policy(path, layers);
+		FrozenPolicy reference(path);
+
+		std::vector<float> calibration(2000 * widths[0]);
+		std::vector<float> observations(5000 * widths[0]);
+		for (auto& value : calibration)
+		{
+			value = normal(rng);
+		}
+		for (auto& value : observations)
+		{
+			value = normal(rng);
+		}
+		QuantizedPolicy quantized(layers, calibration);
+
+		THEN("its shapes match and its weights take a quarter of the float bytes or less, plus scales")
+		{
+			REQUIRE(quantized.get_observation_size() == 6);
+			REQUIRE(quantized.get_action_space_size() == 5);
+			REQUIRE(quantized.get_num_layers() == 3);
+			REQUIRE(quantized.get_weight_bytes() < (6 * 48 + 48 * 48 + 48 * 5) * sizeof(float) / 2);
+		}
+
+		THEN("it picks the float policy's action on nearly every observation")
+		{
+			const auto report = compare_greedy(reference, quantized, observations);
+			REQUIRE(report.samples == 5000);
+			REQUIRE(report.agreement() >= 0.97);
+			REQUIRE(report.mean_logit_error < 0.02f);
+		}
+
+		THEN("act_greedy is the argmax of its logits")
+		{
+			std::vector<std::int64_t> actions(100);
+			std::vector<float>		  logits(100 * 5);
+			quantized.act_greedy(observations.data(), 100, actions.data());
+			quantized.logits(observations.data(), 100, logits.data());
+			bool consistent = true;
+			for (std::size_t i = 0; i < 100; i++)
+			{
+				const auto row = logits.begin() + static_cast<std::ptrdiff_t>(i * 5);
+				consistent	   = consistent && actions[i] == std::max_element(row, row + 5) - row;
+			}
+			REQUIRE(consistent);
+		}
+
+		THEN("calibration sets that are empty or not whole observations are rejected")
+		{
+			REQUIRE_THROWS_AS(QuantizedPolicy(layers, std::span<const float>{}), std::invalid_argument);
+			REQUIRE_THROWS_AS(QuantizedPolicy(layers, std::span(calibration).first(7)), std::invalid_argument);
+		}
+		std::filesystem::remove(path);
+	}
+}
+
+SCENARIO("Agent::quantize_actor agrees with the exported float policy", "[inference]")
+{
+	GIVEN("An agent exported to a frozen policy and quantized on random observations")
+	{
+		torch::manual_seed(5);
+		SimpleMovingEnvironment env;
+		Agent					agent{&env};
+		const auto				path = std::filesystem::temp_directory_path() / "swarm_quantize_actor_test.policy";
+		agent.export_frozen(path);
+		FrozenPolicy	reference(path);
+		const auto		calibration = torch::randn({1024, 5});
+		QuantizedPolicy quantized	= agent.quantize_actor({calibration.data_ptr<float>(), 1024 * 5});
+
+		THEN("greedy actions agree on nearly all of a fresh batch of observations")
+		{
+			const auto obs	  = torch::randn({4096, 5});
+			const auto report = compare_greedy(reference, quantized, {obs.data_ptr<float>(), 4096 * 5});
+			REQUIRE(report.samples == 4096);
+			REQUIRE(report.agreement() >= 0.95);
+		}
+		std::filesystem::remove(path);
+	}
+}
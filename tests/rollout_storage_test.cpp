@@ -0,0 +1,100 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/RolloutStorage.hpp>
+
+// Stores the same random rollout into a narrow storage and a float32 reference, then checks everything reads back:
+// bit-packed dones, actions and float32 columns exactly, narrow columns as the reference rounded to their type
+static void check_round_trip(long num_envs, std::size_t action_space_size, torch::ScalarType obs_dtype,
+							 torch::ScalarType value_dtype)
+{
+	constexpr long num_steps = 6;
+	constexpr long obs_size	 = 3;
+	RolloutStorage narrow(num_steps, num_envs, obs_size, action_space_size, obs_dtype, value_dtype, torch::kCPU);
+	RolloutStorage reference(num_steps, num_envs, obs_size, action_space_size, torch::kFloat32, torch::kFloat32,
+							 torch::kCPU);
+	const auto obs		= torch::randn({num_steps, num_envs, obs_size}) * 50;
+	const auto actions	= torch::randint(static_cast<long>(action_space_size), {num_steps, num_envs}, torch::kLong);
+	const auto logprobs = torch::randn({num_steps, num_envs});
+	const auto rewards	= torch::randn({num_steps, num_envs});
+	const auto dones	= (torch::rand({num_steps, num_envs}) < 0.3).to(torch::kFloat32);
+	const auto values	= torch::randn({num_steps, num_envs}) * 10;
+	for (long step = 0; step < num_steps; step++)
+	{
+		for (auto* storage : {&narrow, &reference})
+		{
+			storage->store(step, obs[step], actions[step], logprobs[step], rewards[step], dones[step], values[step]);
+		}
+	}
+
+	REQUIRE(torch::equal(narrow.dones(), dones));
+	REQUIRE(torch::equal(narrow.actions(), actions));
+	REQUIRE(torch::equal(narrow.logprobs(), logprobs));
+	REQUIRE(torch::equal(narrow.rewards(), rewards));
+	REQUIRE(torch::equal(reference.observations(), obs));
+	REQUIRE(torch::equal(reference.values(), values));
+	REQUIRE(torch::equal(narrow.observations(), reference.observations().to(obs_dtype).to(torch::kFloat32)));
+	REQUIRE(torch::equal(narrow.values(), reference.values().to(value_dtype).to(torch::kFloat32)));
+	REQUIRE(narrow.observations().scalar_type() == torch::kFloat32);
+	REQUIRE(narrow.actions().scalar_type() == torch::kLong);
+
+	const auto indices = torch::randperm(num_steps * num_envs, torch::kLong).narrow(0, 0, num_envs);
+	REQUIRE(torch::equal(narrow.gather_observations(indices),
+						 narrow.observations().view({-1, obs_size}).index_select(0, indices)));
+	REQUIRE(torch::equal(narrow.gather_actions(indices), actions.view({-1}).index_select(0, indices)));
+	REQUIRE(torch::equal(narrow.gather_logprobs(indices), logprobs.view({-1}).index_select(0, indices)));
+}
+
+SCENARIO("RolloutStorage reads back what was stored", "[rollout]")
+{
+	GIVEN("Env counts that fill the done bytes partially and exactly")
+	{
+		torch::manual_seed(13);
+
+		THEN("every storage type option round-trips against the float32 reference")
+		{
+			for (const long num_envs : {1L, 5L, 8L, 13L})
+			{
+				for (const auto dtype : {torch::kFloat32, torch::kBFloat16, torch::kHalf})
+				{
+					check_round_trip(num_envs, 4, dtype, dtype);
+				}
+				check_round_trip(num_envs, 4, torch::kBFloat16, torch::kHalf);
+			}
+		}
+
+		THEN("action spaces past uint8 and int16 keep every action")
+		{
+			check_round_trip(13, 300, torch::kFloat32, torch::kFloat32);
+			check_round_trip(13, 40000, torch::kFloat32, torch::kFloat32);
+		}
+
+		THEN("a storage of too narrow a float type is rejected")
+		{
+			REQUIRE_THROWS_AS(RolloutStorage(4, 3, 5, 4, torch::kInt8, torch::kFloat32, torch::kCPU),
+							  std::invalid_argument);
+		}
+	}
+
+	GIVEN("A rollout that already exists as float32 tensors")
+	{
+		constexpr long num_steps = 4;
+		constexpr long num_envs	 = 11;
+		const auto	   obs		 = torch::randn({num_steps, num_envs, 2});
+		const auto	   actions	 = torch::randint(4, {num_steps, num_envs}, torch::kLong);
+		const auto	   dones	 = (torch::rand({num_steps, num_envs}) < 0.5).to(torch::kFloat32);
+		const auto	   values	 = torch::randn({num_steps, num_envs});
+		auto wrapped = RolloutStorage::wrap(obs, actions, torch::randn({num_steps, num_envs}),
+											torch::randn({num_steps, num_envs}), dones, values, 4);
+
+		THEN("wrap packs the dones and narrows the actions losslessly")
+		{
+			REQUIRE(torch::equal(wrapped.dones(), dones));
+			REQUIRE(torch::equal(wrapped.actions(), actions));
+			REQUIRE(torch::equal(wrapped.observations(), obs));
+			REQUIRE(torch::equal(wrapped.values(), values));
+		}
+	}
+}
@@ -0,0 +1,169 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SharedMemory.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Blocks until the slot's ready count reaches count, false when an actor reported an error instead
+static bool wait_ready(SharedRolloutRing& ring, std::size_t slot, std::uint32_t count)
+{
+	while (true)
+	{
+		const auto ready = ring.ready(slot).load(std::memory_order_acquire);
+		if (ready == count)
+		{
+			return true;
+		}
+		if (ring.failed())
+		{
+			return false;
+		}
+		shared_wait(ring.ready(slot), ready, std::chrono::milliseconds{100});
+	}
+}
+
+SCENARIO("SharedWeights hands the latest weights to a reader", "[shared_memory]")
+{
+	GIVEN("Weights published twice")
+	{
+		SharedWeights	   weights(100);
+		std::vector<float> buffer(100, 1.0f);
+		weights.publish(1, buffer.data());
+		std::fill(buffer.begin(), buffer.end(), 2.0f);
+		weights.publish(2, buffer.data());
+
+		THEN("a reader gets the second version")
+		{
+			std::vector<float> out(100);
+			REQUIRE(weights.read(out.data()) == 2);
+			REQUIRE(weights.version() == 2);
+			REQUIRE(out == buffer);
+		}
+	}
+}
+
+SCENARIO("SharedRolloutRing carries rollouts from forked actors to the learner", "[shared_memory]")
+{
+	GIVEN("Four actor processes with two envs each, driven by published versions")
+	{
+		constexpr std::size_t	num_steps  = 8;
+		constexpr std::size_t	num_envs   = 8;
+		constexpr std::size_t	num_actors = 4;
+		constexpr std::uint32_t num_rounds = 50;
+		SharedWeights			weights(256);
+		SharedRolloutRing		ring(num_steps, num_envs, 3, num_actors);
+		std::vector<float>		buffer(weights.size(), 0.0f);
+		weights.publish(0, buffer.data());
+
+		std::vector<pid_t> actors;
+		for (std::size_t actor = 0; actor < num_actors; actor++)
+		{
+			const pid_t pid = ::fork();
+			REQUIRE(pid >= 0);
+			if (pid == 0)
+			{
+				std::vector<float> mine(weights.size());
+				for (std::uint32_t k = 0; k < num_rounds; k++)
+				{
+					while (weights.version() < k)
+					{
+						shared_wait(weights.version_word(), weights.version(), std::chrono::milliseconds{100});
+					}
+					const auto version = weights.read(mine.data());
+					for (const float w : mine)
+					{
+						if (w != static_cast<float>(version))
+						{
+							ring.set_error("torn weights");
+							::_exit(1);
+						}
+					}
+					const std::size_t slot = k % SharedRolloutRing::k_num_slots;
+					for (std::size_t t = 0; t < num_steps; t++)
+					{
+						const std::size_t first_env = actor * ring.envs_per_actor();
+						for (std::size_t e = first_env; e < first_env + ring.envs_per_actor(); e++)
+						{
+							ring.rewards(slot)[t * num_envs + e] = static_cast<float>(k * 100 + e);
+						}
+					}
+					ring.report(slot, actor).policy_version = version;
+					ring.ready(slot).fetch_add(1, std::memory_order_acq_rel);
+					shared_wake_all(ring.ready(slot));
+				}
+				::_exit(0);
+			}
+			actors.push_back(pid);
+		}
+
+		WHEN("the learner consumes every round and publishes the next version")
+		{
+			bool rewards_match = true;
+			bool versions_match = true;
+			for (std::uint32_t k = 0; k < num_rounds; k++)
+			{
+				const std::size_t slot = k % SharedRolloutRing::k_num_slots;
+				REQUIRE(wait_ready(ring, slot, num_actors));
+				for (std::size_t i = 0; i < num_steps * num_envs; i++)
+				{
+					rewards_match &= ring.rewards(slot)[i] == static_cast<float>(k * 100 + i % num_envs);
+				}
+				for (std::size_t actor = 0; actor < num_actors; actor++)
+				{
+					versions_match &= ring.report(slot, actor).policy_version == k;
+				}
+				ring.ready(slot).store(0, std::memory_order_release);
+				std::fill(buffer.begin(), buffer.end(), static_cast<float>(k + 1));
+				weights.publish(k + 1, buffer.data());
+			}
+			bool clean_exit = true;
+			for (const pid_t pid : actors)
+			{
+				int status = 0;
+				::waitpid(pid, &status, 0);
+				clean_exit &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			}
+
+			THEN("each round holds every actor's part, collected with the version it waited for")
+			{
+				REQUIRE(ring.error().empty());
+				REQUIRE(rewards_match);
+				REQUIRE(versions_match);
+				REQUIRE(clean_exit);
+			}
+		}
+	}
+}
+
+SCENARIO("SharedRolloutRing reports the first actor error", "[shared_memory]")
+{
+	GIVEN("A ring")
+	{
+		SharedRolloutRing ring(4, 4, 2, 2);
+
+		WHEN("two errors are set")
+		{
+			ring.set_error("first");
+			ring.set_error("second");
+
+			THEN("only the first one is kept")
+			{
+				REQUIRE(ring.failed());
+				REQUIRE(ring.error() == "first");
+			}
+		}
+	}
+	GIVEN("More envs than fit the actors evenly")
+	{
+		THEN("the ring refuses them")
+		{
+			REQUIRE_THROWS_AS(SharedRolloutRing(4, 5, 2, 2), std::invalid_argument);
+		}
+	}
+}
@@ -0,0 +1,141 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/SimulationThread.hpp>
+#include <swarm/SwarmEnvironment.hpp>
+#include <algorithm>
+#include <array>
+
+SCENARIO("TripleBuffer hands the latest value from one thread to another", "[render]")
+{
+	GIVEN("An empty buffer")
+	{
+		TripleBuffer<long> buffer(-1);
+		REQUIRE_FALSE(buffer.update());
+		REQUIRE(buffer.front() == -1);
+
+		WHEN("two values are published before the consumer looks")
+		{
+			buffer.back() = 1;
+			buffer.publish();
+			buffer.back() = 2;
+			buffer.publish();
+
+			THEN("the consumer only sees the newer one, once")
+			{
+				REQUIRE(buffer.update());
+				REQUIRE(buffer.front() == 2);
+				REQUIRE_FALSE(buffer.update());
+				REQUIRE(buffer.front() == 2);
+			}
+		}
+	}
+
+	GIVEN("A producer publishing counted arrays")
+	{
+		TripleBuffer<std::array<long, 64>> buffer;
+		constexpr long						count = 100000;
+
+		WHEN("a consumer reads them concurrently")
+		{
+			std::jthread producer([&] {
+				for (long i = 1; i <= count; i++)
+				{
+					buffer.back().fill(i);
+					buffer.publish();
+				}
+			});
+			long last	 = 0;
+			bool torn	 = false;
+			bool ordered = true;
+			while (last < count)
+			{
+				if (!buffer.update())
+				{
+					continue;
+				}
+				const auto& values = buffer.front();
+				torn |= std::ranges::any_of(values, [&](long value) { return value != values[0]; });
+				ordered &= values[0] > last;
+				last = values[0];
+			}
+
+			THEN("every value seen was complete and newer than the one before")
+			{
+				REQUIRE_FALSE(torn);
+				REQUIRE(ordered);
+			}
+		}
+	}
+}
+
+SCENARIO("SwarmRenderer turns a snapshot into one triangle list", "[render]")
+{
+	GIVEN("A swarm snapshot")
+	{
+		SwarmEnvironment env(100, 2);
+		env.seed(1);
+		env.reset();
+		SwarmSnapshot snapshot;
+		env.write_snapshot(snapshot);
+		REQUIRE(snapshot.agents.size() == 100);
+		REQUIRE(snapshot.goals.size() == 1);
+
+		WHEN("it is rendered, then replaced by a smaller one")
+		{
+			SwarmRenderer renderer;
+			renderer.update(snapshot);
+			const auto full = renderer.get_vertex_count();
+			snapshot.clear();
+			SimpleMovingEnvironment{}.write_snapshot(snapshot);
+			renderer.update(snapshot);
+
+			THEN("every agent and goal is a quad of six vertices")
+			{
+				REQUIRE(full == 6 * 101);
+				REQUIRE(renderer.get_vertex_count() == 12);
+			}
+		}
+	}
+}
+
+SCENARIO("SimulationThread steps on its own and publishes snapshots", "[render]")
+{
+	GIVEN("A simple env stepped by a policy which always moves right")
+	{
+		auto env = std::make_unique<SimpleMovingEnvironment>(sf::Vector2f{0, 0}, sf::Vector2f{0, 0}, sf::Vector2f{900, 500});
+		auto observation = env->get_current_observation();
+		SimulationThread simulation{std::move(env), observation,
+									[](const torch::Tensor&) { return torch::tensor(0L); },
+									std::chrono::microseconds{100}};
+
+		WHEN("the render thread polls it while setting a new goal")
+		{
+			REQUIRE(simulation.set_goal({50, 60}));
+			std::uint64_t last_tick = 0;
+			bool		  monotonic = true;
+			while (last_tick < 20)
+			{
+				if (simulation.poll_snapshot())
+				{
+					monotonic &= simulation.snapshot().tick > last_tick || last_tick == 0;
+					last_tick = simulation.snapshot().tick;
+				}
+			}
+			const auto& snapshot = simulation.snapshot();
+
+			THEN("ticks advance, the agent moved right and the goal was applied")
+			{
+				REQUIRE(monotonic);
+				REQUIRE(snapshot.agents.size() == 1);
+				REQUIRE(snapshot.agents[0].x == 30.0f * static_cast<float>(snapshot.tick));
+				REQUIRE(snapshot.agents[0].y == 0.0f);
+				REQUIRE(snapshot.goals[0].x == 50.0f);
+				REQUIRE(snapshot.goals[0].y == 60.0f);
+			}
+		}
+	}
+}
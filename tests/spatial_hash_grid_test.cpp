@@ -0,0 +1,109 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SpatialHashGrid.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+SCENARIO("SpatialHashGrid answers the same as a brute force scan", "[spatial]")
+{
+	GIVEN("Points scattered over and around the world")
+	{
+		std::mt19937						  rng(1);
+		std::uniform_real_distribution<float> x_dist(-200.0f, 2100.0f);
+		std::uniform_real_distribution<float> y_dist(-200.0f, 1300.0f);
+		constexpr std::size_t				  n = 2000;
+		std::vector<float>					  x(n);
+		std::vector<float>					  y(n);
+		for (std::size_t i = 0; i < n; i++)
+		{
+			x[i] = x_dist(rng);
+			y[i] = y_dist(rng);
+		}
+		SpatialHashGrid grid(1920.0f, 1080.0f, 100.0f);
+		grid.rebuild(x, y);
+		REQUIRE(grid.get_num_points() == n);
+
+		WHEN("random points are queried")
+		{
+			bool radius_matches = true;
+			bool knn_matches	= true;
+			for (std::uint32_t q = 0; q < 500; q++)
+			{
+				const float qx		= x_dist(rng);
+				const float qy		= y_dist(rng);
+				const float radius	= 30.0f + static_cast<float>(q % 250);
+				const auto	exclude = q % n;
+
+				std::vector<std::pair<float, std::uint32_t>> expected;
+				for (std::uint32_t i = 0; i < n; i++)
+				{
+					const float dx = x[i] - qx;
+					const float dy = y[i] - qy;
+					const float d2 = dx * dx + dy * dy;
+					if (i != exclude && d2 <= radius * radius)
+					{
+						expected.emplace_back(d2, i);
+					}
+				}
+				std::sort(expected.begin(), expected.end());
+
+				std::vector<std::uint32_t> within;
+				grid.query_radius(qx, qy, radius, within, exclude);
+				radius_matches = radius_matches && within.size() == expected.size();
+				for (const auto& [d2, i] : expected)
+				{
+					radius_matches = radius_matches && std::find(within.begin(), within.end(), i) != within.end();
+				}
+
+				std::uint32_t	  index[8];
+				float			  dist2[8];
+				const std::size_t found = grid.query_knn(qx, qy, radius, index, dist2, exclude);
+				knn_matches				= knn_matches && found == std::min<std::size_t>(8, expected.size());
+				for (std::size_t k = 0; knn_matches && k < found; k++)
+				{
+					knn_matches = std::abs(dist2[k] - expected[k].first) <= 1e-3f * expected[k].first + 1e-3f
+								  && (k == 0 || dist2[k - 1] <= dist2[k]);
+				}
+			}
+
+			THEN("the radius query finds every point and kNN returns the closest ones in order")
+			{
+				REQUIRE(radius_matches);
+				REQUIRE(knn_matches);
+			}
+		}
+
+		WHEN("the points move and the grid is rebuilt")
+		{
+			std::fill(x.begin(), x.end(), 50.0f);
+			std::fill(y.begin(), y.end(), 50.0f);
+			grid.rebuild(x, y);
+
+			THEN("queries see the new positions")
+			{
+				std::vector<std::uint32_t> within;
+				grid.query_radius(1000.0f, 500.0f, 100.0f, within);
+				REQUIRE(within.empty());
+				grid.query_radius(50.0f, 50.0f, 1.0f, within, 0);
+				REQUIRE(within.size() == n - 1);
+			}
+		}
+	}
+
+	GIVEN("Mismatched coordinate arrays")
+	{
+		SpatialHashGrid	   grid(100.0f, 100.0f, 10.0f);
+		std::vector<float> x(3);
+		std::vector<float> y(2);
+
+		THEN("rebuild rejects them")
+		{
+			REQUIRE_THROWS_AS(grid.rebuild(x, y), std::invalid_argument);
+		}
+	}
+}
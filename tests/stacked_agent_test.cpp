@@ -0,0 +1,102 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/PpoLoss.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/StackedAgent.hpp>
+
+SCENARIO("A StackedAgent computes what its agents compute one by one", "[stacked_agent]")
+{
+	GIVEN("Three differently initialized agents, stacked, and a batch of observations per agent")
+	{
+		torch::manual_seed(11);
+		SimpleMovingEnvironment env;
+		Agent					first{&env};
+		Agent					second{&env};
+		Agent					third{&env};
+		std::vector<Agent*>		agents{&first, &second, &third};
+		StackedAgent			stacked(agents);
+		constexpr long			batch	= 33;
+		const auto				obs		= torch::randn({3, batch, 5});
+		const auto				actions = torch::randint(4, {3, batch}, torch::kLong);
+
+		WHEN("the forward passes are compared")
+		{
+			torch::NoGradGuard nograd;
+			auto			   res = stacked.get_action_and_value(obs, actions);
+
+			THEN("every slice matches its agent")
+			{
+				for (long k = 0; k < 3; k++)
+				{
+					auto expected = agents[k]->get_action_and_value(obs[k], actions[k]);
+					REQUIRE(torch::allclose(res.log_prob[k], expected.log_prob, 1e-4, 1e-5));
+					REQUIRE(torch::allclose(res.entropy[k], expected.entropy, 1e-4, 1e-5));
+					REQUIRE(torch::allclose(res.value[k], expected.value, 1e-4, 1e-5));
+				}
+			}
+		}
+
+		WHEN("the summed PPO losses are back-propagated")
+		{
+			const auto		   oldlogprob = torch::randn({3, batch}) * 0.1 - 1.4;
+			const auto		   advantages = torch::randn({3, batch});
+			const auto		   returns	  = torch::randn({3, batch});
+			const auto		   oldvalues  = torch::randn({3, batch});
+			auto			   res		  = stacked.get_action_and_value(obs, actions);
+			ppo_loss({res.log_prob, res.entropy, res.value, oldlogprob, advantages, returns, oldvalues}, 0.2f, 0.5f,
+					 0.01f)
+				.loss.sum()
+				.backward();
+			const auto stacked_norms = stacked.clip_grad_norm(1e9);
+
+			THEN("each slice gets the gradient its agent gets from its own loss")
+			{
+				for (long k = 0; k < 3; k++)
+				{
+					auto expected = agents[k]->get_action_and_value(obs[k], actions[k]);
+					ppo_loss({expected.log_prob, expected.entropy, expected.value, oldlogprob[k], advantages[k],
+							  returns[k], oldvalues[k]},
+							 0.2f, 0.5f, 0.01f)
+						.loss.backward();
+					auto params = agents[k]->named_parameters();
+					auto grad	= params["actor.0.weight"].grad().t();
+					REQUIRE(torch::allclose(stacked.named_parameters()["actor_0_weight"].grad()[k], grad, 1e-4, 1e-6));
+					std::vector<torch::Tensor> squares;
+					for (const auto& p : agents[k]->parameters())
+					{
+						squares.push_back(p.grad().pow(2).sum());
+					}
+					REQUIRE(torch::allclose(stacked_norms[k], torch::stack(squares).sum().sqrt(), 1e-4, 1e-6));
+				}
+			}
+		}
+
+		WHEN("the stacked parameters change and are written back")
+		{
+			{
+				torch::NoGradGuard nograd;
+				for (auto& param : stacked.parameters())
+				{
+					param.add_(torch::randn_like(param) * 0.1);
+				}
+			}
+			for (std::size_t k = 0; k < 3; k++)
+			{
+				stacked.unstack_into(k, *agents[k]);
+			}
+
+			THEN("the agents follow")
+			{
+				torch::NoGradGuard nograd;
+				auto			   values = stacked.get_value(obs);
+				for (long k = 0; k < 3; k++)
+				{
+					REQUIRE(torch::allclose(values[k], agents[k]->get_value(obs[k]), 1e-4, 1e-5));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,111 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SwarmEnvironment.hpp>
+
+SCENARIO("SwarmEnvironment steps every agent of one world in parallel", "[env]")
+{
+	GIVEN("A serial and a parallel swarm seeded identically")
+	{
+		constexpr std::size_t num_agents = 1001;
+		SwarmEnvironment	  serial(num_agents, 1);
+		SwarmEnvironment	  parallel(num_agents, 4);
+		serial.seed(7);
+		parallel.seed(7);
+
+		WHEN("they are reset")
+		{
+			auto observations = parallel.reset();
+
+			THEN("there is one observation row per agent and the results match")
+			{
+				REQUIRE(observations.size(0) == static_cast<long>(num_agents));
+				REQUIRE(observations.size(1) == static_cast<long>(parallel.get_observation_size()));
+				REQUIRE(torch::equal(serial.reset(), observations));
+			}
+		}
+
+		WHEN("they are stepped with the same actions")
+		{
+			serial.reset();
+			parallel.reset();
+			torch::manual_seed(0);
+			bool identical = true;
+			for (int step = 0; step < 200; step++)
+			{
+				auto action	  = torch::randint(0, 4, {static_cast<long>(num_agents)}, torch::kLong);
+				auto expected = serial.step(action);
+				auto actual	  = parallel.step(action);
+				identical	  = identical && torch::equal(expected.observations, actual.observations)
+						  && torch::equal(expected.reward, actual.reward) && torch::equal(expected.done, actual.done);
+			}
+
+			THEN("observations, rewards and dones are identical")
+			{
+				REQUIRE(identical);
+			}
+		}
+	}
+
+	GIVEN("Agents standing on the shared goal")
+	{
+		SwarmEnvironment swarm(8, 2);
+		swarm.seed(1);
+		swarm.reset();
+		std::fill(swarm.position_x.begin(), swarm.position_x.end(), swarm.goal_x - 30.0f);
+		std::fill(swarm.position_y.begin(), swarm.position_y.end(), swarm.goal_y);
+
+		WHEN("they all step onto it")
+		{
+			auto res = swarm.step(torch::zeros({8}, torch::kLong));
+
+			THEN("every agent finishes its episode and respawns")
+			{
+				REQUIRE(res.done.sum().item<float>() == 8.0f);
+				REQUIRE(swarm.take_episode_stats().episodes == 8);
+			}
+		}
+	}
+
+	GIVEN("Swarms observing their nearest neighbors")
+	{
+		SwarmEnvironment serial(500, 1, 4);
+		SwarmEnvironment parallel(500, 3, 4);
+		serial.seed(11);
+		parallel.seed(11);
+
+		WHEN("they are reset and stepped")
+		{
+			auto observations = parallel.reset();
+			REQUIRE(torch::equal(serial.reset(), observations));
+			torch::manual_seed(0);
+			bool identical = true;
+			for (int step = 0; step < 50; step++)
+			{
+				auto action = torch::randint(0, 4, {500}, torch::kLong);
+				identical	= identical && torch::equal(serial.step(action).observations, parallel.step(action).observations);
+			}
+
+			THEN("every row carries a zero padded neighbor block and the results match")
+			{
+				REQUIRE(observations.size(1) == 7 + 4 * 3);
+				auto present = observations.slice(1, 9, 19, 3);
+				REQUIRE(((present == 0) | (present == 1)).all().item<bool>());
+				REQUIRE(present.sum().item<float>() > 0.0f);
+				REQUIRE(identical);
+			}
+		}
+	}
+
+	GIVEN("More workers than agents")
+	{
+		SwarmEnvironment swarm(3, 16);
+
+		THEN("the pool is clamped to one worker per agent")
+		{
+			REQUIRE(swarm.get_num_workers() == 3);
+		}
+	}
+}
@@ -0,0 +1,275 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Sweep.hpp>
+#include <fstream>
+#include <iterator>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// Every step ends an episode of return score in every env. Slow runs sleep on every step, so they are still running
+// when they reach their first rung.
+struct ScoredEnvironment : Environment
+{
+	std::size_t	 num_envs;
+	float		 score;
+	bool		 slow;
+	EpisodeStats stats;
+
+	ScoredEnvironment(std::size_t num_envs, float score, bool slow)
+		: num_envs(num_envs)
+		, score(score)
+		, slow(slow)
+	{
+	}
+
+	StepResult step(const torch::Tensor&) override
+	{
+		if (slow)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		for (std::size_t i = 0; i < num_envs; i++)
+		{
+			stats.add(score, 1);
+		}
+		const auto n = static_cast<long>(num_envs);
+		return {torch::zeros({n, 2}), torch::full({n}, score), torch::ones({n})};
+	}
+	std::size_t	  get_observation_size() const override { return 2; }
+	std::size_t	  get_action_space_size() const override { return 2; }
+	std::size_t	  get_num_envs() const override { return num_envs; }
+	torch::Tensor reset() override { return torch::zeros({static_cast<long>(num_envs), 2}); }
+	EpisodeStats  take_episode_stats() override { return std::exchange(stats, {}); }
+	std::unique_ptr<Environment> clone() const override { return std::make_unique<ScoredEnvironment>(*this); }
+};
+
+// The cores a trial's log says it was pinned to
+static std::vector<int> pinned_cores(const std::filesystem::path& log)
+{
+	std::ifstream in(log);
+	std::string	  line;
+	while (std::getline(in, line))
+	{
+		if (line.starts_with("Pinned to"))
+		{
+			std::istringstream cores(line.substr(9));
+			return {std::istream_iterator<int>(cores), std::istream_iterator<int>()};
+		}
+	}
+	return {};
+}
+
+SCENARIO("A grid sweep runs every combination", "[sweep]")
+{
+	GIVEN("Three learning rates and two clip coefficients")
+	{
+		SweepSpec spec;
+		spec.grid = {{"learning_rate", {1e-4, 3e-4, 1e-3}}, {"clip_coef", {0.1, 0.2}}};
+
+		WHEN("the trials are made")
+		{
+			const auto trials = make_sweep_trials(spec);
+
+			THEN("there is one per combination, the last field changing fastest")
+			{
+				REQUIRE(trials.size() == 6);
+				REQUIRE(trials[0] == SweepTrial{{"learning_rate", 1e-4}, {"clip_coef", 0.1}});
+				REQUIRE(trials[1] == SweepTrial{{"learning_rate", 1e-4}, {"clip_coef", 0.2}});
+				REQUIRE(trials[5] == SweepTrial{{"learning_rate", 1e-3}, {"clip_coef", 0.2}});
+			}
+		}
+	}
+	GIVEN("A field TrainingConfig cannot sweep")
+	{
+		SweepSpec spec;
+		spec.grid = {{"learning_rte", {1e-4}}};
+
+		THEN("making the trials throws before anything runs")
+		{
+			REQUIRE_THROWS_AS(make_sweep_trials(spec), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("A random sweep draws from its ranges", "[sweep]")
+{
+	GIVEN("A log scale range, a grid field and a seed")
+	{
+		SweepSpec spec;
+		spec.grid		 = {{"num_envs", {8, 16}}};
+		spec.ranges		 = {{"learning_rate", 1e-5, 1e-2, true}};
+		spec.num_samples = 50;
+		spec.seed		 = 7;
+
+		WHEN("the trials are made twice")
+		{
+			const auto trials = make_sweep_trials(spec);
+
+			THEN("every value is in range and the draws repeat")
+			{
+				REQUIRE(trials.size() == 50);
+				bool in_range = true;
+				for (const auto& trial : trials)
+				{
+					in_range &= trial[0].second == 8 || trial[0].second == 16;
+					in_range &= trial[1].second >= 1e-5 && trial[1].second <= 1e-2;
+				}
+				REQUIRE(in_range);
+				REQUIRE(make_sweep_trials(spec) == trials);
+			}
+		}
+	}
+}
+
+SCENARIO("set_config_field rounds integer fields", "[sweep]")
+{
+	GIVEN("A config")
+	{
+		TrainingConfig config;
+
+		WHEN("an integer and a float field are set")
+		{
+			set_config_field(config, "num_steps", 127.6);
+			set_config_field(config, "gamma", 0.9);
+
+			THEN("both hold the value")
+			{
+				REQUIRE(config.num_steps == 128);
+				REQUIRE(config.gamma == 0.9f);
+			}
+		}
+
+		THEN("fields that are not hyperparameters are rejected")
+		{
+			REQUIRE_THROWS_AS(set_config_field(config, "num_env_workers", 4), std::invalid_argument);
+			REQUIRE_THROWS_AS(set_config_field(config, "max_policy_lag", 1), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("The median stopping rule stops runs below the median of their peers", "[sweep]")
+{
+	GIVEN("A rule with one rung that needs two peers")
+	{
+		MedianStoppingRule rule(1, 2);
+
+		THEN("the first runs only set the bar")
+		{
+			REQUIRE_FALSE(rule.report(0, 1.0));
+			REQUIRE_FALSE(rule.report(0, 3.0));
+		}
+		WHEN("two runs reported")
+		{
+			rule.report(0, 1.0);
+			rule.report(0, 3.0);
+
+			THEN("a run below their median of 2 stops and one above it continues")
+			{
+				REQUIRE(rule.report(0, 1.5));
+				REQUIRE_FALSE(rule.report(0, 2.5));
+			}
+		}
+	}
+}
+
+SCENARIO("run_sweep packs trials onto core slots and stops the losers", "[sweep]")
+{
+	GIVEN("Three trials on two one-core slots, two of a single update and one long one that scores worst")
+	{
+		TrainingConfig base;
+		base.num_steps		 = 16;
+		base.num_envs		 = 4;
+		base.num_minibatches = 2;
+		base.update_epochs	 = 1;
+		base.seed			 = 1;
+		base.device			 = torch::kCPU;
+		SweepSpec spec;
+		spec.grid = {{"total_timesteps", {64, 64, 6400}}};
+
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		REQUIRE(::sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+		std::vector<int> cores;
+		for (int cpu = 0; cpu < CPU_SETSIZE && cores.size() < 2; cpu++)
+		{
+			if (CPU_ISSET(cpu, &allowed))
+			{
+				cores.push_back(cpu);
+			}
+		}
+		// A single core machine gets two slots on the same core
+		cores.resize(2, cores.front());
+
+		SweepOptions options;
+		options.out_dir		  = std::filesystem::temp_directory_path() / "swarm_sweep_test";
+		options.cores		  = cores;
+		options.cores_per_run = 1;
+		options.rungs		  = {0.01};
+		options.min_peers	  = 1;
+		options.poll_interval = std::chrono::milliseconds{20};
+		std::filesystem::remove_all(options.out_dir);
+		const auto make_env = [](const TrainingConfig& config) {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			::sched_getaffinity(0, sizeof(set), &set);
+			std::cout << "Pinned to";
+			for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			{
+				if (CPU_ISSET(cpu, &set))
+				{
+					std::cout << ' ' << cpu;
+				}
+			}
+			// Flushed now, the long trial is killed before it could flush on exit
+			std::cout << '\n' << std::flush;
+			const bool long_run = config.total_timesteps > 64;
+			return std::make_unique<ScoredEnvironment>(static_cast<std::size_t>(config.num_envs),
+													   long_run ? 0.0f : 1.0f, long_run);
+		};
+
+		WHEN("the sweep runs")
+		{
+			const auto results = run_sweep(base, spec, make_env, options);
+
+			THEN("the first two trials ran side by side, each pinned to its own slot's core")
+			{
+				REQUIRE(pinned_cores(options.out_dir / "run_0.log") == std::vector{cores[0]});
+				REQUIRE(pinned_cores(options.out_dir / "run_1.log") == std::vector{cores[1]});
+			}
+
+			THEN("the third trial got a freed slot and was stopped below its peers' median")
+			{
+				const auto third = pinned_cores(options.out_dir / "run_2.log");
+				REQUIRE((third == std::vector{cores[0]} || third == std::vector{cores[1]}));
+				REQUIRE(results.size() == 3);
+				REQUIRE(results[0].status == SweepStatus::Finished);
+				REQUIRE(results[1].status == SweepStatus::Finished);
+				REQUIRE(results[2].status == SweepStatus::Stopped);
+				REQUIRE(results[0].global_step == 64);
+				REQUIRE(results[0].score == 1.0);
+				REQUIRE(results[2].global_step < 6400);
+			}
+
+			THEN("results.csv has one row per trial")
+			{
+				std::ifstream			 in(options.out_dir / "results.csv");
+				std::vector<std::string> lines;
+				for (std::string line; std::getline(in, line);)
+				{
+					lines.push_back(line);
+				}
+				REQUIRE(lines.size() == 4);
+				REQUIRE(lines[0] == "trial,total_timesteps,status,global_step,score,sps,time_s");
+				REQUIRE(lines[1].starts_with("0,64,finished,64,1,"));
+				REQUIRE(lines[2].starts_with("1,64,finished,64,1,"));
+				REQUIRE(lines[3].starts_with("2,6400,stopped,"));
+			}
+		}
+		std::filesystem::remove_all(options.out_dir);
+	}
+}
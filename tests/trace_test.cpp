@@ -0,0 +1,63 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/Trace.hpp>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+SCENARIO("Trace scopes from several threads end up in the summary and the Chrome trace", "[trace]")
+{
+	GIVEN("Tracing started and scopes recorded on two threads")
+	{
+		start_tracing();
+		set_trace_thread_name("test main");
+		{
+			TraceScope outer("outer");
+			std::jthread worker([] {
+				set_trace_thread_name("test worker");
+				for (int i = 0; i < 3; i++)
+				{
+					TraceScope inner("worker_phase");
+				}
+			});
+		}
+		stop_tracing();
+		{
+			TraceScope ignored("after_stop");
+		}
+
+		WHEN("the summary is taken")
+		{
+			auto phases = trace_summary();
+
+			THEN("every recorded phase is counted and nothing after stop_tracing")
+			{
+				REQUIRE(phases.size() == 2);
+				for (const auto& phase : phases)
+				{
+					REQUIRE(phase.count == (phase.name == "outer" ? 1 : 3));
+					REQUIRE(phase.total_ns >= 0);
+				}
+			}
+		}
+		WHEN("the trace is exported")
+		{
+			const auto path = std::filesystem::temp_directory_path() / "swarm_trace_test.json";
+			write_chrome_trace(path);
+			std::stringstream json;
+			json << std::ifstream(path).rdbuf();
+			std::filesystem::remove(path);
+
+			THEN("it holds complete events and thread names")
+			{
+				REQUIRE(json.str().starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+				REQUIRE(json.str().find("\"name\":\"worker_phase\"") != std::string::npos);
+				REQUIRE(json.str().find("\"args\":{\"name\":\"test worker\"}") != std::string::npos);
+				REQUIRE(json.str().find("after_stop") == std::string::npos);
+			}
+		}
+	}
+}
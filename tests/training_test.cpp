@@ -0,0 +1,231 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SimpleMovingEnvironment.hpp>
+#include <swarm/Training.hpp>
+#include <swarm/VectorizedMovingEnvironment.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// A few updates of 4 envs x 16 steps, seconds of training
+static TrainingConfig tiny_config(long num_updates)
+{
+	TrainingConfig config;
+	config.num_steps	   = 16;
+	config.num_envs		   = 4;
+	config.total_timesteps = num_updates * config.num_steps * config.num_envs;
+	config.num_minibatches = 2;
+	config.update_epochs   = 1;
+	config.seed			   = 3;
+	config.device		   = torch::kCPU;
+	return config;
+}
+
+// A batch of num_envs envs that only counts the batch steps training takes, through a counter the caller keeps
+struct CountingEnvironment : Environment
+{
+	std::size_t num_envs;
+	long*		steps;
+
+	CountingEnvironment(std::size_t num_envs, long* steps)
+		: num_envs(num_envs)
+		, steps(steps)
+	{
+	}
+
+	StepResult step(const torch::Tensor&) override
+	{
+		(*steps)++;
+		const auto n = static_cast<long>(num_envs);
+		return {torch::zeros({n, 2}), torch::zeros({n}), torch::zeros({n})};
+	}
+	std::size_t	  get_observation_size() const override { return 2; }
+	std::size_t	  get_action_space_size() const override { return 2; }
+	std::size_t	  get_num_envs() const override { return num_envs; }
+	torch::Tensor reset() override { return torch::zeros({static_cast<long>(num_envs), 2}); }
+	std::unique_ptr<Environment> clone() const override { return std::make_unique<CountingEnvironment>(*this); }
+};
+
+// Trains a fresh agent on 4 vectorized envs and returns the policy_lag column of its metrics, one entry per update
+static std::vector<long> train_and_read_lags(TrainingConfig config)
+{
+	const auto metrics_path = std::filesystem::temp_directory_path() / "swarm_training_test_lag.csv";
+	config.metrics_path		= metrics_path;
+	auto  env				= std::make_unique<VectorizedMovingEnvironment>(4);
+	Agent agent{env.get()};
+	train(agent, std::move(env), config);
+
+	std::ifstream	  in(metrics_path);
+	std::string		  line;
+	std::vector<long> lags;
+	std::getline(in, line); // Header, policy_lag is the fifth column
+	while (std::getline(in, line))
+	{
+		std::istringstream row(line);
+		std::string		   field;
+		for (int column = 0; column < 5; column++)
+		{
+			std::getline(row, field, ',');
+		}
+		lags.push_back(std::stol(field));
+	}
+	in.close();
+	std::filesystem::remove(metrics_path);
+	return lags;
+}
+
+SCENARIO("Pipelined training keeps the actor within max_policy_lag of the learner", "[training]")
+{
+	GIVEN("A small pipelined run")
+	{
+		auto config		 = tiny_config(6);
+		config.pipelined = true;
+
+		WHEN("the actor may not trail the learner")
+		{
+			config.max_policy_lag = 0;
+			const auto lags		  = train_and_read_lags(config);
+
+			THEN("every rollout was collected with the learner's latest policy")
+			{
+				REQUIRE(lags == std::vector<long>(6, 0));
+			}
+		}
+
+		WHEN("the actor may trail by one update")
+		{
+			config.max_policy_lag = 1;
+			const auto lags		  = train_and_read_lags(config);
+
+			THEN("no rollout was collected with a policy more than one update old")
+			{
+				REQUIRE(lags.size() == 6);
+				REQUIRE(std::ranges::all_of(lags, [](long lag) { return lag >= 0 && lag <= 1; }));
+			}
+
+			THEN("the actor did run ahead of the learner")
+			{
+				// The actor starts rollout 1 as soon as rollout 0 is handed over, long before the first update is
+				// published, so a run that never overlaps would report lag 0 here
+				REQUIRE(lags.size() == 6);
+				REQUIRE(std::ranges::count(lags, 1L) > 0);
+			}
+		}
+
+		WHEN("a lag the two rollout buffers cannot provide is asked for")
+		{
+			config.max_policy_lag = 2;
+			auto  env			  = std::make_unique<VectorizedMovingEnvironment>(4);
+			Agent agent{env.get()};
+
+			THEN("train() refuses it")
+			{
+				REQUIRE_THROWS_AS(train(agent, std::move(env), config), std::invalid_argument);
+			}
+		}
+	}
+}
+
+SCENARIO("Thread settings hold across training runs in one process", "[training]")
+{
+	GIVEN("A config asking for two intra-op and two inter-op threads")
+	{
+		auto config				= tiny_config(1);
+		config.intra_op_threads = 2;
+		config.inter_op_threads = 2;
+		const auto train_once	= [](const TrainingConfig& run_config) {
+			  auto	env = std::make_unique<VectorizedMovingEnvironment>(4);
+			  Agent agent{env.get()};
+			  train(agent, std::move(env), run_config);
+		};
+
+		WHEN("train() runs twice")
+		{
+			REQUIRE_NOTHROW(train_once(config));
+			REQUIRE_NOTHROW(train_once(config));
+
+			THEN("both pools have the asked for size")
+			{
+				REQUIRE(torch::get_num_threads() == 2);
+				REQUIRE(torch::get_num_interop_threads() == 2);
+			}
+		}
+
+		WHEN("a later run asks for another size")
+		{
+			train_once(config);
+			config.intra_op_threads = 3;
+			config.inter_op_threads = 3;
+			REQUIRE_NOTHROW(train_once(config));
+
+			THEN("the intra-op pool follows and the started inter-op pool is kept")
+			{
+				REQUIRE(torch::get_num_threads() == 3);
+				REQUIRE(torch::get_num_interop_threads() == 2);
+			}
+		}
+	}
+}
+
+SCENARIO("Actor processes collect float32 rollouts for the learner", "[training]")
+{
+	GIVEN("Two actor processes sharing 4 single envs")
+	{
+		auto config				   = tiny_config(3);
+		config.num_actor_processes = 2;
+		auto  env				   = std::make_unique<SimpleMovingEnvironment>();
+		Agent agent{env.get()};
+
+		WHEN("the rollout storage is float32")
+		{
+			THEN("the actors are forked and training completes")
+			{
+				REQUIRE_NOTHROW(train(agent, std::move(env), config));
+			}
+		}
+
+		WHEN("a narrower storage type is asked for")
+		{
+			config.obs_dtype = torch::kBFloat16;
+
+			THEN("train() refuses it instead of ignoring it")
+			{
+				REQUIRE_THROWS_AS(train(agent, std::move(env), config), std::invalid_argument);
+			}
+		}
+	}
+}
+
+SCENARIO("Every policy of a population trains as long as a single run", "[training]")
+{
+	GIVEN("A config of 3 updates, a single agent and a population of two")
+	{
+		const auto			config		 = tiny_config(3);
+		long				single_steps = 0;
+		long				first_steps	 = 0;
+		long				second_steps = 0;
+		CountingEnvironment shape(4, &single_steps);
+		Agent				single{&shape};
+		Agent				first{&shape};
+		Agent				second{&shape};
+
+		WHEN("both are trained on the same total_timesteps")
+		{
+			train(single, std::make_unique<CountingEnvironment>(4, &single_steps), config);
+			std::vector<std::unique_ptr<Environment>> envs;
+			envs.push_back(std::make_unique<CountingEnvironment>(4, &first_steps));
+			envs.push_back(std::make_unique<CountingEnvironment>(4, &second_steps));
+			train_population({&first, &second}, std::move(envs), config);
+
+			THEN("each policy collected as many rollouts as the single agent")
+			{
+				REQUIRE(single_steps == 3 * config.num_steps);
+				REQUIRE(first_steps == single_steps);
+				REQUIRE(second_steps == single_steps);
+			}
+		}
+	}
+}
@@ -0,0 +1,150 @@
+//
+// Created by chris on 10/18/26.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include <swarm/SwarmRenderer.hpp>
+#include <swarm/Trajectory.hpp>
+#include <stdexcept>
+#include <vector>
+
+// Step t of env i gets values derived from both, so every row can be checked after reading it back
+struct FakeSteps
+{
+	std::size_t				  num_envs;
+	std::size_t				  obs_size;
+	std::vector<float>		  observations = std::vector<float>(num_envs * obs_size);
+	std::vector<std::int64_t> actions	   = std::vector<std::int64_t>(num_envs);
+	std::vector<float>		  logprobs	   = std::vector<float>(num_envs);
+	std::vector<float>		  values	   = std::vector<float>(num_envs);
+	std::vector<float>		  rewards	   = std::vector<float>(num_envs);
+	std::vector<float>		  dones		   = std::vector<float>(num_envs);
+	std::vector<float>		  positions	   = std::vector<float>(4 * num_envs);
+
+	TrajectoryRow row(std::size_t t)
+	{
+		for (std::size_t i = 0; i < num_envs; i++)
+		{
+			for (std::size_t k = 0; k < obs_size; k++)
+			{
+				observations[i * obs_size + k] = static_cast<float>(t * 1000 + i * 10 + k);
+			}
+			actions[i]	= static_cast<std::int64_t>((t + i) % 4);
+			logprobs[i] = -static_cast<float>(t);
+			values[i]	= static_cast<float>(i);
+			rewards[i]	= static_cast<float>(t + i);
+			dones[i]	= (t + i) % 9 == 0 ? 1.0f : 0.0f;
+			for (std::size_t k = 0; k < 4; k++)
+			{
+				positions[4 * i + k] = static_cast<float>(t + k);
+			}
+		}
+		return {observations.data(), actions.data(),	logprobs.data(), values.data(),
+				rewards.data(),		 dones.data(),		positions.data()};
+	}
+};
+
+SCENARIO("TrajectoryRecorder streams steps that TrajectoryReader reads back", "[trajectory]")
+{
+	GIVEN("A recording of 1000 steps in chunks of 64, the last one partial")
+	{
+		const auto			  path	   = std::filesystem::temp_directory_path() / "swarm_trajectory_test.traj";
+		constexpr std::size_t num_envs = 7;
+		constexpr std::size_t obs_size = 5;
+		constexpr std::size_t steps	   = 1000;
+		FakeSteps			  fake{num_envs, obs_size};
+		{
+			TrajectoryRecorder recorder(path, num_envs, obs_size, true, 64);
+			for (std::size_t t = 0; t < steps; t++)
+			{
+				recorder.record(fake.row(t));
+			}
+			recorder.close();
+			REQUIRE(recorder.get_num_steps() == steps);
+			REQUIRE_THROWS_AS(recorder.record(fake.row(0)), std::runtime_error);
+		}
+		TrajectoryReader reader(path);
+
+		THEN("its shape matches what was recorded")
+		{
+			REQUIRE(reader.get_num_steps() == steps);
+			REQUIRE(reader.get_num_chunks() == 16);
+			REQUIRE(reader.get_num_envs() == num_envs);
+			REQUIRE(reader.get_observation_size() == obs_size);
+			REQUIRE(reader.has_positions());
+			REQUIRE(reader.chunk(15).num_steps == steps - 15 * 64);
+		}
+
+		THEN("any step can be read back exactly")
+		{
+			bool identical = true;
+			for (std::size_t t = 0; t < steps; t += 37)
+			{
+				const auto step = reader.step(t);
+				for (std::size_t i = 0; i < num_envs; i++)
+				{
+					identical &= step.observations[i * obs_size + 3] == static_cast<float>(t * 1000 + i * 10 + 3);
+					identical &= step.actions[i] == static_cast<std::int32_t>((t + i) % 4);
+					identical &= step.logprobs[i] == -static_cast<float>(t);
+					identical &= step.values[i] == static_cast<float>(i);
+					identical &= step.rewards[i] == static_cast<float>(t + i);
+					identical &= step.dones[i] == ((t + i) % 9 == 0);
+					identical &= step.positions[4 * i + 2] == static_cast<float>(t + 2);
+				}
+			}
+			REQUIRE(identical);
+			REQUIRE_THROWS_AS(reader.step(steps), std::invalid_argument);
+		}
+
+		THEN("a slice across chunks is split at chunk boundaries and covers every step once")
+		{
+			const auto	slices = reader.slice(50, 300);
+			std::size_t next   = 50;
+			bool		contiguous = true;
+			for (const auto& slice : slices)
+			{
+				contiguous &= slice.first_step == next;
+				contiguous &= slice.logprobs.front() == -static_cast<float>(slice.first_step);
+				contiguous &= slice.logprobs.back() == -static_cast<float>(slice.first_step + slice.num_steps - 1);
+				next += slice.num_steps;
+			}
+			REQUIRE(slices.size() == 6);
+			REQUIRE(contiguous);
+			REQUIRE(next == 350);
+		}
+
+		THEN("a step can be drawn from its positions")
+		{
+			SwarmSnapshot snapshot;
+			reader.write_snapshot(999, snapshot);
+			REQUIRE(snapshot.agents.size() == num_envs);
+			REQUIRE(snapshot.goals.size() == num_envs);
+			REQUIRE(snapshot.agents[3].x == 999.0f);
+			REQUIRE(snapshot.goals[3].y == 1002.0f);
+			REQUIRE(snapshot.tick == 999);
+		}
+	}
+
+	GIVEN("A recorder that is still writing")
+	{
+		const auto path = std::filesystem::temp_directory_path() / "swarm_trajectory_live_test.traj";
+		FakeSteps  fake{2, 3};
+		TrajectoryRecorder recorder(path, 2, 3, false, 16);
+		for (std::size_t t = 0; t < 40; t++)
+		{
+			recorder.record(fake.row(t));
+		}
+
+		WHEN("the recording is opened before it is closed")
+		{
+			TrajectoryReader reader(path);
+
+			THEN("it shows whole flushed chunks only")
+			{
+				REQUIRE(reader.get_num_steps() % 16 == 0);
+				REQUIRE(reader.get_num_steps() <= 32);
+				REQUIRE_FALSE(reader.has_positions());
+			}
+		}
+	}
+}